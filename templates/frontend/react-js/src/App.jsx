@@ -1,12 +1,14 @@
 import { useEffect, useState } from 'react'
 import './App.css'
 import reactLogo from './assets/react.svg'
+import { useQtProperty } from './qt-bindings.js'
 import { setupQtConnection } from './qwebchannel-bridge.js'
 import viteLogo from '/vite.svg'
 
 function App() {
-  const [count, setCount] = useState(0)
-  const [message, setMessage] = useState('')
+  // Only the parts of the page reading these re-render when they change
+  const count = useQtProperty('backend', 'count') ?? 0
+  const message = useQtProperty('backend', 'message') ?? ''
   const [backend, setBackend] = useState(null)
   const [connectionStatus, setConnectionStatus] = useState('Initializing...')
 
@@ -20,34 +22,6 @@ function App() {
         setConnectionStatus('Connected to backend ✓')
         console.log('✅ Successfully connected to backend')
 
-        // Get initial values
-        // Ensure properties exist before accessing, providing defaults
-        setCount(backendObj.count !== undefined ? backendObj.count : 0)
-        setMessage(backendObj.message !== undefined ? backendObj.message : '')
-        console.log('Initial values from backend:', {
-          count: backendObj.count,
-          message: backendObj.message,
-        })
-
-        // Connect to signals
-        if (backendObj.countChanged && typeof backendObj.countChanged.connect === 'function') {
-          backendObj.countChanged.connect(newCount => {
-            console.log('💬 Signal: countChanged received with value:', newCount)
-            setCount(newCount)
-          })
-        } else {
-          console.warn('Backend `countChanged` signal not available or not connectable.')
-        }
-
-        if (backendObj.messageChanged && typeof backendObj.messageChanged.connect === 'function') {
-          backendObj.messageChanged.connect(newMessage => {
-            console.log('💬 Signal: messageChanged received with value:', newMessage)
-            setMessage(newMessage)
-          })
-        } else {
-          console.warn('Backend `messageChanged` signal not available or not connectable.')
-        }
-        
         if (backendObj.sendToFrontend && typeof backendObj.sendToFrontend.connect === 'function') {
           backendObj.sendToFrontend.connect((text) => {
             console.log("💬 Signal: sendToFrontend received with:", text)
@@ -83,14 +57,9 @@ function App() {
         // Do NOT update count directly - wait for the countChanged signal
       } catch (err) {
         console.error('❌ Error calling incrementCount on backend:', err)
-        // Fallback to local increment if backend call fails
-        setCount(prevCount => prevCount + 1)
-        console.log('Fallback: incremented locally to', count + 1)
       }
     } else {
-      console.log('⚠️ No backend connection or incrementCount method unavailable, incrementing count locally')
-      setCount(prevCount => prevCount + 1)
-      console.log('Local count is now:', count + 1)
+      console.warn('⚠️ No backend connection or incrementCount method unavailable')
     }
   }
 
@@ -0,0 +1,28 @@
+import { useCallback, useSyncExternalStore } from 'react'
+import { readProperty, subscribeProperty } from './qwebchannel-bridge.js'
+
+/**
+ * A backend property as React state.
+ * Only components reading the property (or, with `key`, that key of it)
+ * re-render when it changes, and all of them share one subscription to its
+ * notify signal. Undefined until the bridge has connected.
+ *
+ *   const count = useQtProperty('backend', 'count') ?? 0
+ *   const theme = useQtProperty('settings', 'values', { key: 'theme' })
+ *
+ * @param {string} objectName Object registered on the channel
+ * @param {string} property Property name
+ * @param {{key?: string, signal?: string}} [options]
+ */
+export function useQtProperty(objectName, property, options = {}) {
+  const { key, signal } = options
+  const subscribe = useCallback(
+    onChange => subscribeProperty(objectName, property, onChange, { key, signal }),
+    [objectName, property, key, signal]
+  )
+  const getSnapshot = useCallback(
+    () => readProperty(objectName, property, key),
+    [objectName, property, key]
+  )
+  return useSyncExternalStore(subscribe, getSnapshot)
+}
@@ -2,22 +2,20 @@ import * as React from 'react'
 import { useEffect, useState } from 'react'
 import './App.css'
 import reactLogo from './assets/react.svg'
+import { useQtProperty } from './qt-bindings'
 import { setupQtConnection } from './qwebchannel-bridge'
 import viteLogo from '/vite.svg'
 
 type BackendType = {
-  count?: number
-  message?: string
-  countChanged?: { connect: (cb: (newCount: number) => void) => void }
-  messageChanged?: { connect: (cb: (newMessage: string) => void) => void }
   sendToFrontend?: { connect: (cb: (text: string) => void) => void }
   sendToBackend?: (msg: string) => void
   incrementCount?: () => void
 }
 
 function App() {
-  const [count, setCount] = useState<number>(0)
-  const [message, setMessage] = useState<string>('')
+  // Only the parts of the page reading these re-render when they change
+  const count = useQtProperty<number>('backend', 'count') ?? 0
+  const message = useQtProperty<string>('backend', 'message') ?? ''
   const [backend, setBackend] = useState<BackendType | null>(null)
   const [connectionStatus, setConnectionStatus] = useState<string>('Initializing...')
 
@@ -31,34 +29,6 @@ function App() {
         setConnectionStatus('Connected to backend ✓')
         console.log('✅ Successfully connected to backend')
 
-        // Get initial values
-        // Ensure properties exist before accessing, providing defaults
-        setCount(backendObj.count !== undefined ? backendObj.count : 0)
-        setMessage(backendObj.message !== undefined ? backendObj.message : '')
-        console.log('Initial values from backend:', {
-          count: backendObj.count,
-          message: backendObj.message,
-        })
-
-        // Connect to signals
-        if (backendObj.countChanged && typeof backendObj.countChanged.connect === 'function') {
-          backendObj.countChanged.connect(newCount => {
-            console.log('💬 Signal: countChanged received with value:', newCount)
-            setCount(newCount)
-          })
-        } else {
-          console.warn('Backend `countChanged` signal not available or not connectable.')
-        }
-
-        if (backendObj.messageChanged && typeof backendObj.messageChanged.connect === 'function') {
-          backendObj.messageChanged.connect(newMessage => {
-            console.log('💬 Signal: messageChanged received with value:', newMessage)
-            setMessage(newMessage)
-          })
-        } else {
-          console.warn('Backend `messageChanged` signal not available or not connectable.')
-        }
-        
         if (backendObj.sendToFrontend && typeof backendObj.sendToFrontend.connect === 'function') {
           backendObj.sendToFrontend.connect((text) => {
             console.log("💬 Signal: sendToFrontend received with:", text)
@@ -94,14 +64,9 @@ function App() {
         // Do NOT update count directly - wait for the countChanged signal
       } catch (err) {
         console.error('❌ Error calling incrementCount on backend:', err)
-        // Fallback to local increment if backend call fails
-        setCount(prevCount => prevCount + 1)
-        console.log('Fallback: incremented locally to', count + 1)
       }
     } else {
-      console.log('⚠️ No backend connection or incrementCount method unavailable, incrementing count locally')
-      setCount(prevCount => prevCount + 1)
-      console.log('Local count is now:', count + 1)
+      console.warn('⚠️ No backend connection or incrementCount method unavailable')
     }
   }
 
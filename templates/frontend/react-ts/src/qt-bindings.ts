@@ -0,0 +1,24 @@
+import { useCallback, useSyncExternalStore } from 'react'
+import { readProperty, subscribeProperty, type BindingOptions } from './qwebchannel-bridge'
+
+/**
+ * A backend property as React state.
+ * Only components reading the property (or, with `key`, that key of it)
+ * re-render when it changes, and all of them share one subscription to its
+ * notify signal. Undefined until the bridge has connected.
+ *
+ *   const count = useQtProperty<number>('backend', 'count') ?? 0
+ *   const theme = useQtProperty<string>('settings', 'values', { key: 'theme' })
+ */
+export function useQtProperty<T = any>(objectName: string, property: string, options: BindingOptions = {}): T | undefined {
+  const { key, signal } = options
+  const subscribe = useCallback(
+    (onChange: () => void) => subscribeProperty(objectName, property, onChange, { key, signal }),
+    [objectName, property, key, signal]
+  )
+  const getSnapshot = useCallback(
+    () => readProperty<T>(objectName, property, key),
+    [objectName, property, key]
+  )
+  return useSyncExternalStore(subscribe, getSnapshot)
+}
@@ -4,6 +4,11 @@ import react from '@vitejs/plugin-react'
 // https://vite.dev/config/
 export default defineConfig({
   base: './',
+
+  // The C++ side reads the manifest to prefetch route chunks
+  build: {
+    manifest: true,
+  },
   
   plugins: [react()],
 })
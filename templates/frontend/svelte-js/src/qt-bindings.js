@@ -0,0 +1,33 @@
+import { readable } from 'svelte/store';
+import { readProperty, subscribeProperty } from './qwebchannel-bridge.js';
+
+// One store per property and key, shared by every component using it
+const stores = new Map();
+
+/**
+ * A backend property as a readable store.
+ * Only subscribers of the property (or, with `key`, that key of it) are
+ * updated when it changes. The store holds one subscription to the notify
+ * signal while it has subscribers. Undefined until the bridge has connected.
+ *
+ *   const count = qtProperty('backend', 'count');  // {$count} in markup
+ *   const theme = qtProperty('settings', 'values', { key: 'theme' });
+ *
+ * @param {string} objectName Object registered on the channel
+ * @param {string} property Property name
+ * @param {{key?: string, signal?: string}} [options]
+ * @returns {import('svelte/store').Readable<any>}
+ */
+export function qtProperty(objectName, property, options = {}) {
+  const id = JSON.stringify([objectName, property, options.key, options.signal]);
+  let store = stores.get(id);
+  if (!store) {
+    const read = () => readProperty(objectName, property, options.key);
+    store = readable(read(), set => {
+      set(read());
+      return subscribeProperty(objectName, property, () => set(read()), options);
+    });
+    stores.set(id, store);
+  }
+  return store;
+}
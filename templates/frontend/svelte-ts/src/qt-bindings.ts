@@ -0,0 +1,34 @@
+import { readable, type Readable } from 'svelte/store';
+import { readProperty, subscribeProperty } from './qwebchannel-bridge.js';
+
+type BindingOptions = { key?: string; signal?: string };
+
+// One store per property and key, shared by every component using it
+const stores = new Map<string, Readable<any>>();
+
+/**
+ * A backend property as a readable store.
+ * Only subscribers of the property (or, with `key`, that key of it) are
+ * updated when it changes. The store holds one subscription to the notify
+ * signal while it has subscribers. Undefined until the bridge has connected.
+ *
+ *   const count = qtProperty<number>('backend', 'count');  // {$count} in markup
+ *   const theme = qtProperty<string>('settings', 'values', { key: 'theme' });
+ */
+export function qtProperty<T = any>(
+  objectName: string,
+  property: string,
+  options: BindingOptions = {}
+): Readable<T | undefined> {
+  const id = JSON.stringify([objectName, property, options.key, options.signal]);
+  let store = stores.get(id);
+  if (!store) {
+    const read = () => readProperty(objectName, property, options.key) as T | undefined;
+    store = readable(read(), set => {
+      set(read());
+      return subscribeProperty(objectName, property, () => set(read()), options);
+    });
+    stores.set(id, store);
+  }
+  return store;
+}
@@ -0,0 +1,27 @@
+import { getCurrentScope, onScopeDispose, shallowRef } from 'vue'
+import { readProperty, subscribeProperty } from './qwebchannel-bridge.js'
+
+/**
+ * A backend property as a shallow ref.
+ * Only effects reading the ref depend on the property (or, with `key`, that
+ * key of it), and all refs of one property share one subscription to its
+ * notify signal. The subscription ends with the component's scope.
+ * Undefined until the bridge has connected.
+ *
+ *   const count = useQtProperty('backend', 'count')
+ *   const theme = useQtProperty('settings', 'values', { key: 'theme' })
+ *
+ * @param {string} objectName Object registered on the channel
+ * @param {string} property Property name
+ * @param {{key?: string, signal?: string}} [options]
+ */
+export function useQtProperty(objectName, property, options = {}) {
+  const value = shallowRef(readProperty(objectName, property, options.key))
+  const unsubscribe = subscribeProperty(objectName, property, () => {
+    value.value = readProperty(objectName, property, options.key)
+  }, options)
+  if (getCurrentScope()) {
+    onScopeDispose(unsubscribe)
+  }
+  return value
+}
@@ -11,6 +11,7 @@ export default defineConfig({
   
   // Make sure assets are properly bundled
   build: {
+    manifest: true, // Read by the C++ side to prefetch route chunks
     assetsInlineLimit: 0, // Don't inline assets as base64
     rollupOptions: {
       output: {
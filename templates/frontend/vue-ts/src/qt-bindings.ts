@@ -0,0 +1,27 @@
+import { getCurrentScope, onScopeDispose, shallowRef, type ShallowRef } from 'vue'
+import { readProperty, subscribeProperty, type BindingOptions } from './qwebchannel-bridge'
+
+/**
+ * A backend property as a shallow ref.
+ * Only effects reading the ref depend on the property (or, with `key`, that
+ * key of it), and all refs of one property share one subscription to its
+ * notify signal. The subscription ends with the component's scope.
+ * Undefined until the bridge has connected.
+ *
+ *   const count = useQtProperty<number>('backend', 'count')
+ *   const theme = useQtProperty<string>('settings', 'values', { key: 'theme' })
+ */
+export function useQtProperty<T = any>(
+  objectName: string,
+  property: string,
+  options: BindingOptions = {}
+): Readonly<ShallowRef<T | undefined>> {
+  const value = shallowRef(readProperty<T>(objectName, property, options.key))
+  const unsubscribe = subscribeProperty(objectName, property, () => {
+    value.value = readProperty<T>(objectName, property, options.key)
+  }, options)
+  if (getCurrentScope()) {
+    onScopeDispose(unsubscribe)
+  }
+  return value
+}
@@ -27,6 +27,7 @@ declare global {
       webChannelTransport?: any;
     };
     QWebChannel?: any;
+    TAQYON_BRIDGE_WS?: string;
   }
 }
 
@@ -88,6 +89,9 @@ class MockQWebChannel {
   }
 }
 
+// Channel of the live Qt connection, kept so helpers can reach other published objects
+let qtChannel: any = null;
+
 /**
  * Setup Qt/QWebChannel connectivity
  * Handles both real Qt connections and fallback to development mode
@@ -108,16 +112,22 @@ export function setupQtConnection(): Promise<any> {
       }
     };
 
+    const connected = (backend: any) => {
+      cleanup();
+      console.log('✅ Successfully connected to Qt backend');
+      if (!interactiveDeferred) {
+        // Once the UI has rendered with the backend connected
+        requestAnimationFrame(() => requestAnimationFrame(markInteractive));
+      }
+      resolve(backend);
+    };
+
     const attemptConnection = () => {
       attemptCount++;
       console.log(`Attempt ${attemptCount}/${maxAttempts} to connect to Qt backend...`);
 
       tryQtConnection()
-        .then(backend => {
-          cleanup();
-          console.log('✅ Successfully connected to Qt backend');
-          resolve(backend);
-        })
+        .then(connected)
         .catch(error => {
           console.warn(`Connection attempt ${attemptCount} failed:`, error.message);
           if (attemptCount < maxAttempts) {
@@ -135,10 +145,289 @@ export function setupQtConnection(): Promise<any> {
       setupDevMode(resolve);
     }, 15000);
 
-    attemptConnection();
+    if (runningInQt()) {
+      attemptConnection();
+    } else if (!webSocketBridgeRequested()) {
+      cleanup();
+      setupDevMode(resolve);
+    } else {
+      // A standalone browser: the real backend if the app serves it with
+      // --bridge-websocket, otherwise the mock
+      tryWebSocketConnection()
+        .then(connected)
+        .catch(error => {
+          cleanup();
+          console.warn(`⚠️ ${error.message}, falling back to development mode`);
+          setupDevMode(resolve);
+        });
+    }
   });
 }
 
+// Recorder of the channel traffic, set when C++ runs with --record-bridge
+let transportRecorder: { attach: (object: any) => void } | null = null;
+
+/**
+ * Wrap qt.webChannelTransport according to window.__TAQYON_TRANSPORT__,
+ * which C++ injects for recording and testing modes
+ */
+function createTransport(transport: any): any {
+  const config = (window as any).__TAQYON_TRANSPORT__;
+  if (!config) {
+    return transport;
+  }
+  let wrapped = transport;
+  if (config.conditions) {
+    wrapped = conditionedTransport(wrapped, config.conditions);
+  }
+  // Outermost, so the recording shows what the page experienced
+  if (config.record) {
+    wrapped = recordingTransport(wrapped);
+  }
+  return wrapped;
+}
+
+// QWebChannel method calls (6) and replies (10) do not depend on each other's order
+const INDEPENDENT_MESSAGE_TYPES = [6, 10];
+
+/**
+ * Deliver messages in both directions with the simulated latency, jitter,
+ * reordering and bandwidth cap of window.__TAQYON_TRANSPORT__.conditions.
+ * Only method calls and replies are reordered, among themselves; signals and
+ * property updates keep their order.
+ */
+function conditionedTransport(inner: any, conditions: any): any {
+  const { latencyMs = 0, jitterMs = 0, reorderProbability = 0, bandwidthKBps = 0 } = conditions;
+  const bytesPerMs = bandwidthKBps * 1.024;
+
+  const createLink = (deliver: (payload: any) => void) => {
+    const queue: { at: number; payload: any }[] = [];
+    let timer: ReturnType<typeof setTimeout> | null = null;
+    let linkFreeAt = 0;
+    let lastInOrder = 0;
+    let lastOrdered = 0;
+    let lastHeld = 0;
+
+    const pump = () => {
+      timer = null;
+      const now = performance.now();
+      while (queue.length && queue[0].at <= now) {
+        deliver(queue.shift().payload);
+      }
+      if (queue.length) {
+        timer = setTimeout(pump, queue[0].at - now);
+      }
+    };
+
+    return (payload: any, data: any) => {
+      const now = performance.now();
+      const text = typeof data === 'string' ? data : JSON.stringify(data);
+      let at = now;
+      if (bytesPerMs > 0) {
+        linkFreeAt = Math.max(now, linkFreeAt) + text.length / bytesPerMs;
+        at = linkFreeAt;
+      }
+      at += Math.max(0, latencyMs + (Math.random() * 2 - 1) * jitterMs);
+
+      const independent = INDEPENDENT_MESSAGE_TYPES.includes(JSON.parse(text).type);
+      if (independent && Math.random() < reorderProbability) {
+        // Held back so that later calls or replies overtake it
+        at = Math.max(at + Math.random() * 2 * (latencyMs + jitterMs + 10), lastOrdered);
+        lastHeld = Math.max(lastHeld, at);
+      } else if (independent) {
+        at = Math.max(at, lastInOrder);
+        lastInOrder = at;
+      } else {
+        at = Math.max(at, lastInOrder, lastHeld);
+        lastInOrder = at;
+        lastOrdered = at;
+      }
+
+      let index = queue.length;
+      while (index > 0 && queue[index - 1].at > at) {
+        index--;
+      }
+      queue.splice(index, 0, { at, payload });
+      if (timer !== null) {
+        clearTimeout(timer);
+      }
+      timer = setTimeout(pump, Math.max(0, queue[0].at - now));
+    };
+  };
+
+  const wrapped: any = {
+    onmessage: null,
+    send: null,
+  };
+  const toBackend = createLink((data: any) => inner.send(data));
+  const toPage = createLink((message: any) => {
+    if (wrapped.onmessage) {
+      wrapped.onmessage(message);
+    }
+  });
+  wrapped.send = (data: any) => toBackend(data, data);
+  inner.onmessage = (message: any) => toPage(message, message.data);
+  console.info('[Taqyon] Simulated bridge conditions:', conditions);
+  return wrapped;
+}
+
+/**
+ * Record both directions of the channel traffic with epoch timestamps.
+ * Batches go to the C++ "bridgeRecorder" object once it is available;
+ * messages of those batches are left out of the recording.
+ */
+function recordingTransport(inner: any): any {
+  const records: [number, number, string][] = [];
+  const ownIds = new Set();
+  let sendingBatch = false;
+  let recorder: any = null;
+  const now = () => performance.timeOrigin + performance.now();
+  const text = (data: any): string => (typeof data === 'string' ? data : JSON.stringify(data));
+
+  const flush = () => {
+    if (!recorder || !records.length) {
+      return;
+    }
+    sendingBatch = true;
+    try {
+      recorder.appendRecords(records.splice(0, records.length));
+    } finally {
+      sendingBatch = false;
+    }
+  };
+  transportRecorder = {
+    attach(object: any) {
+      recorder = object;
+      flush();
+      setInterval(flush, 1000);
+      window.addEventListener('pagehide', flush);
+    },
+  };
+
+  const wrapped: any = {
+    onmessage: null,
+    send(data: any) {
+      if (sendingBatch) {
+        ownIds.add(JSON.parse(text(data)).id);
+      } else {
+        records.push([now(), 0, text(data)]);
+      }
+      inner.send(data);
+    },
+  };
+  inner.onmessage = (message: any) => {
+    const data = text(message.data);
+    if (!(ownIds.size && ownIds.delete(JSON.parse(data).id))) {
+      records.push([now(), 1, data]);
+    }
+    if (wrapped.onmessage) {
+      wrapped.onmessage(message);
+    }
+  };
+  return wrapped;
+}
+
+/**
+ * Keep a connected channel for the helpers and hand out its backend object
+ */
+function adoptChannel(channel: any): any {
+  qtChannel = channel;
+  attachBindings(channel.objects);
+  if (transportRecorder && channel.objects.bridgeRecorder) {
+    transportRecorder.attach(channel.objects.bridgeRecorder);
+  }
+  return channel.objects.backend;
+}
+
+// Where --bridge-websocket listens by default
+const DEFAULT_BRIDGE_WEBSOCKET = 'ws://127.0.0.1:12345';
+
+// Set once Qt's qwebchannel.js has been loaded from the app's WebSocket port
+let webSocketLibraryLoaded = false;
+
+function runningInQt(): boolean {
+  return Boolean(window.qt && window.qt.webChannelTransport) || navigator.userAgent.includes('QtWebEngine');
+}
+
+// The port also serves the script loaded into the page, so only this machine is trusted
+const LOOPBACK_HOSTS = ['127.0.0.1', 'localhost', '[::1]'];
+
+/**
+ * The app's channel WebSocket: ?taqyon-bridge=ws://host:port in the page
+ * URL, window.TAQYON_BRIDGE_WS, or the default port of --bridge-websocket.
+ * Null unless it is a ws:// URL on a loopback host.
+ */
+function bridgeWebSocketUrl(): string | null {
+  const requested = new URLSearchParams(window.location.search).get('taqyon-bridge')
+    || window.TAQYON_BRIDGE_WS
+    || DEFAULT_BRIDGE_WEBSOCKET;
+  let url;
+  try {
+    url = new URL(requested);
+  } catch (e) {
+    return null;
+  }
+  if (url.protocol !== 'ws:' || !LOOPBACK_HOSTS.includes(url.hostname)) {
+    return null;
+  }
+  return `ws://${url.host}`;
+}
+
+/**
+ * Whether a standalone browser should look for the app's WebSocket: in dev
+ * builds, or when the page asks for it with ?taqyon-bridge or
+ * window.TAQYON_BRIDGE_WS
+ */
+function webSocketBridgeRequested(): boolean {
+  const devBuild = Boolean((import.meta as any).env && (import.meta as any).env.DEV);
+  return devBuild
+    || new URLSearchParams(window.location.search).has('taqyon-bridge')
+    || Boolean(window.TAQYON_BRIDGE_WS);
+}
+
+function loadScript(src: string): Promise<void> {
+  return new Promise((resolve, reject) => {
+    const script = document.createElement('script');
+    script.src = src;
+    script.onload = () => resolve();
+    script.onerror = () => reject(new Error(`Could not load ${src}`));
+    document.head.appendChild(script);
+  });
+}
+
+/**
+ * Connect a standalone browser (the dev server opened in Chrome or Firefox)
+ * to the running app's backend over the WebSocket it serves with
+ * --bridge-websocket. The same port serves Qt's qwebchannel.js, which is
+ * otherwise only available inside Qt.
+ */
+function tryWebSocketConnection(): Promise<any> {
+  const url = bridgeWebSocketUrl();
+  if (!url) {
+    return Promise.reject(new Error('The bridge WebSocket must be a ws:// URL on 127.0.0.1, localhost or [::1]'));
+  }
+  const library = window.QWebChannel
+    ? Promise.resolve()
+    : loadScript(`${url.replace(/^ws/, 'http')}/qwebchannel.js`).then(() => {
+      webSocketLibraryLoaded = true;
+    });
+  return library.then(() => new Promise((resolve, reject) => {
+    const socket = new WebSocket(url);
+    socket.onerror = () => reject(new Error(`No backend WebSocket at ${url}`));
+    socket.onclose = () => console.warn('⚠️ Backend WebSocket closed');
+    socket.onopen = () => {
+      console.log('Connected to backend WebSocket at', url);
+      new window.QWebChannel(socket, (channel: any) => {
+        if (channel.objects && channel.objects.backend) {
+          resolve(adoptChannel(channel));
+        } else {
+          reject(new Error('Backend object not found in QWebChannel'));
+        }
+      });
+    };
+  }));
+}
+
 function tryQtConnection(): Promise<any> {
   return new Promise((resolve, reject) => {
     if (typeof window.QWebChannel === 'undefined') {
@@ -162,7 +451,7 @@ function tryQtConnection(): Promise<any> {
     try {
       console.log('Attempting QWebChannel connection with transport:', window.qt.webChannelTransport);
 
-      new window.QWebChannel(window.qt.webChannelTransport, (channel: any) => {
+      new window.QWebChannel(createTransport(window.qt.webChannelTransport), (channel: any) => {
         if (channel.objects && channel.objects.backend) {
           try {
             const backendType = typeof channel.objects.backend.incrementCount;
@@ -172,7 +461,7 @@ function tryQtConnection(): Promise<any> {
               return reject(new Error('Backend object does not have an incrementCount function'));
             }
 
-            resolve(channel.objects.backend);
+            resolve(adoptChannel(channel));
           } catch (err: any) {
             reject(new Error('Error accessing backend methods: ' + err.message));
           }
@@ -198,12 +487,485 @@ function setupDevMode(resolve: (backend: BackendMock) => void) {
     };
   }
 
-  if (!window.QWebChannel) {
+  // Qt's client library, loaded for --bridge-websocket, cannot drive the mock transport
+  if (!window.QWebChannel || webSocketLibraryLoaded) {
     window.QWebChannel = MockQWebChannel;
   }
 
   new window.QWebChannel(window.qt.webChannelTransport, (channel: { objects: { backend: BackendMock } }) => {
     console.log('🔄 Development mode initialized with mock backend');
+    attachBindings(channel.objects);
     resolve(channel.objects.backend);
   });
-}
\ No newline at end of file
+}
+
+/**
+ * Get another object published on the Qt channel (e.g. 'prefetch').
+ * Returns null when not connected to a real Qt backend.
+ */
+export function getQtObject(name: string): any {
+  return qtChannel && qtChannel.objects ? qtChannel.objects[name] || null : null;
+}
+
+let interactiveDeferred = false;
+let interactiveMarked = false;
+
+/**
+ * Keep the startup splash up until markInteractive() is called, instead of
+ * removing it once the channel is connected. Call before setupQtConnection(),
+ * e.g. when the first screen waits for data.
+ */
+export function deferInteractive(): void {
+  interactiveDeferred = true;
+}
+
+/**
+ * Tell the C++ side that the first screen is usable, so the startup splash
+ * cross-fades to the page.
+ */
+export function markInteractive(): void {
+  if (interactiveMarked) {
+    return;
+  }
+  const startup = getQtObject('startup');
+  if (startup && typeof startup.markInteractive === 'function') {
+    interactiveMarked = true;
+    startup.markInteractive();
+  }
+}
+
+export type PluginInfo = { name: string; description: string; file: string; loaded: boolean };
+
+// Plugin loads in flight or done, so each plugin is asked for once
+const pluginObjects = new Map<string, Promise<any>>();
+
+/**
+ * Backend plugins that can be loaded, read from their metadata. Listing
+ * them does not load any.
+ */
+export function listPlugins(): Promise<PluginInfo[]> {
+  const plugins = getQtObject('plugins');
+  if (!plugins) {
+    return Promise.resolve([]);
+  }
+  return new Promise(resolve => plugins.available(resolve));
+}
+
+type PluginTarget = { object: any; connections: [string, (...args: any[]) => void][] };
+
+// Current objects of loaded plugins, swapped when the C++ side hot-reloads one
+const pluginTargets = new Map<string, PluginTarget>();
+let pluginReloadsConnected = false;
+
+function onPluginReloaded(name: string, object: any): void {
+  const target = pluginTargets.get(name);
+  if (!target || !object) {
+    return;
+  }
+  target.object = object;
+  target.connections.forEach(([key, callback]) => object[key].connect(callback));
+  console.log(`🔄 Backend plugin ${name} reloaded`);
+  window.dispatchEvent(new CustomEvent('taqyon:plugin-reloaded', { detail: { name } }));
+}
+
+// Stands in for a plugin's object and forwards to its current version, so
+// the page's references and signal connections survive a hot reload
+function pluginFacade(plugins: any, name: string, object: any): any {
+  const target: PluginTarget = { object, connections: [] };
+  pluginTargets.set(name, target);
+  if (!pluginReloadsConnected && plugins.reloaded) {
+    plugins.reloaded.connect(onPluginReloaded);
+    pluginReloadsConnected = true;
+  }
+  return new Proxy({}, {
+    get(_, key: string) {
+      const value = target.object[key];
+      if (value && typeof value.connect === 'function') {
+        return {
+          connect(callback: (...args: any[]) => void) {
+            target.connections.push([key, callback]);
+            target.object[key].connect(callback);
+          },
+          disconnect(callback: (...args: any[]) => void) {
+            target.connections = target.connections.filter(([k, c]) => k !== key || c !== callback);
+            target.object[key].disconnect(callback);
+          },
+        };
+      }
+      return value;
+    },
+    set(_, key: string, value: any) {
+      target.object[key] = value;
+      return true;
+    },
+    has(_, key: string) {
+      return key in target.object;
+    },
+  });
+}
+
+/**
+ * Get a backend plugin's object, loading the plugin on first use. The
+ * object works like the ones on the channel: call its slots, read its
+ * properties and connect to its signals. Rejects when the plugin is unknown
+ * or fails to load.
+ * When the plugin is hot-reloaded (--hot-reload-plugins) the object follows
+ * the new version, and 'taqyon:plugin-reloaded' is dispatched on window.
+ */
+export function loadPlugin<T = any>(name: string): Promise<T> {
+  let pending = pluginObjects.get(name);
+  if (!pending) {
+    const plugins = getQtObject('plugins');
+    if (!plugins) {
+      return Promise.reject(new Error('Backend plugins need the Qt backend'));
+    }
+    pending = new Promise((resolve, reject) => {
+      plugins.load(name, (object: any) => {
+        if (object) {
+          resolve(pluginFacade(plugins, name, object));
+        } else {
+          pluginObjects.delete(name);
+          reject(new Error(`Plugin ${name} could not be loaded`));
+        }
+      });
+    });
+    pluginObjects.set(name, pending);
+  }
+  return pending;
+}
+
+/**
+ * Tell the C++ side which routes the user is likely to visit next, so their
+ * chunks are read into memory before navigation.
+ * Routes are manifest keys (e.g. 'src/pages/Settings.tsx') or chunk names.
+ */
+export function hintNextRoutes(routes: string[]): void {
+  const prefetch = getQtObject('prefetch');
+  if (prefetch && typeof prefetch.hintRoutes === 'function') {
+    prefetch.hintRoutes(routes);
+  }
+}
+
+type SessionState = { [key: string]: any };
+
+/**
+ * Session state restored by the C++ side from the previous run, if any:
+ * the last state sent with startSessionSnapshots().
+ */
+export function getRestoredSession(): SessionState | null {
+  return (window as any).__TAQYON_SESSION__ || null;
+}
+
+function isPlainObject(value: any): value is SessionState {
+  return value !== null && typeof value === 'object' && !Array.isArray(value);
+}
+
+// JSON merge patch (RFC 7396) turning previous into next, or undefined if equal
+function diffSnapshot(previous: any, next: any): any {
+  if (!isPlainObject(previous) || !isPlainObject(next)) {
+    return JSON.stringify(previous) === JSON.stringify(next) ? undefined : next;
+  }
+  const patch: SessionState = {};
+  let changed = false;
+  Object.keys(previous).forEach(key => {
+    if (!(key in next)) {
+      patch[key] = null;
+      changed = true;
+    }
+  });
+  Object.keys(next).forEach(key => {
+    const change = diffSnapshot(previous[key], next[key]);
+    if (change !== undefined) {
+      patch[key] = change;
+      changed = true;
+    }
+  });
+  return changed ? patch : undefined;
+}
+
+/**
+ * Periodically send the app's session state (route, scroll positions, loaded
+ * data...) to C++ so it survives restarts. Only what changed since the last
+ * snapshot is sent. Note that null values are treated as deletions.
+ *
+ * Returns a function that stops taking snapshots.
+ */
+export function startSessionSnapshots(
+  collect: () => SessionState,
+  options: { intervalMs?: number } = {}
+): () => void {
+  const intervalMs = options.intervalMs || 2000;
+  let previous: SessionState = getRestoredSession() || {};
+
+  const snapshot = () => {
+    const session = getQtObject('session');
+    if (!session || typeof session.applySnapshot !== 'function') {
+      return;
+    }
+    const next = JSON.parse(JSON.stringify(collect() || {}));
+    const patch = diffSnapshot(previous, next);
+    if (patch !== undefined) {
+      session.applySnapshot(patch);
+      previous = next;
+    }
+  };
+
+  const timer = setInterval(snapshot, intervalMs);
+  window.addEventListener('pagehide', snapshot);
+  document.addEventListener('visibilitychange', snapshot);
+  return () => {
+    clearInterval(timer);
+    window.removeEventListener('pagehide', snapshot);
+    document.removeEventListener('visibilitychange', snapshot);
+  };
+}
+
+/**
+ * Keep the native C++ plot `id` positioned over a placeholder element.
+ * The plot's data is fed from C++; only the element's geometry crosses the bridge.
+ * Returns a function that stops tracking and hides the plot.
+ */
+export function trackPlotPlaceholder(element: Element, id: string): () => void {
+  const plots = getQtObject('plots');
+  if (!plots || typeof plots.setPlotGeometry !== 'function') {
+    return () => {};
+  }
+  let frame = 0;
+  let lastGeometry = '';
+
+  const sync = () => {
+    frame = 0;
+    const rect = element.getBoundingClientRect();
+    const visible = document.visibilityState === 'visible'
+      && rect.width > 0 && rect.height > 0
+      && rect.bottom > 0 && rect.right > 0
+      && rect.top < window.innerHeight && rect.left < window.innerWidth;
+    const geometry = [rect.x, rect.y, rect.width, rect.height, visible].join(',');
+    if (geometry !== lastGeometry) {
+      lastGeometry = geometry;
+      plots.setPlotGeometry(id, rect.x, rect.y, rect.width, rect.height, visible);
+    }
+  };
+  // At most one geometry message per frame
+  const schedule = () => {
+    if (!frame) {
+      frame = requestAnimationFrame(sync);
+    }
+  };
+
+  const resizeObserver = new ResizeObserver(schedule);
+  resizeObserver.observe(element);
+  window.addEventListener('scroll', schedule, true);
+  window.addEventListener('resize', schedule);
+  document.addEventListener('visibilitychange', schedule);
+  schedule();
+
+  return () => {
+    resizeObserver.disconnect();
+    window.removeEventListener('scroll', schedule, true);
+    window.removeEventListener('resize', schedule);
+    document.removeEventListener('visibilitychange', schedule);
+    if (frame) {
+      cancelAnimationFrame(frame);
+    }
+    plots.setPlotGeometry(id, 0, 0, 0, 0, false);
+  };
+}
+
+/**
+ * Call a backend slot (or read a property) over fetch() instead of the web channel.
+ * Works in Web Workers, which cannot reach qt.webChannelTransport, so bulk
+ * results go from C++ to the worker without passing through the page's main thread.
+ * Slots returning QByteArray resolve to an ArrayBuffer.
+ */
+export async function callBackend<T = any>(
+  objectName: string,
+  name: string,
+  args: unknown[] = [],
+  options: { signal?: AbortSignal } = {}
+): Promise<T> {
+  const path = `taqyon://bridge/${encodeURIComponent(objectName)}/${encodeURIComponent(name)}`;
+  const encodedArgs = args.length ? JSON.stringify(args) : '';
+  // Short calls fit in the URL; POST bodies need Qt 6.7 on the C++ side.
+  // text/plain keeps the request simple, so no CORS preflight is sent.
+  const response = encodedArgs.length > 2000
+    ? await fetch(path, { method: 'POST', headers: { 'Content-Type': 'text/plain' }, body: encodedArgs, signal: options.signal })
+    : await fetch(encodedArgs ? `${path}?args=${encodeURIComponent(encodedArgs)}` : path, { signal: options.signal });
+  if (response.headers.get('Content-Type') === 'application/octet-stream') {
+    return (await response.arrayBuffer()) as T;
+  }
+  const reply = await response.json();
+  if ('error' in reply) {
+    throw new Error(`${objectName}.${name}: ${reply.error}`);
+  }
+  return reply.result;
+}
+
+/**
+ * fetch() a route of the C++ ApiRouter under taqyon://api.
+ * Resolves to a regular Response with the status set by the handler; the body
+ * can be streamed with response.body.getReader() as usual. Usable from workers.
+ */
+export async function apiFetch(path: string, init?: RequestInit): Promise<Response> {
+  const response = await fetch(`taqyon://api${path.startsWith('/') ? path : `/${path}`}`, init);
+  const status = Number(response.headers.get('X-Taqyon-Status'));
+  if (!status || status === response.status) {
+    return response;
+  }
+  // Custom scheme replies are always 200; restore the handler's status
+  const nullBody = [101, 204, 205, 304].includes(status);
+  return new Response(nullBody ? null : response.body, {
+    status,
+    statusText: response.statusText,
+    headers: response.headers,
+  });
+}
+
+type PropertyListener = () => void;
+
+export type BindingOptions = {
+  /** Key within an object-valued property (a QVariantMap in C++) */
+  key?: string;
+  /** Notify signal; defaults to `${property}Changed` */
+  signal?: string;
+};
+
+export type BindingStats = {
+  subscribers: number;
+  connections: number;
+  signals: number;
+  notifications: number;
+  skipped: number;
+};
+
+type BindingEntry = { key?: string; listener: PropertyListener; last: any };
+
+type PropertyHub = {
+  objectName: string;
+  property: string;
+  signalName: string;
+  object: any;
+  signal: any;
+  entries: Set<BindingEntry>;
+  handler: () => void;
+};
+
+// Property bindings: all subscribers of a property share one connection to
+// its notify signal, and only those whose value changed are called
+const signalHubs = new Map<string, PropertyHub>();
+const bindingStats: BindingStats = { subscribers: 0, connections: 0, signals: 0, notifications: 0, skipped: 0 };
+// Objects the bindings read from: the Qt channel's, or the mock's in development mode
+let bindingObjects: { [name: string]: any } | null = null;
+
+function bindingValue(value: any, key?: string): any {
+  if (key === undefined) {
+    return value;
+  }
+  return value !== null && typeof value === 'object' ? value[key] : undefined;
+}
+
+function attachHub(hub: PropertyHub): boolean {
+  const object = bindingObjects && bindingObjects[hub.objectName];
+  const signal = object && object[hub.signalName];
+  if (!signal || typeof signal.connect !== 'function') {
+    console.warn(`Binding: ${hub.objectName}.${hub.signalName} is not a signal; ${hub.property} will not update`);
+    return false;
+  }
+  hub.object = object;
+  hub.signal = signal;
+  signal.connect(hub.handler);
+  bindingStats.connections++;
+  return true;
+}
+
+function attachBindings(objects: { [name: string]: any }): void {
+  bindingObjects = objects;
+  signalHubs.forEach(hub => {
+    if (!hub.signal && attachHub(hub)) {
+      hub.handler();
+    }
+  });
+}
+
+/**
+ * Read a backend property, or one key of an object-valued property (a
+ * QVariantMap in C++). Undefined until the bridge has connected.
+ */
+export function readProperty<T = any>(objectName: string, property: string, key?: string): T | undefined {
+  const object = bindingObjects && bindingObjects[objectName];
+  return object ? bindingValue(object[property], key) : undefined;
+}
+
+/**
+ * Call `listener` when a backend property changes. With `key`, only changes
+ * to that key of the property's value are reported. Subscribing before the
+ * bridge connects is fine: listeners are called once the values arrive.
+ * The framework bindings (qt-bindings) are built on this.
+ * Returns an unsubscribe function; the signal is disconnected with the last
+ * subscriber.
+ */
+export function subscribeProperty(
+  objectName: string,
+  property: string,
+  listener: PropertyListener,
+  options: BindingOptions = {}
+): () => void {
+  const signalName = options.signal || `${property}Changed`;
+  const id = `${objectName}.${property}.${signalName}`;
+  let hub = signalHubs.get(id);
+  if (!hub) {
+    const created: PropertyHub = {
+      objectName, property, signalName, object: null, signal: null, entries: new Set(), handler: () => {},
+    };
+    created.handler = () => {
+      bindingStats.signals++;
+      const value = created.object[property];
+      created.entries.forEach(entry => {
+        const next = bindingValue(value, entry.key);
+        if (Object.is(next, entry.last)) {
+          bindingStats.skipped++;
+          return;
+        }
+        entry.last = next;
+        bindingStats.notifications++;
+        entry.listener();
+      });
+    };
+    signalHubs.set(id, created);
+    if (bindingObjects) {
+      attachHub(created);
+    }
+    hub = created;
+  }
+  const owner = hub;
+  const entry: BindingEntry = { key: options.key, listener, last: readProperty(objectName, property, options.key) };
+  owner.entries.add(entry);
+  bindingStats.subscribers++;
+
+  return () => {
+    if (!owner.entries.delete(entry)) {
+      return;
+    }
+    bindingStats.subscribers--;
+    if (owner.entries.size > 0) {
+      return;
+    }
+    if (!owner.signal) {
+      signalHubs.delete(id);
+    } else if (typeof owner.signal.disconnect === 'function') {
+      owner.signal.disconnect(owner.handler);
+      bindingStats.connections--;
+      signalHubs.delete(id);
+    }
+  };
+}
+
+/**
+ * Counters of the property bindings, for comparing how many listener calls
+ * (and so re-renders) an update causes: `signals` notify signals received,
+ * `notifications` listener calls and `skipped` listeners whose value did not
+ * change, over `connections` channel connections for `subscribers` subscribers.
+ */
+export function getBindingStats(): BindingStats {
+  return { ...bindingStats };
+}
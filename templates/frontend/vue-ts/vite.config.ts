@@ -7,6 +7,7 @@ export default defineConfig({
   plugins: [vue()],
   base: './',
   build: {
+    manifest: true,
     assetsInlineLimit: 0,
     rollupOptions: {
       output: {
@@ -0,0 +1,529 @@
+#include "allocationtracker.h"
+#include <QDebug>
+
+#if defined(TAQYON_ALLOCATION_TRACKING) && defined(__GLIBC__)
+#define TAQYON_ALLOCATION_HOOKS 1
+#endif
+
+#ifdef TAQYON_ALLOCATION_HOOKS
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QMetaMethod>
+#include <QMetaProperty>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QVector>
+#include <QWebChannel>
+#include <QWebChannelAbstractTransport>
+#include <private/qobject_p.h>
+#include <private/qmetaobject_p.h>
+#include <atomic>
+#include <cerrno>
+#include <malloc.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *pointer);
+}
+
+namespace {
+
+// Everything the allocation hooks touch is static, zero-initialized and
+// lock-free: the hooks run before main(), inside the dynamic loader and on
+// threads Qt does not know about.
+const int kMaxThreadSlots = 256;
+const int kMaxScopeDepth = 32;
+const int kMaxPublishedObjects = 64;
+
+struct ThreadSlot {
+    std::atomic<quint64> allocations;
+    std::atomic<quint64> bytes;
+    std::atomic<quint64> frees;
+    std::atomic<quint64> freedBytes;
+    std::atomic<long> threadId;
+};
+
+struct ScopeFrame {
+    int id;
+    int signalDepth;
+    quint64 allocations;
+    quint64 bytes;
+};
+
+ThreadSlot g_slots[kMaxThreadSlots];
+std::atomic<int> g_slotCount(0);
+std::atomic<bool> g_enabled(false);
+
+// Lock-free copy of the published objects, so the signal spy rejects every
+// other emission without the registry's lock. Only compared, never
+// dereferenced. A count of -1 means too many to copy: take the lock.
+std::atomic<QObject *> g_publishedObjects[kMaxPublishedObjects];
+std::atomic<int> g_publishedCount(0);
+
+thread_local int t_slot = -1;
+// Set while the tracker does its own bookkeeping, which is not counted
+thread_local bool t_inTracker = false;
+thread_local ScopeFrame t_scopes[kMaxScopeDepth];
+thread_local int t_scopeDepth = 0;
+thread_local int t_signalDepth = 0;
+
+ThreadSlot &currentSlot()
+{
+    if (t_slot < 0) {
+        int slot = g_slotCount.fetch_add(1, std::memory_order_relaxed);
+        if (slot >= kMaxThreadSlots - 1) {
+            slot = kMaxThreadSlots - 1; // Shared by every later thread
+        } else {
+            g_slots[slot].threadId.store(static_cast<long>(syscall(SYS_gettid)), std::memory_order_relaxed);
+        }
+        t_slot = slot;
+    }
+    return g_slots[t_slot];
+}
+
+inline void countAllocation(void *pointer)
+{
+    if (!pointer || !g_enabled.load(std::memory_order_relaxed) || t_inTracker) {
+        return;
+    }
+    ThreadSlot &slot = currentSlot();
+    slot.allocations.fetch_add(1, std::memory_order_relaxed);
+    slot.bytes.fetch_add(malloc_usable_size(pointer), std::memory_order_relaxed);
+}
+
+inline void countFree(void *pointer)
+{
+    if (!pointer || !g_enabled.load(std::memory_order_relaxed) || t_inTracker) {
+        return;
+    }
+    ThreadSlot &slot = currentSlot();
+    slot.frees.fetch_add(1, std::memory_order_relaxed);
+    slot.freedBytes.fetch_add(malloc_usable_size(pointer), std::memory_order_relaxed);
+}
+
+class TrackerGuard
+{
+public:
+    TrackerGuard() : m_outer(t_inTracker) { t_inTracker = true; }
+    ~TrackerGuard() { t_inTracker = m_outer; }
+
+private:
+    bool m_outer;
+};
+
+struct ScopeStats {
+    quint64 calls = 0;
+    quint64 allocations = 0;
+    quint64 bytes = 0;
+};
+
+// Scope names, published objects and per-scope totals; only used outside
+// the allocation hooks
+struct Registry {
+    QMutex mutex;
+    QHash<QByteArray, int> scopeIds;
+    QVector<QByteArray> scopeNames;
+    QVector<ScopeStats> scopeStats;
+    QList<QPointer<QWebChannel>> channels;
+    QHash<QString, QObject *> objectsByName;
+    QHash<QObject *, QString> namesByObject;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+void refreshPublishedObjects()
+{
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    reg.objectsByName.clear();
+    reg.namesByObject.clear();
+    for (const QPointer<QWebChannel> &channel : reg.channels) {
+        if (!channel) {
+            continue;
+        }
+        const QHash<QString, QObject *> objects = channel->registeredObjects();
+        for (auto it = objects.constBegin(); it != objects.constEnd(); ++it) {
+            reg.objectsByName.insert(it.key(), it.value());
+            reg.namesByObject.insert(it.value(), it.key());
+        }
+    }
+
+    g_publishedCount.store(0, std::memory_order_release);
+    if (reg.namesByObject.size() > kMaxPublishedObjects) {
+        g_publishedCount.store(-1, std::memory_order_release);
+        return;
+    }
+    int count = 0;
+    for (auto it = reg.namesByObject.constBegin(); it != reg.namesByObject.constEnd(); ++it) {
+        g_publishedObjects[count++].store(it.key(), std::memory_order_relaxed);
+    }
+    g_publishedCount.store(count, std::memory_order_release);
+}
+
+bool maybePublished(QObject *object)
+{
+    const int count = g_publishedCount.load(std::memory_order_acquire);
+    if (count < 0) {
+        return true;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (g_publishedObjects[i].load(std::memory_order_relaxed) == object) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The signal index (not the method index) of messageReceived, which
+// subclasses of the transport inherit unchanged
+int messageReceivedSignalIndex()
+{
+    static const int index = QMetaObjectPrivate::signalIndex(
+        QMetaMethod::fromSignal(&QWebChannelAbstractTransport::messageReceived));
+    return index;
+}
+
+void pushScope(const QByteArray &name, int signalDepth)
+{
+    int id;
+    {
+        Registry &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        auto it = reg.scopeIds.constFind(name);
+        if (it == reg.scopeIds.constEnd()) {
+            id = reg.scopeNames.size();
+            reg.scopeIds.insert(name, id);
+            reg.scopeNames.append(name);
+            reg.scopeStats.append(ScopeStats());
+        } else {
+            id = it.value();
+        }
+    }
+    if (t_scopeDepth < kMaxScopeDepth) {
+        const ThreadSlot &slot = currentSlot();
+        ScopeFrame &frame = t_scopes[t_scopeDepth];
+        frame.id = id;
+        frame.signalDepth = signalDepth;
+        frame.allocations = slot.allocations.load(std::memory_order_relaxed);
+        frame.bytes = slot.bytes.load(std::memory_order_relaxed);
+    }
+    ++t_scopeDepth;
+}
+
+void popScope()
+{
+    if (t_scopeDepth <= 0) {
+        return;
+    }
+    --t_scopeDepth;
+    if (t_scopeDepth >= kMaxScopeDepth) {
+        return;
+    }
+    const ThreadSlot &slot = currentSlot();
+    const ScopeFrame &frame = t_scopes[t_scopeDepth];
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    ScopeStats &stats = reg.scopeStats[frame.id];
+    ++stats.calls;
+    stats.allocations += slot.allocations.load(std::memory_order_relaxed) - frame.allocations;
+    stats.bytes += slot.bytes.load(std::memory_order_relaxed) - frame.bytes;
+}
+
+QByteArray channelScopeName(const QJsonObject &message)
+{
+    const int type = message.value(QStringLiteral("type")).toInt();
+    const QString objectName = message.value(QStringLiteral("object")).toString();
+    QObject *object = nullptr;
+    {
+        Registry &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        object = reg.objectsByName.value(objectName);
+    }
+    switch (type) {
+    case 3:
+        // Objects may have been published since the last handshake
+        refreshPublishedObjects();
+        return QByteArrayLiteral("channel init");
+    case 6: {
+        const QJsonValue method = message.value(QStringLiteral("method"));
+        QByteArray methodName = method.isString() ? method.toString().toUtf8() : QByteArray();
+        if (methodName.isEmpty() && object) {
+            methodName = object->metaObject()->method(method.toInt()).name();
+        }
+        return "channel invoke " + objectName.toUtf8() + '.' + methodName;
+    }
+    case 9: {
+        const int index = message.value(QStringLiteral("property")).toInt();
+        const QByteArray propertyName = object ? QByteArray(object->metaObject()->property(index).name()) : QByteArray::number(index);
+        return "channel setProperty " + objectName.toUtf8() + '.' + propertyName;
+    }
+    default:
+        return "channel message " + QByteArray::number(type);
+    }
+}
+
+void signalBegin(QObject *caller, int signalIndex, void **argv)
+{
+    ++t_signalDepth;
+    if (!g_enabled.load(std::memory_order_relaxed) || t_inTracker) {
+        return;
+    }
+    // Runs for every emission in the process: everything but channel
+    // messages and published objects is rejected without locking
+    const bool transportMessage = signalIndex == messageReceivedSignalIndex()
+                                  && qobject_cast<QWebChannelAbstractTransport *>(caller);
+    if (!transportMessage && !maybePublished(caller)) {
+        return;
+    }
+    TrackerGuard guard;
+    QByteArray name;
+    if (transportMessage) {
+        name = channelScopeName(*static_cast<const QJsonObject *>(argv[1]));
+    } else {
+        QString objectName;
+        {
+            Registry &reg = registry();
+            QMutexLocker locker(&reg.mutex);
+            objectName = reg.namesByObject.value(caller);
+        }
+        if (!objectName.isEmpty()) {
+            name = "signal " + objectName.toUtf8() + '.'
+                   + QMetaObjectPrivate::signal(caller->metaObject(), signalIndex).name();
+        }
+    }
+    if (!name.isEmpty()) {
+        pushScope(name, t_signalDepth);
+    }
+}
+
+void signalEnd(QObject *, int)
+{
+    if (t_scopeDepth > 0 && t_scopeDepth <= kMaxScopeDepth
+        && t_scopes[t_scopeDepth - 1].signalDepth == t_signalDepth) {
+        TrackerGuard guard;
+        popScope();
+    }
+    if (t_signalDepth > 0) {
+        --t_signalDepth;
+    }
+}
+
+QString threadName(long threadId)
+{
+    if (threadId == 0) {
+        return QStringLiteral("other threads");
+    }
+    QFile comm(QString("/proc/self/task/%1/comm").arg(threadId));
+    if (comm.open(QIODevice::ReadOnly)) {
+        return QString("%1 (%2)").arg(QString::fromUtf8(comm.readAll().trimmed())).arg(threadId);
+    }
+    return QString("exited (%1)").arg(threadId);
+}
+
+} // namespace
+
+// The interposed allocator. Definitions in the executable take precedence
+// over glibc's for every library in the process.
+extern "C" {
+
+void *malloc(size_t size)
+{
+    void *pointer = __libc_malloc(size);
+    countAllocation(pointer);
+    return pointer;
+}
+
+void *calloc(size_t count, size_t size)
+{
+    void *pointer = __libc_calloc(count, size);
+    countAllocation(pointer);
+    return pointer;
+}
+
+void *realloc(void *old, size_t size)
+{
+    countFree(old);
+    void *pointer = __libc_realloc(old, size);
+    countAllocation(pointer);
+    return pointer;
+}
+
+void free(void *pointer)
+{
+    countFree(pointer);
+    __libc_free(pointer);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    void *pointer = __libc_memalign(alignment, size);
+    countAllocation(pointer);
+    return pointer;
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void **result, size_t alignment, size_t size)
+{
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void *pointer = memalign(alignment, size);
+    if (!pointer) {
+        return ENOMEM;
+    }
+    *result = pointer;
+    return 0;
+}
+
+} // extern "C"
+#endif // TAQYON_ALLOCATION_HOOKS
+
+bool AllocationTracker::isAvailable()
+{
+#ifdef TAQYON_ALLOCATION_HOOKS
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool AllocationTracker::isEnabled()
+{
+#ifdef TAQYON_ALLOCATION_HOOKS
+    return g_enabled.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+}
+
+bool AllocationTracker::enable()
+{
+#ifdef TAQYON_ALLOCATION_HOOKS
+    if (g_enabled.load()) {
+        return true;
+    }
+    static QSignalSpyCallbackSet callbacks = { signalBegin, nullptr, signalEnd, nullptr };
+    qt_register_signal_spy_callbacks(&callbacks);
+    g_enabled.store(true);
+    qInfo() << "AllocationTracker: counting allocations";
+    return true;
+#else
+    qWarning() << "AllocationTracker: not available; configure with -DTAQYON_ALLOCATION_TRACKING=ON (Linux only)";
+    return false;
+#endif
+}
+
+void AllocationTracker::trackChannel(QWebChannel *channel)
+{
+#ifdef TAQYON_ALLOCATION_HOOKS
+    {
+        TrackerGuard guard;
+        Registry &reg = registry();
+        QMutexLocker locker(&reg.mutex);
+        reg.channels.append(channel);
+    }
+    TrackerGuard guard;
+    refreshPublishedObjects();
+#else
+    Q_UNUSED(channel);
+#endif
+}
+
+AllocationTracker::Counters AllocationTracker::currentThread()
+{
+    Counters counters;
+#ifdef TAQYON_ALLOCATION_HOOKS
+    const ThreadSlot &slot = currentSlot();
+    counters.allocations = slot.allocations.load(std::memory_order_relaxed);
+    counters.bytes = slot.bytes.load(std::memory_order_relaxed);
+    counters.frees = slot.frees.load(std::memory_order_relaxed);
+    counters.freedBytes = slot.freedBytes.load(std::memory_order_relaxed);
+#endif
+    return counters;
+}
+
+QJsonObject AllocationTracker::snapshot()
+{
+    QJsonObject object;
+#ifdef TAQYON_ALLOCATION_HOOKS
+    TrackerGuard guard;
+    object.insert(QStringLiteral("enabled"), g_enabled.load());
+
+    QJsonObject threads;
+    const int slotCount = qMin(g_slotCount.load(), kMaxThreadSlots);
+    for (int i = 0; i < slotCount; ++i) {
+        const ThreadSlot &slot = g_slots[i];
+        const quint64 allocations = slot.allocations.load(std::memory_order_relaxed);
+        if (allocations == 0) {
+            continue;
+        }
+        const qint64 bytes = qint64(slot.bytes.load(std::memory_order_relaxed));
+        const qint64 freedBytes = qint64(slot.freedBytes.load(std::memory_order_relaxed));
+        QJsonObject thread;
+        thread.insert(QStringLiteral("allocations"), qint64(allocations));
+        thread.insert(QStringLiteral("bytes"), bytes);
+        thread.insert(QStringLiteral("frees"), qint64(slot.frees.load(std::memory_order_relaxed)));
+        thread.insert(QStringLiteral("freedBytes"), freedBytes);
+        // Memory freed on another thread than it was allocated on makes this
+        // negative for some threads; the sum over threads is meaningful
+        thread.insert(QStringLiteral("netBytes"), bytes - freedBytes);
+        threads.insert(threadName(slot.threadId.load(std::memory_order_relaxed)), thread);
+    }
+    object.insert(QStringLiteral("threads"), threads);
+
+    QJsonObject scopes;
+    Registry &reg = registry();
+    QMutexLocker locker(&reg.mutex);
+    for (int id = 0; id < reg.scopeNames.size(); ++id) {
+        const ScopeStats &stats = reg.scopeStats.at(id);
+        if (stats.calls == 0) {
+            continue;
+        }
+        QJsonObject scope;
+        scope.insert(QStringLiteral("calls"), qint64(stats.calls));
+        scope.insert(QStringLiteral("allocations"), qint64(stats.allocations));
+        scope.insert(QStringLiteral("bytes"), qint64(stats.bytes));
+        scope.insert(QStringLiteral("allocationsPerCall"), double(stats.allocations) / stats.calls);
+        scope.insert(QStringLiteral("bytesPerCall"), double(stats.bytes) / stats.calls);
+        scopes.insert(QString::fromUtf8(reg.scopeNames.at(id)), scope);
+    }
+    object.insert(QStringLiteral("scopes"), scopes);
+#else
+    object.insert(QStringLiteral("enabled"), false);
+#endif
+    return object;
+}
+
+void AllocationTracker::enterScope(const QByteArray &name)
+{
+#ifdef TAQYON_ALLOCATION_HOOKS
+    TrackerGuard guard;
+    // Not tied to a signal emission
+    pushScope(name, -1);
+#else
+    Q_UNUSED(name);
+#endif
+}
+
+void AllocationTracker::leaveScope()
+{
+#ifdef TAQYON_ALLOCATION_HOOKS
+    TrackerGuard guard;
+    popScope();
+#endif
+}
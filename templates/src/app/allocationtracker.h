@@ -0,0 +1,80 @@
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <QByteArray>
+#include <QJsonObject>
+
+class QWebChannel;
+
+// Optional heap allocation accounting. When the app is configured with
+// -DTAQYON_ALLOCATION_TRACKING=ON (Linux/glibc only), malloc, calloc,
+// realloc, free and the aligned variants are interposed; operator new and
+// delete go through malloc and are counted with them. Counting starts with
+// --track-allocations and costs a few atomic increments per allocation. Every
+// signal emission in the process also passes a spy, which compares the
+// sender with the published objects without locking; only emissions of
+// published objects and channel messages take a lock to record their scope.
+//
+// Counts are kept per thread and, inclusively, per scope: a scope is the
+// dispatch of one web channel message (by object and method or property),
+// the emission of a published object's signal (which includes serializing
+// it for the page), a taqyon:// request or an API route handler. Results are
+// published as the "allocations" metrics collector and in benchmark reports.
+class AllocationTracker
+{
+public:
+    struct Counters {
+        quint64 allocations = 0;
+        quint64 bytes = 0;
+        quint64 frees = 0;
+        quint64 freedBytes = 0;
+    };
+
+    // Compiled in and supported on this platform
+    static bool isAvailable();
+    static bool isEnabled();
+    // Starts counting; false (with a warning) when not available
+    static bool enable();
+
+    // Attributes messages and signals of the channel's published objects
+    static void trackChannel(QWebChannel *channel);
+
+    static Counters currentThread();
+    // {"threads": {name: counters}, "scopes": {name: {calls, allocations,
+    // bytes, allocationsPerCall, bytesPerCall}}}
+    static QJsonObject snapshot();
+
+    static void enterScope(const QByteArray &name);
+    static void leaveScope();
+};
+
+// Attributes the allocations of the enclosing block to a named scope. The
+// name is only built when tracking is enabled:
+//     AllocationScope scope([&]() { return "scheme " + host.toUtf8(); });
+class AllocationScope
+{
+public:
+    template <typename NameFunction>
+    explicit AllocationScope(NameFunction name)
+        : m_active(AllocationTracker::isEnabled())
+    {
+        if (m_active) {
+            AllocationTracker::enterScope(name());
+        }
+    }
+
+    ~AllocationScope()
+    {
+        if (m_active) {
+            AllocationTracker::leaveScope();
+        }
+    }
+
+    AllocationScope(const AllocationScope &) = delete;
+    AllocationScope &operator=(const AllocationScope &) = delete;
+
+private:
+    bool m_active;
+};
+
+#endif // ALLOCATIONTRACKER_H
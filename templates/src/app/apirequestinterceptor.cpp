@@ -0,0 +1,96 @@
+#include "apirequestinterceptor.h"
+#include "responsecache.h"
+#include "taqyonscheme.h"
+#include <QWebEngineUrlRequestInfo>
+#include <QUrlQuery>
+#include <QDebug>
+
+namespace {
+const QByteArray::Base64Options kUrlEncoding = QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals;
+const QString kHeadersItem = QStringLiteral("headers");
+}
+
+ApiRequestInterceptor::ApiRequestInterceptor(ResponseCache *cache, QObject *parent)
+    : QWebEngineUrlRequestInterceptor(parent), m_cache(cache)
+{
+}
+
+void ApiRequestInterceptor::interceptRequest(QWebEngineUrlRequestInfo &info)
+{
+    if (info.resourceType() == QWebEngineUrlRequestInfo::ResourceTypeMainFrame
+        || info.requestMethod() != "GET") {
+        return;
+    }
+    const QUrl url = info.requestUrl();
+    if (url.scheme() != QLatin1String("http") && url.scheme() != QLatin1String("https")) {
+        return;
+    }
+    if (m_cache->takePassThrough(url) || !m_cache->matches(url)) {
+        return;
+    }
+    ResponseCache::RequestHeaders forwarded;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+    QHash<QByteArray, QByteArray> headers;
+    const QHash<QByteArray, QByteArray> raw = info.httpHeaders();
+    for (auto it = raw.cbegin(); it != raw.cend(); ++it) {
+        headers.insert(it.key().toLower(), it.value());
+    }
+    if (headers.contains("authorization") || headers.contains("cookie")) {
+        return; // Per-user; the network answers it with the page's credentials
+    }
+    for (const QByteArray &name : ResponseCache::varyHeaderNames()) {
+        const auto header = headers.constFind(name.toLower());
+        if (header != headers.cend()) {
+            forwarded.append(qMakePair(name, header.value()));
+        }
+    }
+#endif
+    info.redirect(cacheUrlFor(url, forwarded));
+}
+
+QUrl ApiRequestInterceptor::cacheUrlFor(const QUrl &remoteUrl, const ResponseCache::RequestHeaders &headers)
+{
+    // The remote URL travels base64url-encoded in the path so that its own
+    // query string survives the redirect untouched.
+    QUrl url;
+    url.setScheme(QString::fromLatin1(TaqyonSchemeHandler::schemeName()));
+    url.setHost(QStringLiteral("cache"));
+    url.setPath("/" + QString::fromLatin1(remoteUrl.toEncoded(QUrl::FullyEncoded).toBase64(kUrlEncoding)));
+    if (!headers.isEmpty()) {
+        QByteArray lines;
+        for (const auto &header : headers) {
+            lines += header.first + ": " + header.second + "\n";
+        }
+        QUrlQuery query;
+        query.addQueryItem(kHeadersItem, QString::fromLatin1(lines.toBase64(kUrlEncoding)));
+        url.setQuery(query);
+    }
+    return url;
+}
+
+QUrl ApiRequestInterceptor::remoteUrlFrom(const QUrl &cacheUrl)
+{
+    const QByteArray encoded = cacheUrl.path().mid(1).toLatin1();
+    return QUrl::fromEncoded(QByteArray::fromBase64(encoded, kUrlEncoding));
+}
+
+ResponseCache::RequestHeaders ApiRequestInterceptor::requestHeadersFrom(const QUrl &cacheUrl)
+{
+    ResponseCache::RequestHeaders headers;
+    const QByteArray lines = QByteArray::fromBase64(
+        QUrlQuery(cacheUrl).queryItemValue(kHeadersItem).toLatin1(), kUrlEncoding);
+    for (const QByteArray &line : lines.split('\n')) {
+        const int colon = line.indexOf(": ");
+        if (colon <= 0) {
+            continue;
+        }
+        const QByteArray name = line.left(colon);
+        // Only the headers the cache keys on, whatever the URL says
+        for (const QByteArray &allowed : ResponseCache::varyHeaderNames()) {
+            if (name.compare(allowed, Qt::CaseInsensitive) == 0) {
+                headers.append(qMakePair(allowed, line.mid(colon + 2)));
+            }
+        }
+    }
+    return headers;
+}
@@ -0,0 +1,31 @@
+#ifndef APIREQUESTINTERCEPTOR_H
+#define APIREQUESTINTERCEPTOR_H
+
+#include "responsecache.h"
+#include <QWebEngineUrlRequestInterceptor>
+#include <QUrl>
+
+// Redirects GET requests for cached API routes to taqyon://cache/, where the
+// ResponseCache answers them. Everything else passes through untouched,
+// including requests with credentials (Authorization or Cookie headers; Qt
+// 6.5+), whose responses must not be shared.
+class ApiRequestInterceptor : public QWebEngineUrlRequestInterceptor
+{
+    Q_OBJECT
+
+public:
+    explicit ApiRequestInterceptor(ResponseCache *cache, QObject *parent = nullptr);
+
+    void interceptRequest(QWebEngineUrlRequestInfo &info) override;
+
+    // The request headers listed in ResponseCache::varyHeaderNames() travel
+    // with the cache URL, so they reach the upstream and the cache key
+    static QUrl cacheUrlFor(const QUrl &remoteUrl, const ResponseCache::RequestHeaders &headers = {});
+    static QUrl remoteUrlFrom(const QUrl &cacheUrl);
+    static ResponseCache::RequestHeaders requestHeadersFrom(const QUrl &cacheUrl);
+
+private:
+    ResponseCache *m_cache;
+};
+
+#endif // APIREQUESTINTERCEPTOR_H
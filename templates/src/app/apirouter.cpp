@@ -0,0 +1,374 @@
+#include "apirouter.h"
+#include "taqyonscheme.h"
+#include "metrics.h"
+#include "allocationtracker.h"
+#include <QWebEngineUrlRequestJob>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QThread>
+#include <QWaitCondition>
+#include <QDebug>
+#include <cstring>
+#include <utility>
+
+struct ApiStreamWriter::State {
+    QMutex mutex;
+    QWaitCondition drained;
+    QByteArray buffer;
+    bool finished = false;
+    bool cancelled = false;
+    // Cleared by the device's destructor, under the mutex
+    QIODevice *device = nullptr;
+};
+
+namespace {
+
+// Producers block once this much is waiting to be read by the page
+const int MaxBufferedBytes = 4 * 1024 * 1024;
+
+// Sequential device the job reads a streamed body from. Producers append to
+// the shared state from worker threads; the device lives on the GUI thread.
+class StreamDevice : public QIODevice
+{
+public:
+    explicit StreamDevice(std::shared_ptr<ApiStreamWriter::State> state)
+        : m_state(std::move(state))
+    {
+        QMutexLocker locker(&m_state->mutex);
+        m_state->device = this;
+        open(QIODevice::ReadOnly);
+    }
+
+    ~StreamDevice() override
+    {
+        QMutexLocker locker(&m_state->mutex);
+        m_state->device = nullptr;
+        m_state->cancelled = true;
+        m_state->drained.wakeAll();
+    }
+
+    bool isSequential() const override { return true; }
+
+    qint64 bytesAvailable() const override
+    {
+        QMutexLocker locker(&m_state->mutex);
+        return m_state->buffer.size() + QIODevice::bytesAvailable();
+    }
+
+    bool atEnd() const override
+    {
+        QMutexLocker locker(&m_state->mutex);
+        return m_state->finished && m_state->buffer.isEmpty() && QIODevice::bytesAvailable() == 0;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        QMutexLocker locker(&m_state->mutex);
+        if (m_state->buffer.isEmpty()) {
+            return m_state->finished ? -1 : 0;
+        }
+        const qint64 count = qMin(maxSize, static_cast<qint64>(m_state->buffer.size()));
+        memcpy(data, m_state->buffer.constData(), count);
+        m_state->buffer.remove(0, count);
+        m_state->drained.wakeAll();
+        return count;
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    std::shared_ptr<ApiStreamWriter::State> m_state;
+};
+
+// Called with the state's mutex held, so the device cannot be destroyed meanwhile
+void notifyDevice(ApiStreamWriter::State *state)
+{
+    QIODevice *device = state->device;
+    if (!device) {
+        return;
+    }
+    const bool finished = state->finished;
+    QMetaObject::invokeMethod(device, [device, finished]() {
+        emit device->readyRead();
+        if (finished) {
+            emit device->readChannelFinished();
+        }
+    }, Qt::QueuedConnection);
+}
+
+QJsonObject errorObject(const QString &message)
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("error"), message);
+    return object;
+}
+
+} // namespace
+
+ApiStreamWriter::ApiStreamWriter(std::shared_ptr<State> state)
+    : m_state(std::move(state))
+{
+}
+
+bool ApiStreamWriter::write(const QByteArray &chunk)
+{
+    QMutexLocker locker(&m_state->mutex);
+    while (!m_state->cancelled && m_state->buffer.size() > MaxBufferedBytes) {
+        m_state->drained.wait(&m_state->mutex);
+    }
+    if (m_state->cancelled) {
+        return false;
+    }
+    m_state->buffer.append(chunk);
+    notifyDevice(m_state.get());
+    return true;
+}
+
+bool ApiStreamWriter::isCancelled() const
+{
+    QMutexLocker locker(&m_state->mutex);
+    return m_state->cancelled;
+}
+
+ApiResponse ApiResponse::json(const QJsonValue &value, int status)
+{
+    ApiResponse response;
+    response.status = status;
+    if (value.isObject()) {
+        response.body = QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact);
+    } else if (value.isArray()) {
+        response.body = QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact);
+    } else {
+        // QJsonDocument only holds objects and arrays
+        QJsonArray wrapper;
+        wrapper.append(value);
+        const QByteArray array = QJsonDocument(wrapper).toJson(QJsonDocument::Compact);
+        response.body = array.mid(1, array.size() - 2);
+    }
+    return response;
+}
+
+ApiResponse ApiResponse::error(int status, const QString &message)
+{
+    return json(errorObject(message), status);
+}
+
+ApiResponse ApiResponse::stream(const QByteArray &contentType, Producer producer)
+{
+    ApiResponse response;
+    response.contentType = contentType;
+    response.producer = std::move(producer);
+    return response;
+}
+
+ApiResponse ApiResponse::redirect(const QUrl &location)
+{
+    ApiResponse response;
+    response.status = 302;
+    response.headers.insert("Location", location.toEncoded());
+    return response;
+}
+
+ApiRouter::ApiRouter(QObject *parent)
+    : QObject(parent)
+{
+    m_streamPool.setMaxThreadCount(qMax(4, QThread::idealThreadCount()));
+}
+
+ApiRouter::~ApiRouter()
+{
+    // Unblock producers still streaming to pages that are going away
+    {
+        QMutexLocker locker(&m_streamsMutex);
+        for (const auto &weak : std::as_const(m_streams)) {
+            if (auto state = weak.lock()) {
+                QMutexLocker stateLocker(&state->mutex);
+                state->cancelled = true;
+                state->drained.wakeAll();
+            }
+        }
+    }
+    m_pool.waitForDone();
+    m_streamPool.waitForDone();
+}
+
+void ApiRouter::addRoute(const QByteArray &method, const QString &pattern, Handler handler, RouteOption option)
+{
+    Route route;
+    route.method = method.toUpper();
+    route.pattern = pattern;
+    route.handler = std::move(handler);
+    route.option = option;
+
+    QStringList parts;
+    const QStringList segments = pattern.split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    for (int i = 0; i < segments.size(); ++i) {
+        const QString &segment = segments.at(i);
+        if (segment.startsWith(QLatin1Char(':'))) {
+            route.paramNames << segment.mid(1);
+            parts << QStringLiteral("([^/]+)");
+        } else if (segment.startsWith(QLatin1Char('*')) && i == segments.size() - 1) {
+            route.paramNames << segment.mid(1);
+            parts << QStringLiteral("(.*)");
+        } else {
+            parts << QRegularExpression::escape(segment);
+        }
+    }
+    route.regex = QRegularExpression(QStringLiteral("^/") + parts.join(QLatin1Char('/')) + QStringLiteral("/?$"));
+    m_routes.append(route);
+}
+
+void ApiRouter::setMaxThreadCount(int count)
+{
+    m_pool.setMaxThreadCount(count);
+}
+
+void ApiRouter::handleRequest(QWebEngineUrlRequestJob *job)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const QByteArray method = job->requestMethod();
+
+    if (!TaqyonSchemeHandler::isAllowedInitiator(job, m_allowedOrigins)) {
+        qWarning() << "ApiRouter: rejected" << method << job->requestUrl().path()
+                   << "from" << job->initiator().toString();
+        Metrics::global().addCount(QStringLiteral("api.rejected"));
+        job->fail(QWebEngineUrlRequestJob::RequestDenied);
+        return;
+    }
+
+    if (method == "OPTIONS") {
+        // CORS preflight from the frontend's origin (taqyon://app, dev server)
+        QMultiMap<QByteArray, QByteArray> headers = TaqyonSchemeHandler::corsHeaders(job);
+        headers.insert("Access-Control-Allow-Methods", "GET, POST, PUT, PATCH, DELETE");
+        headers.insert("Access-Control-Allow-Headers", "*");
+        TaqyonSchemeHandler::replyWithData(job, "text/plain", QByteArray(), headers);
+        return;
+    }
+
+    const QString path = job->requestUrl().path();
+    const Route *matched = nullptr;
+    QRegularExpressionMatch match;
+    QStringList allowed;
+    for (const Route &route : std::as_const(m_routes)) {
+        QRegularExpressionMatch candidate = route.regex.match(path);
+        if (!candidate.hasMatch()) {
+            continue;
+        }
+        if (route.method != method) {
+            allowed << QString::fromLatin1(route.method);
+            continue;
+        }
+        matched = &route;
+        match = candidate;
+        break;
+    }
+    if (!matched) {
+        ApiResponse response = allowed.isEmpty()
+            ? ApiResponse::error(404, QString("No route for %1").arg(path))
+            : ApiResponse::error(405, QString("%1 not allowed for %2").arg(QString::fromLatin1(method), path));
+        if (!allowed.isEmpty()) {
+            response.headers.insert("Allow", allowed.join(QStringLiteral(", ")).toLatin1());
+        }
+        respond(job, QStringLiteral("api.unmatched"), timer, response);
+        return;
+    }
+
+    ApiRequest request;
+    request.method = method;
+    request.url = job->requestUrl();
+    request.path = path;
+    request.query = QUrlQuery(job->requestUrl());
+    for (int i = 0; i < matched->paramNames.size(); ++i) {
+        request.params.insert(matched->paramNames.at(i), QUrl::fromPercentEncoding(match.captured(i + 1).toUtf8()));
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+    request.headers = job->requestHeaders();
+#endif
+#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
+    if (QIODevice *body = job->requestBody()) {
+        request.body = body->readAll();
+    }
+#endif
+
+    const QString metricName = QString("api.%1 %2").arg(QString::fromLatin1(matched->method), matched->pattern);
+    if (matched->option == RunOnGuiThread) {
+        ApiResponse response;
+        {
+            AllocationScope allocationScope([&metricName]() { return metricName.toUtf8(); });
+            response = matched->handler(request);
+        }
+        respond(job, metricName, timer, response);
+        return;
+    }
+
+    QPointer<QWebEngineUrlRequestJob> guard(job);
+    const Handler handler = matched->handler;
+    m_pool.start([this, guard, handler, request, metricName, timer]() {
+        ApiResponse response;
+        {
+            AllocationScope allocationScope([&metricName]() { return metricName.toUtf8(); });
+            response = handler(request);
+        }
+        QMetaObject::invokeMethod(this, [this, guard, metricName, timer, response]() {
+            if (!guard) {
+                Metrics::global().addCount(metricName + QStringLiteral(".cancelled"));
+                return;
+            }
+            respond(guard, metricName, timer, response);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ApiRouter::respond(QWebEngineUrlRequestJob *job, const QString &metricName, const QElapsedTimer &timer,
+                        const ApiResponse &response)
+{
+    Metrics::global().recordLatency(metricName, timer.nsecsElapsed() / 1e6);
+    if (response.status >= 400) {
+        Metrics::global().addCount(metricName + QStringLiteral(".errors"));
+    }
+
+    if (response.status >= 300 && response.status < 400 && response.headers.contains("Location")) {
+        job->redirect(QUrl::fromEncoded(response.headers.value("Location")));
+        return;
+    }
+
+    QMultiMap<QByteArray, QByteArray> headers = response.headers;
+    headers.insert("X-Taqyon-Status", QByteArray::number(response.status));
+    // The page is on another origin and needs these to read X-Taqyon-Status;
+    // handleRequest() has already checked that origin
+    headers.unite(TaqyonSchemeHandler::corsHeaders(job));
+    headers.insert("Access-Control-Expose-Headers", "*");
+
+    if (response.producer) {
+        startStream(job, response, headers);
+        return;
+    }
+    TaqyonSchemeHandler::replyWithData(job, response.contentType, response.body, headers);
+}
+
+void ApiRouter::startStream(QWebEngineUrlRequestJob *job, const ApiResponse &response,
+                            const QMultiMap<QByteArray, QByteArray> &headers)
+{
+    auto state = std::make_shared<ApiStreamWriter::State>();
+    {
+        QMutexLocker locker(&m_streamsMutex);
+        m_streams.removeIf([](const std::weak_ptr<ApiStreamWriter::State> &weak) { return weak.expired(); });
+        m_streams.append(state);
+    }
+    TaqyonSchemeHandler::replyWithDevice(job, response.contentType, new StreamDevice(state), headers);
+
+    const ApiResponse::Producer producer = response.producer;
+    m_streamPool.start([state, producer]() {
+        ApiStreamWriter writer(state);
+        producer(writer);
+        QMutexLocker locker(&state->mutex);
+        state->finished = true;
+        notifyDevice(state.get());
+    });
+}
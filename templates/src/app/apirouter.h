@@ -0,0 +1,139 @@
+#ifndef APIROUTER_H
+#define APIROUTER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMultiMap>
+#include <QMutex>
+#include <QJsonValue>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QUrl>
+#include <QUrlQuery>
+#include <functional>
+#include <memory>
+
+class QWebEngineUrlRequestJob;
+
+struct ApiRequest {
+    QByteArray method;
+    QUrl url;
+    QString path;
+    // Captures of ":name" and "*name" segments of the route pattern
+    QHash<QString, QString> params;
+    QUrlQuery query;
+    // Request headers need Qt 6.5, the body Qt 6.7
+    QMap<QByteArray, QByteArray> headers;
+    QByteArray body;
+};
+
+// Handed to streaming producers. write() is thread-safe and returns false
+// once the page has dropped the request, at which point the producer should stop.
+class ApiStreamWriter
+{
+public:
+    struct State;
+
+    explicit ApiStreamWriter(std::shared_ptr<State> state);
+
+    bool write(const QByteArray &chunk);
+    bool isCancelled() const;
+
+private:
+    std::shared_ptr<State> m_state;
+};
+
+struct ApiResponse {
+    using Producer = std::function<void(ApiStreamWriter &writer)>;
+
+    int status = 200;
+    QByteArray contentType = "application/json";
+    QMultiMap<QByteArray, QByteArray> headers;
+    QByteArray body;
+    // When set, the response is sent right away and the body is streamed
+    // while the producer runs on the router's stream pool
+    Producer producer;
+
+    static ApiResponse json(const QJsonValue &value, int status = 200);
+    static ApiResponse error(int status, const QString &message);
+    static ApiResponse stream(const QByteArray &contentType, Producer producer);
+    static ApiResponse redirect(const QUrl &location);
+};
+
+// fetch()-style endpoints for requests that do not fit QWebChannel's object
+// model: bulk, cacheable or streamed data. Handlers are registered by method
+// and path pattern and served under taqyon://api/<path>:
+//
+//     router.addRoute("GET", "/items/:id", [](const ApiRequest &request) {
+//         return ApiResponse::json(loadItem(request.params.value("id")));
+//     });
+//
+// Handlers run on the router's thread pool unless registered with
+// RunOnGuiThread, so they must not touch GUI-thread objects otherwise.
+// Response headers are passed through (Qt 6.6+). WebEngine has no way to set
+// the HTTP status of a custom scheme reply, so it is sent as the
+// X-Taqyon-Status header and restored by apiFetch() in the bridge module.
+//
+// Only pages and workers of the allowed origins are served, and CORS headers
+// are only sent to them.
+//
+// Each route records its latency, from request to response headers, as
+// "api.<METHOD> <pattern>" in the Metrics registry.
+class ApiRouter : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Handler = std::function<ApiResponse(const ApiRequest &request)>;
+
+    enum RouteOption {
+        NoOptions = 0,
+        RunOnGuiThread = 1
+    };
+
+    explicit ApiRouter(QObject *parent = nullptr);
+    ~ApiRouter();
+
+    // Patterns are paths with ":name" segments and an optional trailing
+    // "*name" that captures the rest of the path
+    void addRoute(const QByteArray &method, const QString &pattern, Handler handler,
+                  RouteOption option = NoOptions);
+
+    void setMaxThreadCount(int count);
+
+    // Origins whose pages and workers may call routes, as for BridgeEndpoint.
+    // With no origins set every request is rejected.
+    void setAllowedOrigins(const QStringList &origins) { m_allowedOrigins = origins; }
+
+    void handleRequest(QWebEngineUrlRequestJob *job);
+
+private:
+    struct Route {
+        QByteArray method;
+        QString pattern;
+        QRegularExpression regex;
+        QStringList paramNames;
+        Handler handler;
+        RouteOption option = NoOptions;
+    };
+
+    void respond(QWebEngineUrlRequestJob *job, const QString &metricName, const QElapsedTimer &timer,
+                 const ApiResponse &response);
+    void startStream(QWebEngineUrlRequestJob *job, const ApiResponse &response,
+                     const QMultiMap<QByteArray, QByteArray> &headers);
+
+    QList<Route> m_routes;
+    QStringList m_allowedOrigins;
+    QMutex m_streamsMutex;
+    QList<std::weak_ptr<ApiStreamWriter::State>> m_streams;
+    QThreadPool m_pool;
+    QThreadPool m_streamPool;
+};
+
+#endif // APIROUTER_H
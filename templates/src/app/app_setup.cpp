@@ -4,6 +4,14 @@
 #include <QDir>
 #include <QDebug>
 #include <QStandardPaths>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace {
+// Log file shared with the message handler; guarded because messages arrive from any thread
+QMutex logFileMutex;
+QFile *activeLogFile = nullptr;
+}
 
 void setupCommandLineParser(QCommandLineParser &parser)
 {
@@ -22,6 +30,109 @@ void setupCommandLineParser(QCommandLineParser &parser)
 
     QCommandLineOption frontendPathOption(QStringList() << "f" << "frontend-path", "Path to frontend dist directory", "path");
     parser.addOption(frontendPathOption);
+
+    QCommandLineOption apiCacheOption(QStringList() << "api-cache", "Cache remote API responses as configured in <file>", "file");
+    parser.addOption(apiCacheOption);
+
+    QCommandLineOption fileUrlsOption(QStringList() << "file-urls", "Load the built frontend through file:// URLs instead of taqyon://app/");
+    parser.addOption(fileUrlsOption);
+
+    QCommandLineOption shutdownDeadlineOption(QStringList() << "shutdown-deadline", "Exit at most <ms> after the window closes, even if WebEngine teardown is still running", "ms", "1000");
+    parser.addOption(shutdownDeadlineOption);
+
+    QCommandLineOption freshSessionOption(QStringList() << "fresh-session", "Start without restoring the previous frontend session");
+    parser.addOption(freshSessionOption);
+
+    QCommandLineOption recordBridgeOption(QStringList() << "record-bridge", "Record the page's web channel traffic to <file>", "file");
+    parser.addOption(recordBridgeOption);
+
+    QCommandLineOption replayBridgeOption(QStringList() << "replay-bridge", "Replay web channel traffic recorded in <file> against the backend and report latency", "file");
+    parser.addOption(replayBridgeOption);
+
+    QCommandLineOption replaySpeedOption(QStringList() << "replay-speed", "Replay at <factor> times the recorded speed; 0 replays as fast as possible", "factor", "1");
+    parser.addOption(replaySpeedOption);
+
+    QCommandLineOption replayHeadlessOption(QStringList() << "replay-headless", "Replay without loading the frontend, then exit");
+    parser.addOption(replayHeadlessOption);
+
+    QCommandLineOption soakConfigOption(QStringList() << "soak", "Run the soak test configured in <file>, then exit", "file");
+    parser.addOption(soakConfigOption);
+
+    QCommandLineOption soakDurationOption(QStringList() << "soak-duration", "Run the soak test for <seconds> (overrides the config)", "seconds");
+    parser.addOption(soakDurationOption);
+
+    QCommandLineOption soakReportOption(QStringList() << "soak-report", "Write the soak test report to <file>", "file");
+    parser.addOption(soakReportOption);
+
+    QCommandLineOption bridgeConditionsOption(QStringList() << "bridge-conditions", "Simulate a slow web channel, e.g. \"latency=120,jitter=40,reorder=0.1,bandwidth=256\" (ms, ms, probability, KB/s)", "spec");
+    parser.addOption(bridgeConditionsOption);
+
+    QCommandLineOption benchmarkOption(QStringList() << "benchmark", "Run the named benchmarks (comma-separated, or \"all\"), then exit", "names");
+    parser.addOption(benchmarkOption);
+
+    QCommandLineOption benchmarkReportOption(QStringList() << "benchmark-report", "Write the benchmark results to <file> as JSON", "file");
+    parser.addOption(benchmarkReportOption);
+
+    QCommandLineOption benchmarkScaleOption(QStringList() << "benchmark-scale", "Multiply every benchmark's iteration count by <factor>", "factor", "1");
+    parser.addOption(benchmarkScaleOption);
+
+    QCommandLineOption benchmarkWindowsOption(QStringList() << "benchmark-windows", "Open up to <n> windows in the window-memory benchmark", "n", "10");
+    parser.addOption(benchmarkWindowsOption);
+
+    QCommandLineOption perfCountersOption(QStringList() << "perf-counters", "Collect CPU performance counters around benchmark operations (Linux)");
+    parser.addOption(perfCountersOption);
+
+    QCommandLineOption profileGuiOption(QStringList() << "profile-gui", "Sample the GUI thread from startup and write folded stacks on exit");
+    parser.addOption(profileGuiOption);
+
+    QCommandLineOption profileRateOption(QStringList() << "profile-rate", "GUI thread sampling rate in <hz>", "hz", "99");
+    parser.addOption(profileRateOption);
+
+    QCommandLineOption profileWallClockOption(QStringList() << "profile-wall-clock", "Sample by wall-clock time instead of CPU time, to include blocking");
+    parser.addOption(profileWallClockOption);
+
+#ifdef TAQYON_WEBSOCKETS
+    QCommandLineOption devToolsPortOption(QStringList() << "devtools-port", "Open the DevTools protocol on 127.0.0.1:<port> for CPU profile, heap snapshot and trace captures", "port");
+    parser.addOption(devToolsPortOption);
+
+    QCommandLineOption captureCpuProfileOption(QStringList() << "capture-cpu-profile", "Record a JS CPU profile for <seconds> after the frontend has loaded", "seconds");
+    parser.addOption(captureCpuProfileOption);
+
+    QCommandLineOption captureHeapAboveOption(QStringList() << "capture-heap-above", "Take a JS heap snapshot once the page's heap exceeds <MB>", "MB");
+    parser.addOption(captureHeapAboveOption);
+#endif
+
+    QCommandLineOption trackAllocationsOption(QStringList() << "track-allocations", "Count heap allocations per thread, channel call, signal and request (builds with TAQYON_ALLOCATION_TRACKING)");
+    parser.addOption(trackAllocationsOption);
+
+    QCommandLineOption softwareRenderingOption(QStringList() << "software-rendering", "Render web content without the GPU, as Chromium does on machines without a usable one");
+    parser.addOption(softwareRenderingOption);
+
+    QCommandLineOption launchProfileOption(QStringList() << "launch-profile", "Trade speed for memory: low-memory, balanced or throughput", "name", "balanced");
+    parser.addOption(launchProfileOption);
+
+    QCommandLineOption lastFrameOption(QStringList() << "last-frame-splash", "Keep a screenshot of the window on disk to show while the next launch starts (may include private data)");
+    parser.addOption(lastFrameOption);
+
+    QCommandLineOption pluginDirOption(QStringList() << "plugin-dir", "Directory of backend plugins, loaded on first use (default: plugins next to the executable)", "path");
+    parser.addOption(pluginDirOption);
+
+    QCommandLineOption hotReloadPluginsOption(QStringList() << "hot-reload-plugins", "Development: reload backend plugins in place when their libraries are rebuilt");
+    parser.addOption(hotReloadPluginsOption);
+
+    QCommandLineOption pluginSourcesOption(QStringList() << "plugin-sources", "Development: rebuild plugins with --plugin-build when files under <path> change", "path");
+    parser.addOption(pluginSourcesOption);
+
+    QCommandLineOption pluginBuildOption(QStringList() << "plugin-build", "Development: shell command that rebuilds the plugins", "command");
+    parser.addOption(pluginBuildOption);
+
+#ifdef TAQYON_WEBSOCKETS
+    QCommandLineOption bridgeWebSocketOption(QStringList() << "bridge-websocket", "Development: serve the backend channel on ws://127.0.0.1:<port> for the frontend in an external browser", "port");
+    parser.addOption(bridgeWebSocketOption);
+#endif
+
+    QCommandLineOption clearMemoCacheOption(QStringList() << "clear-memo-cache", "Drop the stored results of memoized backend methods");
+    parser.addOption(clearMemoCacheOption);
 }
 
 AppOptions parseCommandLine(QCommandLineParser &parser)
@@ -31,6 +142,51 @@ AppOptions parseCommandLine(QCommandLineParser &parser)
     options.logFilePath = parser.isSet("log") ? parser.value("log") : QString();
     options.devServerUrl = parser.isSet("dev-server") ? parser.value("dev-server") : QString();
     options.frontendPath = parser.isSet("frontend-path") ? parser.value("frontend-path") : QString();
+    options.apiCacheConfig = parser.isSet("api-cache") ? parser.value("api-cache") : QString();
+    options.useFileUrls = parser.isSet("file-urls");
+    options.shutdownDeadlineMs = parser.value("shutdown-deadline").toInt();
+    options.freshSession = parser.isSet("fresh-session");
+    options.recordBridgePath = parser.isSet("record-bridge") ? parser.value("record-bridge") : QString();
+    options.replayBridgePath = parser.isSet("replay-bridge") ? parser.value("replay-bridge") : QString();
+    options.replaySpeed = parser.value("replay-speed").toDouble();
+    options.replayHeadless = parser.isSet("replay-headless");
+    options.soakConfigPath = parser.isSet("soak") ? parser.value("soak") : QString();
+    options.soakDurationSec = parser.isSet("soak-duration") ? parser.value("soak-duration").toInt() : 0;
+    options.soakReportPath = parser.isSet("soak-report") ? parser.value("soak-report") : QString();
+    options.bridgeConditions = parser.isSet("bridge-conditions") ? parser.value("bridge-conditions") : QString();
+    options.benchmarks = parser.isSet("benchmark") ? parser.value("benchmark") : QString();
+    options.benchmarkReportPath = parser.isSet("benchmark-report") ? parser.value("benchmark-report") : QString();
+    options.benchmarkScale = parser.value("benchmark-scale").toDouble();
+    options.benchmarkWindows = parser.value("benchmark-windows").toInt();
+    options.perfCounters = parser.isSet("perf-counters");
+    options.profileGui = parser.isSet("profile-gui");
+    options.profileRateHz = parser.value("profile-rate").toInt();
+    options.profileWallClock = parser.isSet("profile-wall-clock");
+#ifdef TAQYON_WEBSOCKETS
+    options.devToolsPort = parser.isSet("devtools-port") ? parser.value("devtools-port").toUShort() : 0;
+    options.captureCpuProfileSec = parser.isSet("capture-cpu-profile") ? parser.value("capture-cpu-profile").toInt() : 0;
+    options.captureHeapAboveMb = parser.isSet("capture-heap-above") ? parser.value("capture-heap-above").toDouble() : 0;
+    options.bridgeWebSocketPort = parser.isSet("bridge-websocket") ? parser.value("bridge-websocket").toUShort() : 0;
+#else
+    // Built without Qt WebSockets
+    options.devToolsPort = 0;
+    options.captureCpuProfileSec = 0;
+    options.captureHeapAboveMb = 0;
+    options.bridgeWebSocketPort = 0;
+#endif
+    options.trackAllocations = parser.isSet("track-allocations");
+    options.softwareRendering = parser.isSet("software-rendering");
+    options.launchProfile = parser.value("launch-profile");
+    options.lastFrameSplash = parser.isSet("last-frame-splash");
+    options.pluginDir = parser.isSet("plugin-dir") ? parser.value("plugin-dir")
+                                                   : QCoreApplication::applicationDirPath() + "/plugins";
+    options.hotReloadPlugins = parser.isSet("hot-reload-plugins");
+    options.pluginSourceDir = parser.isSet("plugin-sources") ? parser.value("plugin-sources") : QString();
+    options.pluginBuildCommand = parser.isSet("plugin-build") ? parser.value("plugin-build") : QString();
+    options.clearMemoCache = parser.isSet("clear-memo-cache");
+    if (options.devToolsPort == 0 && (options.captureCpuProfileSec > 0 || options.captureHeapAboveMb > 0)) {
+        options.devToolsPort = 9222;
+    }
     return options;
 }
 
@@ -40,6 +196,10 @@ void setupLogging(const AppOptions &options, QFile *&logFile)
     if (!options.logFilePath.isEmpty()) {
         logFile = new QFile(options.logFilePath);
         if (logFile->open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Append)) {
+            {
+                QMutexLocker locker(&logFileMutex);
+                activeLogFile = logFile;
+            }
             qInfo() << "Logging to file:" << options.logFilePath;
         } else {
             qWarning() << "Could not open log file for writing:" << options.logFilePath;
@@ -49,6 +209,48 @@ void setupLogging(const AppOptions &options, QFile *&logFile)
     }
 }
 
+void appendToLogFile(const QString &line)
+{
+    QMutexLocker locker(&logFileMutex);
+    if (activeLogFile && activeLogFile->isOpen()) {
+        activeLogFile->write(line.toUtf8());
+        activeLogFile->write("\n");
+    }
+}
+
+void flushLogFile()
+{
+    QMutexLocker locker(&logFileMutex);
+    if (activeLogFile && activeLogFile->isOpen()) {
+        activeLogFile->flush();
+    }
+}
+
+void closeLogFile()
+{
+    QMutexLocker locker(&logFileMutex);
+    if (activeLogFile) {
+        activeLogFile->close();
+        activeLogFile = nullptr;
+    }
+}
+
+QString diagnosticsDirectory()
+{
+    QString dir;
+    {
+        QMutexLocker locker(&logFileMutex);
+        if (activeLogFile) {
+            dir = QFileInfo(activeLogFile->fileName()).absolutePath();
+        }
+    }
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/diagnostics");
+    }
+    QDir().mkpath(dir);
+    return dir;
+}
+
 QUrl resolveFrontendUrl(const QCommandLineParser &parser)
 {
     if (parser.isSet("dev-server")) {
@@ -12,11 +12,50 @@ struct AppOptions {
     QString devServerUrl;
     QString frontendPath;
     QUrl frontendUrl;
+    QString apiCacheConfig;
+    bool useFileUrls;
+    int shutdownDeadlineMs;
+    bool freshSession;
+    QString recordBridgePath;
+    QString replayBridgePath;
+    double replaySpeed;
+    bool replayHeadless;
+    QString soakConfigPath;
+    int soakDurationSec;
+    QString soakReportPath;
+    QString bridgeConditions;
+    QString benchmarks;
+    QString benchmarkReportPath;
+    double benchmarkScale;
+    int benchmarkWindows;
+    bool perfCounters;
+    bool profileGui;
+    int profileRateHz;
+    bool profileWallClock;
+    quint16 devToolsPort;
+    int captureCpuProfileSec;
+    double captureHeapAboveMb;
+    bool trackAllocations;
+    bool softwareRendering;
+    QString launchProfile;
+    bool lastFrameSplash;
+    QString pluginDir;
+    bool hotReloadPlugins;
+    QString pluginSourceDir;
+    QString pluginBuildCommand;
+    quint16 bridgeWebSocketPort;
+    bool clearMemoCache;
 };
 
 void setupCommandLineParser(QCommandLineParser &parser);
 AppOptions parseCommandLine(QCommandLineParser &parser);
 void setupLogging(const AppOptions &options, QFile *&logFile);
+void appendToLogFile(const QString &line);
+void flushLogFile();
+void closeLogFile();
+// Where profiles, snapshots and other diagnostics are written: next to the
+// log file when logging to one, otherwise under the app data directory
+QString diagnosticsDirectory();
 QUrl resolveFrontendUrl(const QCommandLineParser &parser);
 
 #endif // APP_SETUP_H
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "assetcache.h"
+#include "taqyonscheme.h"
+#include <QWebEngineUrlRequestJob>
+#include <QMutexLocker>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+
+namespace {
+
+QByteArray knownContentType(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == QLatin1String("html")) return "text/html";
+    if (suffix == QLatin1String("js") || suffix == QLatin1String("mjs")) return "text/javascript";
+    if (suffix == QLatin1String("css")) return "text/css";
+    if (suffix == QLatin1String("json") || suffix == QLatin1String("map")) return "application/json";
+    if (suffix == QLatin1String("svg")) return "image/svg+xml";
+    if (suffix == QLatin1String("wasm")) return "application/wasm";
+    return QByteArray();
+}
+
+} // namespace
+
+AssetCache::AssetCache(const QString &rootPath, qint64 maxBytes)
+    : m_rootPath(QDir(rootPath).absolutePath())
+{
+    m_cache.setMaxCost(maxBytes);
+}
+
+QString AssetCache::normalizedPath(const QString &relativePath)
+{
+    // cleanPath() on an absolute path cannot climb above the root
+    QString path = QDir::cleanPath(QLatin1Char('/') + relativePath);
+    return path.mid(1);
+}
+
+QString AssetCache::filePathFor(const QString &relativePath) const
+{
+    return m_rootPath + QLatin1Char('/') + normalizedPath(relativePath);
+}
+
+bool AssetCache::contains(const QString &relativePath) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.contains(normalizedPath(relativePath));
+}
+
+QByteArray AssetCache::readFile(const QString &key, bool *ok) const
+{
+    QFile file(m_rootPath + QLatin1Char('/') + key);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *ok = false;
+        return QByteArray();
+    }
+    *ok = true;
+    return file.readAll();
+}
+
+QByteArray AssetCache::load(const QString &relativePath, bool *ok)
+{
+    const QString key = normalizedPath(relativePath);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (const QByteArray *cached = m_cache.object(key)) {
+            ++m_stats.hits;
+            if (ok) *ok = true;
+            return *cached;
+        }
+        ++m_stats.misses;
+    }
+
+    bool readOk = false;
+    const QByteArray data = readFile(key, &readOk);
+    if (ok) *ok = readOk;
+    if (readOk) {
+        QMutexLocker locker(&m_mutex);
+        m_cache.insert(key, new QByteArray(data), data.size());
+    }
+    return data;
+}
+
+bool AssetCache::preload(const QString &relativePath)
+{
+    const QString key = normalizedPath(relativePath);
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_cache.contains(key)) {
+            return true;
+        }
+    }
+    bool ok = false;
+    const QByteArray data = readFile(key, &ok);
+    if (!ok) {
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    if (m_cache.insert(key, new QByteArray(data), data.size())) {
+        ++m_stats.preloaded;
+    }
+    return true;
+}
+
+void AssetCache::setMaxBytes(qint64 maxBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.setMaxCost(maxBytes);
+}
+
+qint64 AssetCache::maxBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_cache.maxCost();
+}
+
+AssetCache::Stats AssetCache::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    stats.bytes = m_cache.totalCost();
+    return stats;
+}
+
+void AssetCache::handleRequest(QWebEngineUrlRequestJob *job)
+{
+    if (job->requestMethod() != "GET") {
+        job->fail(QWebEngineUrlRequestJob::RequestDenied);
+        return;
+    }
+
+    QString path = normalizedPath(job->requestUrl().path());
+    if (path.isEmpty()) {
+        path = QStringLiteral("index.html");
+    }
+
+    bool ok = false;
+    QByteArray data = load(path, &ok);
+    if (!ok && QFileInfo(path).suffix().isEmpty()) {
+        // History-mode routers: unknown extensionless paths get the app shell
+        path = QStringLiteral("index.html");
+        data = load(path, &ok);
+    }
+    if (!ok) {
+        qWarning() << "AssetCache: not found:" << job->requestUrl().toString();
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+
+    QByteArray contentType = knownContentType(path);
+    if (contentType.isEmpty()) {
+        contentType = m_mimeDatabase.mimeTypeForFile(path, QMimeDatabase::MatchExtension).name().toUtf8();
+    }
+    TaqyonSchemeHandler::replyWithData(job, contentType, data);
+}
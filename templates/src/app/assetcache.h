@@ -0,0 +1,52 @@
+#ifndef ASSETCACHE_H
+#define ASSETCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QCache>
+#include <QMutex>
+#include <QMimeDatabase>
+
+class QWebEngineUrlRequestJob;
+
+// Serves the built frontend (frontend/dist) under taqyon://app/ and keeps
+// file contents in a bounded in-memory cache. Lookups and preloads are
+// thread-safe, so chunks can be read into the cache from a worker thread
+// before the page asks for them.
+class AssetCache
+{
+public:
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 preloaded = 0;
+        qint64 bytes = 0;
+    };
+
+    explicit AssetCache(const QString &rootPath, qint64 maxBytes = 32 * 1024 * 1024);
+
+    QString rootPath() const { return m_rootPath; }
+    QString filePathFor(const QString &relativePath) const;
+
+    bool contains(const QString &relativePath) const;
+    QByteArray load(const QString &relativePath, bool *ok = nullptr);
+    bool preload(const QString &relativePath);
+
+    void setMaxBytes(qint64 maxBytes);
+    qint64 maxBytes() const;
+    Stats stats() const;
+
+    void handleRequest(QWebEngineUrlRequestJob *job);
+
+private:
+    static QString normalizedPath(const QString &relativePath);
+    QByteArray readFile(const QString &key, bool *ok) const;
+
+    QString m_rootPath;
+    mutable QMutex m_mutex;
+    QCache<QString, QByteArray> m_cache;
+    QMimeDatabase m_mimeDatabase;
+    Stats m_stats;
+};
+
+#endif // ASSETCACHE_H
@@ -0,0 +1,200 @@
+#include "bridgeendpoint.h"
+#include "taqyonscheme.h"
+#include <QWebEngineUrlRequestJob>
+#include <QMetaMethod>
+#include <QMetaProperty>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QUrlQuery>
+#include <QDebug>
+
+namespace {
+
+// QMetaMethod::invoke() takes at most ten arguments
+const int MaxArguments = 10;
+
+QVariant argumentFromJson(const QJsonValue &value, QMetaType target, bool *ok)
+{
+    *ok = true;
+    switch (target.id()) {
+    case QMetaType::QJsonValue:
+        return QVariant::fromValue(value);
+    case QMetaType::QJsonObject:
+        *ok = value.isObject();
+        return QVariant::fromValue(value.toObject());
+    case QMetaType::QJsonArray:
+        *ok = value.isArray();
+        return QVariant::fromValue(value.toArray());
+    default:
+        break;
+    }
+    QVariant variant = value.toVariant();
+    if (target.id() != QMetaType::QVariant) {
+        *ok = variant.convert(target);
+    }
+    return variant;
+}
+
+} // namespace
+
+BridgeEndpoint::BridgeEndpoint()
+{
+}
+
+void BridgeEndpoint::registerObject(const QString &name, QObject *object)
+{
+    m_objects.insert(name, object);
+}
+
+void BridgeEndpoint::handleRequest(QWebEngineUrlRequestJob *job)
+{
+    if (!TaqyonSchemeHandler::isAllowedInitiator(job, m_allowedOrigins)) {
+        qWarning() << "BridgeEndpoint: rejected request from" << job->initiator().toString();
+        job->fail(QWebEngineUrlRequestJob::RequestDenied);
+        return;
+    }
+
+    const QStringList parts = job->requestUrl().path().split(QLatin1Char('/'), Qt::SkipEmptyParts);
+    if (parts.size() != 2) {
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+    QObject *object = m_objects.value(parts.at(0)).data();
+    if (!object) {
+        replyError(job, QString("Unknown object \"%1\"").arg(parts.at(0)));
+        return;
+    }
+
+    QJsonArray args;
+    QString error;
+    if (!readArguments(job, args, error)) {
+        replyError(job, error);
+        return;
+    }
+
+    QVariant result;
+    if (!invoke(object, parts.at(1), args, result, error)) {
+        replyError(job, error);
+        return;
+    }
+
+    if (result.typeId() == QMetaType::QByteArray) {
+        TaqyonSchemeHandler::replyWithData(job, "application/octet-stream", result.toByteArray(),
+                                           TaqyonSchemeHandler::corsHeaders(job));
+        return;
+    }
+    QJsonObject reply;
+    reply.insert(QStringLiteral("result"), QJsonValue::fromVariant(result));
+    TaqyonSchemeHandler::replyWithData(job, "application/json",
+                                       QJsonDocument(reply).toJson(QJsonDocument::Compact),
+                                       TaqyonSchemeHandler::corsHeaders(job));
+}
+
+bool BridgeEndpoint::readArguments(QWebEngineUrlRequestJob *job, QJsonArray &args, QString &error) const
+{
+    QByteArray json;
+    if (job->requestMethod() == "GET") {
+        json = QUrlQuery(job->requestUrl()).queryItemValue(QStringLiteral("args"), QUrl::FullyDecoded).toUtf8();
+    } else if (job->requestMethod() == "POST") {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
+        if (QIODevice *body = job->requestBody()) {
+            json = body->readAll();
+        }
+#else
+        error = QStringLiteral("POST requires Qt 6.7; pass arguments in the \"args\" query item");
+        return false;
+#endif
+    } else {
+        error = QString("Unsupported method %1").arg(QString::fromLatin1(job->requestMethod()));
+        return false;
+    }
+
+    if (json.isEmpty()) {
+        args = QJsonArray();
+        return true;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+    if (!document.isArray()) {
+        error = QString("Arguments must be a JSON array (%1)").arg(parseError.errorString());
+        return false;
+    }
+    args = document.array();
+    return true;
+}
+
+bool BridgeEndpoint::invoke(QObject *object, const QString &name, const QJsonArray &args,
+                            QVariant &result, QString &error) const
+{
+    const QMetaObject *metaObject = object->metaObject();
+    const QByteArray methodName = name.toUtf8();
+
+    // Same surface as QWebChannel, minus QObject's own slots
+    for (int i = QObject::staticMetaObject.methodCount(); i < metaObject->methodCount(); ++i) {
+        const QMetaMethod method = metaObject->method(i);
+        if (method.name() != methodName || method.access() != QMetaMethod::Public
+            || (method.methodType() != QMetaMethod::Slot && method.methodType() != QMetaMethod::Method)
+            || method.parameterCount() != args.size()) {
+            continue;
+        }
+        if (args.size() > MaxArguments) {
+            error = QString("%1 takes too many arguments").arg(name);
+            return false;
+        }
+
+        QVariant values[MaxArguments];
+        QGenericArgument arguments[MaxArguments];
+        for (int p = 0; p < args.size(); ++p) {
+            const QMetaType type = method.parameterMetaType(p);
+            bool ok = false;
+            values[p] = argumentFromJson(args.at(p), type, &ok);
+            if (!ok) {
+                error = QString("Argument %1 of %2 cannot be converted to %3")
+                            .arg(p + 1).arg(name, QString::fromLatin1(type.name()));
+                return false;
+            }
+            // QVariant parameters take the variant itself, everything else its payload
+            arguments[p] = type.id() == QMetaType::QVariant
+                               ? QGenericArgument("QVariant", &values[p])
+                               : QGenericArgument(type.name(), values[p].constData());
+        }
+
+        const QMetaType returnType = method.returnMetaType();
+        QGenericReturnArgument returnArgument;
+        if (returnType.id() == QMetaType::QVariant) {
+            returnArgument = QGenericReturnArgument("QVariant", &result);
+        } else if (returnType.id() != QMetaType::Void) {
+            result = QVariant(returnType);
+            returnArgument = QGenericReturnArgument(returnType.name(), result.data());
+        }
+
+        if (!method.invoke(object, Qt::DirectConnection, returnArgument,
+                           arguments[0], arguments[1], arguments[2], arguments[3], arguments[4],
+                           arguments[5], arguments[6], arguments[7], arguments[8], arguments[9])) {
+            error = QString("Calling %1 failed").arg(name);
+            return false;
+        }
+        return true;
+    }
+
+    if (args.isEmpty()) {
+        const int index = metaObject->indexOfProperty(methodName.constData());
+        if (index >= 0 && metaObject->property(index).isReadable()) {
+            result = metaObject->property(index).read(object);
+            return true;
+        }
+    }
+
+    error = QString("No method or property \"%1\" taking %2 argument(s)").arg(name).arg(args.size());
+    return false;
+}
+
+void BridgeEndpoint::replyError(QWebEngineUrlRequestJob *job, const QString &error)
+{
+    qWarning() << "BridgeEndpoint:" << job->requestUrl().path() << error;
+    QJsonObject reply;
+    reply.insert(QStringLiteral("error"), error);
+    TaqyonSchemeHandler::replyWithData(job, "application/json",
+                                       QJsonDocument(reply).toJson(QJsonDocument::Compact),
+                                       TaqyonSchemeHandler::corsHeaders(job));
+}
@@ -0,0 +1,51 @@
+#ifndef BRIDGEENDPOINT_H
+#define BRIDGEENDPOINT_H
+
+#include <QHash>
+#include <QPointer>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QJsonArray>
+
+class QWebEngineUrlRequestJob;
+
+// Lets Web Workers call backend objects without going through the page's
+// main thread. QWebChannel is only reachable from the page through
+// qt.webChannelTransport; this endpoint serves the same objects over plain
+// fetch() under taqyon://bridge/<object>/<name>.
+//
+// <name> is a public slot or Q_INVOKABLE method, called with the JSON array
+// from the request body (POST, Qt 6.7+) or the "args" query item (GET), or a
+// readable property when there are no arguments. Results are returned as
+// {"result": ...}; QByteArray results are sent as raw application/octet-stream
+// so bulk data can be read straight into an ArrayBuffer. Failures are
+// reported as {"error": "..."}.
+//
+// Only objects registered here are reachable, and only from allowed origins;
+// see TaqyonSchemeHandler::originsOf().
+class BridgeEndpoint
+{
+public:
+    BridgeEndpoint();
+
+    void registerObject(const QString &name, QObject *object);
+
+    // Origins ("taqyon://app", "http://localhost:5173") whose pages and
+    // workers may call in. With no origins set every request is rejected.
+    void setAllowedOrigins(const QStringList &origins) { m_allowedOrigins = origins; }
+
+    void handleRequest(QWebEngineUrlRequestJob *job);
+
+private:
+    bool readArguments(QWebEngineUrlRequestJob *job, QJsonArray &args, QString &error) const;
+    bool invoke(QObject *object, const QString &name, const QJsonArray &args,
+                QVariant &result, QString &error) const;
+    static void replyError(QWebEngineUrlRequestJob *job, const QString &error);
+
+    QHash<QString, QPointer<QObject>> m_objects;
+    QStringList m_allowedOrigins;
+};
+
+#endif // BRIDGEENDPOINT_H
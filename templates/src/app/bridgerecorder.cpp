@@ -0,0 +1,153 @@
+#include "bridgerecorder.h"
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+#include <QWebEngineScriptCollection>
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <QCborValue>
+#include <QCborArray>
+#include <QCborMap>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QDebug>
+
+namespace {
+
+const char kScriptName[] = "taqyon-transport-record";
+const char kFormat[] = "taqyon-bridge-recording";
+const int kVersion = 1;
+
+} // namespace
+
+BridgeRecorder::BridgeRecorder(QObject *parent)
+    : QObject(parent), m_originMs(0), m_recordCount(0)
+{
+}
+
+BridgeRecorder::~BridgeRecorder()
+{
+    stop();
+}
+
+bool BridgeRecorder::start(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "BridgeRecorder: could not open" << path << "for writing";
+        return false;
+    }
+    m_writer.reset(new QCborStreamWriter(&m_file));
+    m_writer->startArray();
+    QCborMap header;
+    header.insert(QStringLiteral("format"), QString::fromLatin1(kFormat));
+    header.insert(QStringLiteral("version"), kVersion);
+    header.insert(QStringLiteral("startedAt"), QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+    header.toCborValue().toCbor(*m_writer);
+    m_originMs = 0;
+    m_recordCount = 0;
+    qInfo() << "BridgeRecorder: recording channel traffic to" << path;
+    return true;
+}
+
+void BridgeRecorder::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_writer) {
+        return;
+    }
+    m_writer->endArray();
+    m_writer.reset();
+    m_file.close();
+    qInfo() << "BridgeRecorder: wrote" << m_recordCount << "messages to" << m_file.fileName();
+}
+
+bool BridgeRecorder::isRecording() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_writer != nullptr;
+}
+
+void BridgeRecorder::attachToPage(QWebEnginePage *page)
+{
+    m_page = page;
+    if (!m_page) {
+        return;
+    }
+    // Merged into the object so other transport options can be injected separately
+    QWebEngineScript script;
+    script.setName(QString::fromLatin1(kScriptName));
+    script.setInjectionPoint(QWebEngineScript::DocumentCreation);
+    script.setWorldId(QWebEngineScript::MainWorld);
+    script.setRunsOnSubFrames(false);
+    script.setSourceCode(QStringLiteral(
+        "window.__TAQYON_TRANSPORT__ = Object.assign(window.__TAQYON_TRANSPORT__ || {}, { record: true });"));
+    m_page->scripts().insert(script);
+}
+
+void BridgeRecorder::appendRecords(const QJsonArray &records)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_writer) {
+        return;
+    }
+    for (const QJsonValue &value : records) {
+        const QJsonArray record = value.toArray();
+        if (record.size() != 3) {
+            continue;
+        }
+        const double timeMs = record.at(0).toDouble();
+        if (m_originMs == 0) {
+            m_originMs = timeMs;
+        }
+        // Stored as CBOR rather than the JSON text the page sent, which roughly halves the size
+        const QJsonDocument message = QJsonDocument::fromJson(record.at(2).toString().toUtf8());
+        QCborArray entry;
+        entry.append(static_cast<qint64>((timeMs - m_originMs) * 1000));
+        entry.append(record.at(1).toInt());
+        entry.append(QCborValue::fromJsonValue(message.object()));
+        entry.toCborValue().toCbor(*m_writer);
+        ++m_recordCount;
+    }
+    // Batches arrive about once a second; keep the file usable after a crash
+    m_file.flush();
+}
+
+bool BridgeRecorder::readRecording(const QString &path, QList<Record> &records)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "BridgeRecorder: could not open" << path;
+        return false;
+    }
+    QCborStreamReader reader(&file);
+    if (!reader.isArray() || !reader.enterContainer()) {
+        qWarning() << "BridgeRecorder:" << path << "is not a bridge recording";
+        return false;
+    }
+
+    const QCborMap header = QCborValue::fromCbor(reader).toMap();
+    if (header.value(QStringLiteral("format")).toString() != QLatin1String(kFormat)
+        || header.value(QStringLiteral("version")).toInteger() > kVersion) {
+        qWarning() << "BridgeRecorder:" << path << "has an unsupported format";
+        return false;
+    }
+
+    records.clear();
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        const QCborArray entry = QCborValue::fromCbor(reader).toArray();
+        if (reader.lastError() != QCborError::NoError || entry.size() != 3) {
+            break;
+        }
+        Record record;
+        record.timeUs = entry.at(0).toInteger();
+        record.direction = entry.at(1).toInteger() == BackendToPage ? BackendToPage : PageToBackend;
+        record.message = entry.at(2).toMap().toJsonObject();
+        records.append(record);
+    }
+    if (reader.lastError() != QCborError::NoError) {
+        qWarning() << "BridgeRecorder:" << path << "is truncated; read" << records.size() << "messages";
+    }
+    return true;
+}
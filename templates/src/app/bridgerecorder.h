@@ -0,0 +1,72 @@
+#ifndef BRIDGERECORDER_H
+#define BRIDGERECORDER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <memory>
+
+class QCborStreamWriter;
+class QWebEnginePage;
+
+// Records the page's QWebChannel traffic, both directions, to a compact CBOR
+// file that ReplayTransport can play back against the backend objects.
+//
+// QtWebEngine's transport is internal, so messages are captured in the page:
+// the bridge module wraps qt.webChannelTransport when the injected
+// window.__TAQYON_TRANSPORT__.record flag is set and sends batches of
+// [epoch ms, direction, message] to appendRecords(). Its own batches are
+// left out of the recording.
+//
+// File layout: one indefinite-length CBOR array holding a header map
+// {"format", "version", "startedAt"} followed by [time us, direction,
+// message] arrays. A file cut short by a crash is still readable up to the
+// last complete record.
+//
+// Published to the page as "bridgeRecorder".
+class BridgeRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Direction {
+        PageToBackend = 0,
+        BackendToPage = 1
+    };
+
+    struct Record {
+        qint64 timeUs = 0;
+        Direction direction = PageToBackend;
+        QJsonObject message;
+    };
+
+    explicit BridgeRecorder(QObject *parent = nullptr);
+    ~BridgeRecorder();
+
+    bool start(const QString &path);
+    // Thread-safe; used by the shutdown coordinator
+    void stop();
+    bool isRecording() const;
+
+    void attachToPage(QWebEnginePage *page);
+
+    static bool readRecording(const QString &path, QList<Record> &records);
+
+public slots:
+    void appendRecords(const QJsonArray &records);
+
+private:
+    mutable QMutex m_mutex;
+    QFile m_file;
+    std::unique_ptr<QCborStreamWriter> m_writer;
+    double m_originMs;
+    qint64 m_recordCount;
+    QPointer<QWebEnginePage> m_page;
+};
+
+#endif // BRIDGERECORDER_H
@@ -0,0 +1,397 @@
+#include "devtoolscapture.h"
+#include "app_setup.h"
+#include "metrics.h"
+#include <QDateTime>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSaveFile>
+#include <QStringList>
+#include <QWebEnginePage>
+#include <QDebug>
+
+namespace {
+
+const int kHeapPollIntervalMs = 10000;
+
+// What the Performance panel of DevTools records
+const char kDefaultTraceCategories[] =
+    "devtools.timeline,disabled-by-default-devtools.timeline,disabled-by-default-devtools.timeline.frame,"
+    "toplevel,v8.execute,blink.console,blink.user_timing,latencyInfo,disabled-by-default-v8.cpu_profiler";
+
+} // namespace
+
+void DevToolsCapture::enableRemoteDebugging(quint16 port)
+{
+    qputenv("QTWEBENGINE_REMOTE_DEBUGGING", QByteArray("127.0.0.1:") + QByteArray::number(port));
+}
+
+DevToolsCapture::DevToolsCapture(QWebEnginePage *page, quint16 port, QObject *parent)
+    : QObject(parent)
+    , m_page(page)
+    , m_port(port)
+    , m_connecting(false)
+    , m_nextId(1)
+    , m_profiling(false)
+    , m_heapFile(nullptr)
+    , m_traceFile(nullptr)
+    , m_traceHasEvents(false)
+    , m_heapThresholdMb(0)
+    , m_heapThresholdHit(false)
+    , m_heapUsedMb(0)
+{
+    connect(&m_socket, &QWebSocket::connected, this, &DevToolsCapture::onConnected);
+    connect(&m_socket, &QWebSocket::textMessageReceived, this, &DevToolsCapture::onMessage);
+    connect(&m_socket, &QWebSocket::disconnected, this, [this]() {
+        m_connecting = false;
+        failPending(QStringLiteral("DevTools connection closed"));
+    });
+    m_heapTimer.setInterval(kHeapPollIntervalMs);
+    connect(&m_heapTimer, &QTimer::timeout, this, &DevToolsCapture::checkHeap);
+    // A navigation replaces the renderer's debugging target
+    if (page) {
+        connect(page, &QWebEnginePage::loadStarted, this, [this]() {
+            if (m_socket.state() != QAbstractSocket::UnconnectedState) {
+                m_socket.close();
+            }
+        });
+    }
+}
+
+DevToolsCapture::~DevToolsCapture()
+{
+    delete m_heapFile;
+    delete m_traceFile;
+}
+
+void DevToolsCapture::setHeapThreshold(double megabytes)
+{
+    m_heapThresholdMb = megabytes;
+    m_heapThresholdHit = false;
+    if (megabytes > 0) {
+        m_heapTimer.start();
+    } else {
+        m_heapTimer.stop();
+    }
+}
+
+void DevToolsCapture::startCpuProfile(int samplingIntervalUs)
+{
+    if (m_profiling) {
+        return;
+    }
+    m_profiling = true;
+    send(QStringLiteral("Profiler.enable"), QJsonObject());
+    send(QStringLiteral("Profiler.setSamplingInterval"),
+         QJsonObject{{QStringLiteral("interval"), qMax(50, samplingIntervalUs)}});
+    send(QStringLiteral("Profiler.start"), QJsonObject(), [this](const QJsonObject &, const QString &error) {
+        if (!error.isEmpty()) {
+            m_profiling = false;
+            emit captureFailed(QStringLiteral("cpu"), error);
+            return;
+        }
+        qInfo() << "DevToolsCapture: CPU profile started";
+    });
+}
+
+void DevToolsCapture::stopCpuProfile()
+{
+    if (!m_profiling) {
+        return;
+    }
+    m_profiling = false;
+    send(QStringLiteral("Profiler.stop"), QJsonObject(), [this](const QJsonObject &result, const QString &error) {
+        if (!error.isEmpty()) {
+            emit captureFailed(QStringLiteral("cpu"), error);
+            return;
+        }
+        const QString path = outputPath(QStringLiteral("cpu"), QStringLiteral("cpuprofile"));
+        QSaveFile *file = openCapture(QStringLiteral("cpu"), path);
+        if (!file) {
+            return;
+        }
+        file->write(QJsonDocument(result.value(QStringLiteral("profile")).toObject()).toJson(QJsonDocument::Compact));
+        finishCapture(QStringLiteral("cpu"), file);
+    });
+}
+
+void DevToolsCapture::takeHeapSnapshot()
+{
+    if (m_heapFile) {
+        return; // One at a time; they take seconds and hundreds of megabytes
+    }
+    m_heapFile = openCapture(QStringLiteral("heap"), outputPath(QStringLiteral("heap"), QStringLiteral("heapsnapshot")));
+    if (!m_heapFile) {
+        return;
+    }
+    qInfo() << "DevToolsCapture: taking heap snapshot";
+    send(QStringLiteral("HeapProfiler.enable"), QJsonObject());
+    // The chunks arrive as events before the reply
+    send(QStringLiteral("HeapProfiler.takeHeapSnapshot"), QJsonObject{{QStringLiteral("reportProgress"), false}},
+         [this](const QJsonObject &, const QString &error) {
+        if (!error.isEmpty()) {
+            abortCapture(QStringLiteral("heap"), m_heapFile, error);
+            return;
+        }
+        finishCapture(QStringLiteral("heap"), m_heapFile);
+    });
+}
+
+void DevToolsCapture::startTrace(const QString &categories)
+{
+    if (m_traceFile) {
+        return;
+    }
+    m_traceFile = openCapture(QStringLiteral("trace"), outputPath(QStringLiteral("trace"), QStringLiteral("json")));
+    if (!m_traceFile) {
+        return;
+    }
+    m_traceFile->write("{\"traceEvents\":[");
+    m_traceHasEvents = false;
+    const QString included = categories.isEmpty() ? QString::fromLatin1(kDefaultTraceCategories) : categories;
+    QJsonObject config;
+    config.insert(QStringLiteral("includedCategories"),
+                  QJsonArray::fromStringList(included.split(QLatin1Char(','), Qt::SkipEmptyParts)));
+    QJsonObject params;
+    params.insert(QStringLiteral("transferMode"), QStringLiteral("ReportEvents"));
+    params.insert(QStringLiteral("traceConfig"), config);
+    send(QStringLiteral("Tracing.start"), params, [this](const QJsonObject &, const QString &error) {
+        if (!error.isEmpty()) {
+            abortCapture(QStringLiteral("trace"), m_traceFile, error);
+            return;
+        }
+        qInfo() << "DevToolsCapture: trace started";
+    });
+}
+
+void DevToolsCapture::stopTrace()
+{
+    if (!m_traceFile) {
+        return;
+    }
+    // The events follow as Tracing.dataCollected, then Tracing.tracingComplete
+    send(QStringLiteral("Tracing.end"), QJsonObject(), [this](const QJsonObject &, const QString &error) {
+        if (!error.isEmpty()) {
+            abortCapture(QStringLiteral("trace"), m_traceFile, error);
+        }
+    });
+}
+
+QJsonObject DevToolsCapture::status() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("connected"), m_socket.state() == QAbstractSocket::ConnectedState);
+    object.insert(QStringLiteral("cpuProfiling"), m_profiling);
+    object.insert(QStringLiteral("heapSnapshotInProgress"), m_heapFile != nullptr);
+    object.insert(QStringLiteral("tracing"), m_traceFile != nullptr);
+    if (m_heapThresholdMb > 0) {
+        object.insert(QStringLiteral("heapUsedMb"), m_heapUsedMb);
+        object.insert(QStringLiteral("heapThresholdMb"), m_heapThresholdMb);
+        object.insert(QStringLiteral("heapThresholdHit"), m_heapThresholdHit);
+    }
+    return object;
+}
+
+void DevToolsCapture::send(const QString &method, const QJsonObject &params, Callback callback)
+{
+    if (m_socket.state() != QAbstractSocket::ConnectedState) {
+        m_queued.append({method, params, std::move(callback)});
+        connectToPage();
+        return;
+    }
+    const int id = m_nextId++;
+    if (callback) {
+        m_callbacks.insert(id, std::move(callback));
+    }
+    QJsonObject message;
+    message.insert(QStringLiteral("id"), id);
+    message.insert(QStringLiteral("method"), method);
+    message.insert(QStringLiteral("params"), params);
+    m_socket.sendTextMessage(QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact)));
+}
+
+void DevToolsCapture::connectToPage()
+{
+    if (m_connecting || !m_page) {
+        return;
+    }
+    m_connecting = true;
+    // The debugging server lists one target per page; pick ours by URL
+    QNetworkRequest request(QUrl(QString("http://127.0.0.1:%1/json/list").arg(m_port)));
+    QNetworkReply *reply = m_network.get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        reply->deleteLater();
+        if (reply->error() != QNetworkReply::NoError) {
+            m_connecting = false;
+            failPending(QString("DevTools port %1 not reachable: %2").arg(m_port).arg(reply->errorString()));
+            return;
+        }
+        const QString pageUrl = m_page ? m_page->url().toString() : QString();
+        QString socketUrl;
+        const QJsonArray targets = QJsonDocument::fromJson(reply->readAll()).array();
+        for (const QJsonValue &value : targets) {
+            const QJsonObject target = value.toObject();
+            if (target.value(QStringLiteral("type")).toString() != QLatin1String("page")) {
+                continue;
+            }
+            const QString url = target.value(QStringLiteral("webSocketDebuggerUrl")).toString();
+            if (target.value(QStringLiteral("url")).toString() == pageUrl) {
+                socketUrl = url;
+                break;
+            }
+            if (socketUrl.isEmpty()) {
+                socketUrl = url;
+            }
+        }
+        if (socketUrl.isEmpty()) {
+            m_connecting = false;
+            // No URL means another DevTools client is attached to the page
+            failPending(QStringLiteral("no debuggable page target (is the inspector open?)"));
+            return;
+        }
+        // QWebSocket sends no Origin header without one set, which the
+        // debugging server accepts without --remote-allow-origins
+        m_socket.open(QUrl(socketUrl));
+    });
+}
+
+void DevToolsCapture::onConnected()
+{
+    m_connecting = false;
+    const QList<Command> queued = m_queued;
+    m_queued.clear();
+    for (const Command &command : queued) {
+        send(command.method, command.params, command.callback);
+    }
+}
+
+void DevToolsCapture::onMessage(const QString &text)
+{
+    const QJsonObject message = QJsonDocument::fromJson(text.toUtf8()).object();
+    if (message.contains(QStringLiteral("id"))) {
+        const Callback callback = m_callbacks.take(message.value(QStringLiteral("id")).toInt());
+        if (callback) {
+            const QString error = message.value(QStringLiteral("error")).toObject()
+                                      .value(QStringLiteral("message")).toString();
+            callback(message.value(QStringLiteral("result")).toObject(), error);
+        }
+        return;
+    }
+
+    const QString method = message.value(QStringLiteral("method")).toString();
+    const QJsonObject params = message.value(QStringLiteral("params")).toObject();
+    if (method == QLatin1String("HeapProfiler.addHeapSnapshotChunk")) {
+        if (m_heapFile) {
+            m_heapFile->write(params.value(QStringLiteral("chunk")).toString().toUtf8());
+        }
+    } else if (method == QLatin1String("Tracing.dataCollected")) {
+        if (m_traceFile) {
+            const QJsonArray events = params.value(QStringLiteral("value")).toArray();
+            for (const QJsonValue &event : events) {
+                if (m_traceHasEvents) {
+                    m_traceFile->write(",\n");
+                }
+                m_traceFile->write(QJsonDocument(event.toObject()).toJson(QJsonDocument::Compact));
+                m_traceHasEvents = true;
+            }
+        }
+    } else if (method == QLatin1String("Tracing.tracingComplete")) {
+        if (m_traceFile) {
+            m_traceFile->write("]}\n");
+            finishCapture(QStringLiteral("trace"), m_traceFile);
+        }
+    }
+}
+
+void DevToolsCapture::failPending(const QString &error)
+{
+    if (m_callbacks.isEmpty() && m_queued.isEmpty() && !m_profiling && !m_heapFile && !m_traceFile) {
+        return;
+    }
+    qWarning().noquote() << "DevToolsCapture:" << error;
+    QList<Callback> callbacks = m_callbacks.values();
+    m_callbacks.clear();
+    for (const Command &command : m_queued) {
+        callbacks.append(command.callback);
+    }
+    m_queued.clear();
+    for (const Callback &callback : callbacks) {
+        if (callback) {
+            callback(QJsonObject(), error);
+        }
+    }
+    m_profiling = false;
+    if (m_heapFile) {
+        abortCapture(QStringLiteral("heap"), m_heapFile, error);
+    }
+    if (m_traceFile) {
+        abortCapture(QStringLiteral("trace"), m_traceFile, error);
+    }
+}
+
+void DevToolsCapture::checkHeap()
+{
+    if (m_heapThresholdHit || !m_page) {
+        return;
+    }
+    send(QStringLiteral("Runtime.getHeapUsage"), QJsonObject(), [this](const QJsonObject &result, const QString &error) {
+        if (!error.isEmpty()) {
+            return;
+        }
+        m_heapUsedMb = result.value(QStringLiteral("usedSize")).toDouble() / (1024 * 1024);
+        Metrics::global().setGauge(QStringLiteral("devtools.jsHeapUsedMb"), m_heapUsedMb);
+        if (!m_heapThresholdHit && m_heapUsedMb > m_heapThresholdMb) {
+            m_heapThresholdHit = true;
+            qWarning() << "DevToolsCapture: JS heap at" << m_heapUsedMb << "MB, over the"
+                       << m_heapThresholdMb << "MB threshold";
+            takeHeapSnapshot();
+        }
+    });
+}
+
+QString DevToolsCapture::outputPath(const QString &kind, const QString &suffix) const
+{
+    return QDir(diagnosticsDirectory()).filePath(QString("devtools-%1-%2.%3")
+        .arg(kind, QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"), suffix));
+}
+
+QSaveFile *DevToolsCapture::openCapture(const QString &kind, const QString &path)
+{
+    QSaveFile *file = new QSaveFile(path);
+    if (!file->open(QIODevice::WriteOnly)) {
+        delete file;
+        qWarning() << "DevToolsCapture: could not write" << path;
+        emit captureFailed(kind, QString("could not write %1").arg(path));
+        return nullptr;
+    }
+    return file;
+}
+
+void DevToolsCapture::finishCapture(const QString &kind, QSaveFile *&file)
+{
+    QSaveFile *finished = file;
+    file = nullptr;
+    const QString path = finished->fileName();
+    const bool ok = finished->commit();
+    delete finished;
+    if (!ok) {
+        qWarning() << "DevToolsCapture: could not write" << path;
+        emit captureFailed(kind, QString("could not write %1").arg(path));
+        return;
+    }
+    qInfo() << "DevToolsCapture:" << kind << "capture written to" << path;
+    emit captureWritten(kind, path);
+}
+
+void DevToolsCapture::abortCapture(const QString &kind, QSaveFile *&file, const QString &error)
+{
+    if (file) {
+        file->cancelWriting();
+        delete file;
+        file = nullptr;
+    }
+    qWarning().noquote() << "DevToolsCapture:" << kind << "capture failed:" << error;
+    emit captureFailed(kind, error);
+}
@@ -0,0 +1,99 @@
+#ifndef DEVTOOLSCAPTURE_H
+#define DEVTOOLSCAPTURE_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+#include <QWebSocket>
+#include <functional>
+
+class QSaveFile;
+class QWebEnginePage;
+
+// Drives the Chrome DevTools protocol for the app's page from C++, to
+// capture renderer-side diagnostics without opening the inspector: JS CPU
+// profiles (.cpuprofile), heap snapshots (.heapsnapshot) and performance
+// traces (.json, Trace Event format). Each capture is written to the
+// diagnostics directory and can be opened in Chrome DevTools or Perfetto.
+//
+// QtWebEngine only speaks the protocol over its remote debugging port, so
+// enableRemoteDebugging() has to run before the first profile is created.
+// The port listens on 127.0.0.1 only.
+//
+// Captures are started from the page through the "devtools" channel object,
+// from the command line, or by a JS heap threshold that takes one snapshot
+// when the page's heap grows past it.
+class DevToolsCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    static void enableRemoteDebugging(quint16 port);
+
+    DevToolsCapture(QWebEnginePage *page, quint16 port, QObject *parent = nullptr);
+    ~DevToolsCapture() override;
+
+    // Polls the JS heap every few seconds and takes one heap snapshot when
+    // the used size exceeds `megabytes`; 0 disables
+    void setHeapThreshold(double megabytes);
+
+public slots:
+    void startCpuProfile(int samplingIntervalUs = 1000);
+    void stopCpuProfile();
+    void takeHeapSnapshot();
+    // Categories as in chrome://tracing; empty uses the DevTools defaults
+    void startTrace(const QString &categories = QString());
+    void stopTrace();
+    QJsonObject status() const;
+
+signals:
+    void captureWritten(const QString &kind, const QString &path);
+    void captureFailed(const QString &kind, const QString &error);
+
+private:
+    using Callback = std::function<void(const QJsonObject &result, const QString &error)>;
+
+    struct Command {
+        QString method;
+        QJsonObject params;
+        Callback callback;
+    };
+
+    void send(const QString &method, const QJsonObject &params, Callback callback = Callback());
+    void connectToPage();
+    void onConnected();
+    void onMessage(const QString &text);
+    void failPending(const QString &error);
+    void checkHeap();
+
+    QString outputPath(const QString &kind, const QString &suffix) const;
+    QSaveFile *openCapture(const QString &kind, const QString &path);
+    void finishCapture(const QString &kind, QSaveFile *&file);
+    void abortCapture(const QString &kind, QSaveFile *&file, const QString &error);
+
+    QPointer<QWebEnginePage> m_page;
+    quint16 m_port;
+    QNetworkAccessManager m_network;
+    QWebSocket m_socket;
+    bool m_connecting;
+    int m_nextId;
+    QHash<int, Callback> m_callbacks;
+    QList<Command> m_queued;
+
+    bool m_profiling;
+    QSaveFile *m_heapFile;
+    QSaveFile *m_traceFile;
+    bool m_traceHasEvents;
+
+    double m_heapThresholdMb;
+    bool m_heapThresholdHit;
+    double m_heapUsedMb;
+    QTimer m_heapTimer;
+};
+
+#endif // DEVTOOLSCAPTURE_H
@@ -0,0 +1,459 @@
+#include "guiprofiler.h"
+#include "app_setup.h"
+#include "metrics.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QPair>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+
+// Built with -DTAQYON_GUI_PROFILER=ON, on CPUs whose frame layout the
+// signal handler knows
+#if defined(Q_OS_LINUX) && defined(TAQYON_GUI_PROFILER) && (defined(__x86_64__) || defined(__aarch64__))
+#define TAQYON_GUI_SAMPLING 1
+#endif
+
+#ifdef TAQYON_GUI_SAMPLING
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+#endif
+
+namespace {
+
+const int kMaxFrames = 64;
+const quint32 kRingSize = 2048;
+const int kDrainIntervalMs = 250;
+const double kOverheadBudgetPercent = 2.0;
+
+#ifdef TAQYON_GUI_SAMPLING
+struct RawSample {
+    int depth;
+    void *frames[kMaxFrames];
+};
+
+// Shared with the signal handler, which may only touch lock-free atomics and
+// memory that already exists. The ring is allocated once and never freed, and
+// the handler stays installed, so a SIGPROF still pending after stop() is
+// harmless.
+RawSample *g_ring = nullptr;
+std::atomic<quint32> g_head(0);
+std::atomic<quint32> g_tail(0);
+std::atomic<bool> g_enabled(false);
+std::atomic<quint64> g_dropped(0);
+std::atomic<quint64> g_handlerNs(0);
+// The GUI thread's stack, the only memory the frame walk reads
+quintptr g_stackLow = 0;
+quintptr g_stackHigh = 0;
+
+int g_toggleFds[2] = { -1, -1 };
+
+qint64 monotonicNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return qint64(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// Follows the frame pointer chain from the interrupted context. Unlike
+// backtrace(), which may take the dynamic loader's lock to find unwind
+// tables, it only reads registers and the sampled thread's own stack, so it
+// is async-signal-safe. Frames of code built without frame pointers are
+// skipped or end the walk early.
+int walkFrames(const void *context, void **frames)
+{
+    const ucontext_t *uc = static_cast<const ucontext_t *>(context);
+#if defined(__x86_64__)
+    quintptr pc = quintptr(uc->uc_mcontext.gregs[REG_RIP]);
+    quintptr fp = quintptr(uc->uc_mcontext.gregs[REG_RBP]);
+#else
+    quintptr pc = quintptr(uc->uc_mcontext.pc);
+    quintptr fp = quintptr(uc->uc_mcontext.regs[29]);
+#endif
+    int depth = 0;
+    frames[depth++] = reinterpret_cast<void *>(pc);
+    // Each frame holds the caller's frame pointer, then the return address
+    while (depth < kMaxFrames && fp >= g_stackLow && fp + 2 * sizeof(quintptr) <= g_stackHigh
+           && fp % sizeof(quintptr) == 0) {
+        const quintptr *frame = reinterpret_cast<const quintptr *>(fp);
+        if (frame[1] == 0) {
+            break;
+        }
+        frames[depth++] = reinterpret_cast<void *>(frame[1]);
+        if (frame[0] <= fp) {
+            break; // Stacks grow down, so callers' frames are above
+        }
+        fp = frame[0];
+    }
+    return depth;
+}
+
+void sampleHandler(int, siginfo_t *, void *context)
+{
+    if (!g_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const int savedErrno = errno;
+    const qint64 started = monotonicNs();
+    const quint32 head = g_head.load(std::memory_order_relaxed);
+    if (head - g_tail.load(std::memory_order_acquire) >= kRingSize) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        RawSample &sample = g_ring[head % kRingSize];
+        sample.depth = walkFrames(context, sample.frames);
+        g_head.store(head + 1, std::memory_order_release);
+    }
+    g_handlerNs.fetch_add(quint64(monotonicNs() - started), std::memory_order_relaxed);
+    errno = savedErrno;
+}
+
+void toggleHandler(int)
+{
+    const int savedErrno = errno;
+    const char byte = 1;
+    ssize_t written = write(g_toggleFds[1], &byte, 1);
+    Q_UNUSED(written);
+    errno = savedErrno;
+}
+
+QString symbolize(quintptr address, bool leaf)
+{
+    // Return addresses point after the call; look up the call instruction
+    const quintptr lookup = leaf ? address : address - 1;
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(lookup), &info) == 0) {
+        return QString("0x%1").arg(address, 0, 16);
+    }
+    if (info.dli_sname) {
+        int status = 0;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        const QString name = QString::fromLatin1(status == 0 && demangled ? demangled : info.dli_sname);
+        free(demangled);
+        return name;
+    }
+    // Not exported: module and offset, for addr2line
+    return QString("%1+0x%2")
+        .arg(info.dli_fname ? QFileInfo(QString::fromLocal8Bit(info.dli_fname)).fileName() : QStringLiteral("?"))
+        .arg(lookup - reinterpret_cast<quintptr>(info.dli_fbase), 0, 16);
+}
+#endif
+
+} // namespace
+
+GuiProfiler::GuiProfiler(QObject *parent)
+    : QObject(parent)
+    , m_active(false)
+    , m_rateHz(0)
+    , m_wallClock(false)
+    , m_threadId(0)
+    , m_timer(nullptr)
+    , m_activeNs(0)
+    , m_drainNs(0)
+    , m_symbolizeNs(0)
+    , m_samples(0)
+    , m_overBudgetWarned(false)
+    , m_toggleNotifier(nullptr)
+{
+#ifdef TAQYON_GUI_SAMPLING
+    // Created on the GUI thread, which is the one sampled
+    m_threadId = static_cast<long>(syscall(SYS_gettid));
+#endif
+    m_drainTimer.setInterval(kDrainIntervalMs);
+    connect(&m_drainTimer, &QTimer::timeout, this, &GuiProfiler::drain);
+}
+
+GuiProfiler::~GuiProfiler()
+{
+    if (m_active) {
+        stop();
+    }
+}
+
+bool GuiProfiler::isSupported()
+{
+#ifdef TAQYON_GUI_SAMPLING
+    return true;
+#else
+    return false;
+#endif
+}
+
+void GuiProfiler::installToggleSignal()
+{
+#ifdef TAQYON_GUI_SAMPLING
+    if (m_toggleNotifier || pipe(g_toggleFds) != 0) {
+        return;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = toggleHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR2, &action, nullptr);
+    m_toggleNotifier = new QSocketNotifier(g_toggleFds[0], QSocketNotifier::Read, this);
+    connect(m_toggleNotifier, &QSocketNotifier::activated, this, [this]() {
+        char byte;
+        ssize_t count = read(g_toggleFds[0], &byte, 1);
+        Q_UNUSED(count);
+        toggle();
+    });
+#endif
+}
+
+bool GuiProfiler::start(int rateHz, bool wallClock)
+{
+#ifdef TAQYON_GUI_SAMPLING
+    if (m_active) {
+        return true;
+    }
+    if (rateHz < 1 || rateHz > 10000) {
+        qWarning() << "GuiProfiler: rate must be between 1 and 10000 Hz, got" << rateHz;
+        return false;
+    }
+    if (static_cast<long>(syscall(SYS_gettid)) != m_threadId) {
+        qWarning() << "GuiProfiler: start() has to be called on the GUI thread";
+        return false;
+    }
+
+    if (!g_ring) {
+        pthread_attr_t attributes;
+        void *stack = nullptr;
+        size_t stackSize = 0;
+        if (pthread_getattr_np(pthread_self(), &attributes) != 0) {
+            qWarning() << "GuiProfiler: could not find the GUI thread's stack";
+            return false;
+        }
+        pthread_attr_getstack(&attributes, &stack, &stackSize);
+        pthread_attr_destroy(&attributes);
+        g_stackLow = reinterpret_cast<quintptr>(stack);
+        g_stackHigh = g_stackLow + stackSize;
+        g_ring = new RawSample[kRingSize];
+    }
+    static bool handlerInstalled = false;
+    if (!handlerInstalled) {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = sampleHandler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_SIGINFO | SA_RESTART;
+        if (sigaction(SIGPROF, &action, nullptr) != 0) {
+            qWarning() << "GuiProfiler: could not install the SIGPROF handler";
+            return false;
+        }
+        handlerInstalled = true;
+    }
+
+    clockid_t clock = CLOCK_MONOTONIC;
+    if (!wallClock && pthread_getcpuclockid(pthread_self(), &clock) != 0) {
+        qWarning() << "GuiProfiler: no CPU-time clock for the GUI thread";
+        return false;
+    }
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = static_cast<pid_t>(m_threadId);
+    timer_t timer;
+    if (timer_create(clock, &event, &timer) != 0) {
+        qWarning() << "GuiProfiler: timer_create failed:" << strerror(errno);
+        return false;
+    }
+
+    m_stacks.clear();
+    m_samples = 0;
+    m_activeNs = 0;
+    m_drainNs = 0;
+    m_symbolizeNs = 0;
+    m_overBudgetWarned = false;
+    g_tail.store(g_head.load());
+    g_dropped.store(0);
+    g_handlerNs.store(0);
+    g_enabled.store(true);
+
+    const long intervalNs = 1000000000L / rateHz;
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = intervalNs / 1000000000L;
+    spec.it_interval.tv_nsec = intervalNs % 1000000000L;
+    spec.it_value = spec.it_interval;
+    timer_settime(timer, 0, &spec, nullptr);
+
+    m_timer = timer;
+    m_rateHz = rateHz;
+    m_wallClock = wallClock;
+    m_active = true;
+    m_clock.start();
+    m_drainTimer.start();
+    qInfo() << "GuiProfiler: sampling the GUI thread at" << rateHz << "Hz of"
+            << (wallClock ? "wall-clock" : "CPU") << "time";
+    emit activeChanged(true);
+    return true;
+#else
+    Q_UNUSED(rateHz);
+    Q_UNUSED(wallClock);
+    qWarning() << "GuiProfiler: not built in; configure with -DTAQYON_GUI_PROFILER=ON (Linux, x86-64 or ARM64)";
+    return false;
+#endif
+}
+
+QString GuiProfiler::stop()
+{
+#ifdef TAQYON_GUI_SAMPLING
+    if (!m_active) {
+        return QString();
+    }
+    g_enabled.store(false);
+    timer_delete(static_cast<timer_t>(m_timer));
+    m_timer = nullptr;
+    m_drainTimer.stop();
+    m_activeNs = m_clock.nsecsElapsed();
+    drain();
+    m_active = false;
+    emit activeChanged(false);
+
+    QElapsedTimer symbolizing;
+    symbolizing.start();
+    const QString path = writeFolded();
+    m_symbolizeNs = symbolizing.nsecsElapsed();
+
+    const QJsonObject summary = status();
+    qInfo().noquote() << QString("GuiProfiler: %1 samples in %2 s, %3 dropped, overhead %4% (%5% in the signal handler)")
+        .arg(m_samples).arg(m_activeNs / 1e9, 0, 'f', 1)
+        .arg(summary.value(QStringLiteral("dropped")).toInteger())
+        .arg(summary.value(QStringLiteral("overheadPercent")).toDouble(), 0, 'f', 2)
+        .arg(summary.value(QStringLiteral("handlerOverheadPercent")).toDouble(), 0, 'f', 2);
+    return path;
+#else
+    return QString();
+#endif
+}
+
+QJsonObject GuiProfiler::status() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("active"), m_active);
+    object.insert(QStringLiteral("rateHz"), m_rateHz);
+    object.insert(QStringLiteral("clock"), m_wallClock ? QStringLiteral("wall") : QStringLiteral("cpu"));
+    object.insert(QStringLiteral("samples"), qint64(m_samples));
+#ifdef TAQYON_GUI_SAMPLING
+    const qint64 elapsedNs = m_active ? m_clock.nsecsElapsed() : m_activeNs;
+    object.insert(QStringLiteral("dropped"), qint64(g_dropped.load()));
+    // Everything the profiler costs: the signal handler, counting the stacks
+    // and, once stopped, resolving symbols
+    const double overheadNs = double(g_handlerNs.load()) + m_drainNs + m_symbolizeNs;
+    object.insert(QStringLiteral("overheadPercent"), elapsedNs > 0 ? 100.0 * overheadNs / elapsedNs : 0.0);
+    object.insert(QStringLiteral("handlerOverheadPercent"),
+                  elapsedNs > 0 ? 100.0 * double(g_handlerNs.load()) / elapsedNs : 0.0);
+#endif
+    return object;
+}
+
+void GuiProfiler::drain()
+{
+#ifdef TAQYON_GUI_SAMPLING
+    QElapsedTimer draining;
+    draining.start();
+    const quint32 head = g_head.load(std::memory_order_acquire);
+    quint32 tail = g_tail.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail) {
+        const RawSample &sample = g_ring[tail % kRingSize];
+        if (sample.depth <= 0) {
+            continue;
+        }
+        // Root first, as folded stacks are written
+        QVector<quintptr> stack;
+        stack.reserve(sample.depth);
+        for (int i = sample.depth - 1; i >= 0; --i) {
+            stack.append(reinterpret_cast<quintptr>(sample.frames[i]));
+        }
+        ++m_stacks[stack];
+        ++m_samples;
+    }
+    g_tail.store(tail, std::memory_order_release);
+    m_drainNs += draining.nsecsElapsed();
+
+    if (m_active) {
+        const double overhead = status().value(QStringLiteral("overheadPercent")).toDouble();
+        Metrics::global().setGauge(QStringLiteral("profiler.overheadPercent"), overhead);
+        if (overhead > kOverheadBudgetPercent && m_clock.elapsed() > 5000 && !m_overBudgetWarned) {
+            m_overBudgetWarned = true;
+            qWarning() << "GuiProfiler: overhead" << overhead << "% is over budget; use a lower rate";
+        }
+    }
+#endif
+}
+
+void GuiProfiler::toggle()
+{
+    if (m_active) {
+        stop();
+    } else {
+        start(m_rateHz > 0 ? m_rateHz : 99, m_wallClock);
+    }
+}
+
+QString GuiProfiler::writeFolded() const
+{
+#ifdef TAQYON_GUI_SAMPLING
+    if (m_stacks.isEmpty()) {
+        qInfo() << "GuiProfiler: no samples, nothing written";
+        return QString();
+    }
+    QHash<quintptr, QString> names;
+    QList<QPair<QString, quint64>> lines;
+    for (auto it = m_stacks.constBegin(); it != m_stacks.constEnd(); ++it) {
+        QStringList frames;
+        const QVector<quintptr> &stack = it.key();
+        for (int i = 0; i < stack.size(); ++i) {
+            const bool leaf = i == stack.size() - 1;
+            auto name = names.find(stack.at(i));
+            if (name == names.end()) {
+                name = names.insert(stack.at(i), symbolize(stack.at(i), leaf));
+            }
+            frames << *name;
+        }
+        lines.append({frames.join(QLatin1Char(';')), it.value()});
+    }
+    std::sort(lines.begin(), lines.end(), [](const QPair<QString, quint64> &a, const QPair<QString, quint64> &b) {
+        return a.second > b.second;
+    });
+
+    const QString path = QDir(diagnosticsDirectory()).filePath(
+        QString("gui-profile-%1.folded").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss")));
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "GuiProfiler: could not write" << path;
+        return QString();
+    }
+    for (const auto &line : lines) {
+        file.write(line.first.toUtf8());
+        file.write(" ");
+        file.write(QByteArray::number(line.second));
+        file.write("\n");
+    }
+    if (!file.commit()) {
+        qWarning() << "GuiProfiler: could not write" << path;
+        return QString();
+    }
+    qInfo() << "GuiProfiler: folded stacks written to" << path;
+    return path;
+#else
+    return QString();
+#endif
+}
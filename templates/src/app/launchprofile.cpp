@@ -0,0 +1,198 @@
+#include "launchprofile.h"
+#include <QDebug>
+#include <QEvent>
+#include <QThread>
+#include <QTimer>
+#include <QWebEngineProfile>
+#include <QWidget>
+#include <climits>
+
+namespace {
+
+QString lifecycleStateName(QWebEnginePage::LifecycleState state)
+{
+    switch (state) {
+    case QWebEnginePage::LifecycleState::Active: return QStringLiteral("active");
+    case QWebEnginePage::LifecycleState::Frozen: return QStringLiteral("frozen");
+    case QWebEnginePage::LifecycleState::Discarded: return QStringLiteral("discarded");
+    }
+    return QString();
+}
+
+// Follows the window rather than the page, whose visibility also changes
+// when another tab is shown
+class HiddenWindowWatcher : public QObject
+{
+public:
+    HiddenWindowWatcher(QWebEnginePage *page, QWidget *window, QWebEnginePage::LifecycleState state, int delaySec)
+        : QObject(page)
+        , m_page(page)
+        , m_window(window)
+        , m_state(state)
+        , m_pageHidden(false)
+    {
+        m_timer.setSingleShot(true);
+        m_timer.setInterval(delaySec * 1000);
+        connect(&m_timer, &QTimer::timeout, this, &HiddenWindowWatcher::applyState);
+        window->installEventFilter(this);
+    }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (watched == m_window && (event->type() == QEvent::Show || event->type() == QEvent::Hide
+                                    || event->type() == QEvent::WindowStateChange)) {
+            update();
+        }
+        return false;
+    }
+
+private:
+    bool windowHidden() const { return !m_window->isVisible() || m_window->isMinimized(); }
+
+    void update()
+    {
+        if (windowHidden()) {
+            if (!m_timer.isActive() && m_page->lifecycleState() == QWebEnginePage::LifecycleState::Active) {
+                m_timer.start();
+            }
+            return;
+        }
+        m_timer.stop();
+        if (m_pageHidden) {
+            m_pageHidden = false;
+            m_page->setVisible(true);
+        }
+        if (m_page->lifecycleState() != QWebEnginePage::LifecycleState::Active) {
+            // A discarded page reloads here
+            m_page->setLifecycleState(QWebEnginePage::LifecycleState::Active);
+        }
+    }
+
+    void applyState()
+    {
+        if (!windowHidden()) {
+            return;
+        }
+        // A minimized window may leave the page visible, which blocks the change
+        if (m_page->isVisible()) {
+            m_pageHidden = true;
+            m_page->setVisible(false);
+        }
+        qInfo().noquote() << "Hidden page is now" << lifecycleStateName(m_state);
+        m_page->setLifecycleState(m_state);
+    }
+
+    QWebEnginePage *m_page;
+    QWidget *m_window;
+    QWebEnginePage::LifecycleState m_state;
+    bool m_pageHidden;
+    QTimer m_timer;
+};
+
+} // namespace
+
+QByteArray LaunchProfile::chromiumFlags() const
+{
+    QByteArrayList flags;
+    if (rendererProcessLimit > 0) {
+        flags << "--renderer-process-limit=" + QByteArray::number(rendererProcessLimit);
+    }
+    if (v8MaxOldSpaceMb > 0) {
+        // QTWEBENGINE_CHROMIUM_FLAGS is split at spaces, so only one V8 flag fits
+        flags << "--js-flags=--max-old-space-size=" + QByteArray::number(v8MaxOldSpaceMb);
+    }
+    if (lowEndDeviceMode) {
+        flags << "--enable-low-end-device-mode";
+    }
+    if (rasterThreads > 0) {
+        flags << "--num-raster-threads=" + QByteArray::number(rasterThreads);
+    }
+    return flags.join(' ');
+}
+
+void LaunchProfile::applyTo(QWebEngineProfile *profile) const
+{
+    if (httpCacheBytes > 0) {
+        profile->setHttpCacheMaximumSize(int(qMin<qint64>(httpCacheBytes, INT_MAX)));
+    }
+}
+
+QJsonObject LaunchProfile::toJson() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("name"), name);
+    object.insert(QStringLiteral("chromiumFlags"), QString::fromLatin1(chromiumFlags()));
+    object.insert(QStringLiteral("httpCacheBytes"), httpCacheBytes);
+    object.insert(QStringLiteral("assetCacheBytes"), assetCacheBytes);
+    object.insert(QStringLiteral("memoCacheBytes"), memoCacheBytes);
+    object.insert(QStringLiteral("apiThreads"), apiThreads);
+    object.insert(QStringLiteral("backgroundThreads"), backgroundThreads);
+    object.insert(QStringLiteral("hiddenPageState"), lifecycleStateName(hiddenPageState));
+    object.insert(QStringLiteral("hiddenPageDelaySec"), hiddenPageDelaySec);
+    object.insert(QStringLiteral("freezeBackgroundTabsSec"), freezeBackgroundTabsSec);
+    object.insert(QStringLiteral("maxLiveTabs"), maxLiveTabs);
+    object.insert(QStringLiteral("tabMemoryBudgetMb"), tabMemoryBudgetMb);
+    return object;
+}
+
+QStringList LaunchProfile::names()
+{
+    return {QStringLiteral("low-memory"), QStringLiteral("balanced"), QStringLiteral("throughput")};
+}
+
+bool LaunchProfile::fromName(const QString &name, LaunchProfile &profile, QString &error)
+{
+    LaunchProfile result;
+    result.name = name;
+    if (name == QLatin1String("low-memory")) {
+        result.rendererProcessLimit = 1;
+        result.v8MaxOldSpaceMb = 256;
+        result.lowEndDeviceMode = true;
+        result.httpCacheBytes = 16 * 1024 * 1024;
+        result.assetCacheBytes = 4 * 1024 * 1024;
+        result.memoCacheBytes = 2 * 1024 * 1024;
+        result.apiThreads = 2;
+        result.backgroundThreads = 2;
+        result.hiddenPageState = QWebEnginePage::LifecycleState::Discarded;
+        result.hiddenPageDelaySec = 60;
+        result.freezeBackgroundTabsSec = 30;
+        result.maxLiveTabs = 3;
+        result.tabMemoryBudgetMb = 1536;
+    } else if (name == QLatin1String("balanced")) {
+        // The defaults
+    } else if (name == QLatin1String("throughput")) {
+        result.v8MaxOldSpaceMb = 4096;
+        result.rasterThreads = 4;
+        result.httpCacheBytes = 256 * 1024 * 1024;
+        result.assetCacheBytes = 256 * 1024 * 1024;
+        result.memoCacheBytes = 128 * 1024 * 1024;
+        result.apiThreads = 2 * QThread::idealThreadCount();
+        result.backgroundThreads = QThread::idealThreadCount();
+        result.freezeBackgroundTabsSec = 0;
+        result.maxLiveTabs = 0;
+    } else {
+        error = QString("unknown launch profile \"%1\" (expected %2)").arg(name, names().join(QStringLiteral(", ")));
+        return false;
+    }
+    profile = result;
+    return true;
+}
+
+void applyChromiumFlags(const LaunchProfile &profile)
+{
+    const QByteArray own = profile.chromiumFlags();
+    if (own.isEmpty()) {
+        return;
+    }
+    const QByteArray flags = qgetenv("QTWEBENGINE_CHROMIUM_FLAGS") + ' ' + own;
+    qputenv("QTWEBENGINE_CHROMIUM_FLAGS", flags.trimmed());
+}
+
+void applyHiddenPagePolicy(QWebEnginePage *page, QWidget *window, const LaunchProfile &profile)
+{
+    if (profile.hiddenPageState == QWebEnginePage::LifecycleState::Active) {
+        return;
+    }
+    new HiddenWindowWatcher(page, window, profile.hiddenPageState, profile.hiddenPageDelaySec);
+}
@@ -0,0 +1,69 @@
+#ifndef LAUNCHPROFILE_H
+#define LAUNCHPROFILE_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QWebEnginePage>
+
+class QWebEngineProfile;
+class QWidget;
+
+// Named trade-offs between speed and memory, chosen with --launch-profile:
+//   low-memory  one renderer process, a small V8 heap, Chromium's low-end
+//               device mode, small caches and worker pools, hidden pages
+//               discarded after a minute (they reload when shown again) and
+//               at most three live tabs within 1.5 GB
+//   balanced    Chromium's and the app's defaults; the default profile
+//   throughput  a large V8 heap, more raster threads, large caches and pools,
+//               and background tabs that are never frozen or discarded
+//
+// Chromium flags have to be applied before the web engine starts, the rest
+// as the app sets up the corresponding component. The active profile is
+// logged and published as the "launchProfile" metrics collector.
+struct LaunchProfile {
+    QString name;
+
+    // Chromium and V8; 0 keeps Chromium's default
+    int rendererProcessLimit = 0;
+    int v8MaxOldSpaceMb = 0;
+    bool lowEndDeviceMode = false;
+    int rasterThreads = 0;
+
+    // Caches; 0 keeps the default
+    qint64 httpCacheBytes = 0;
+    qint64 assetCacheBytes = 32 * 1024 * 1024;
+    qint64 memoCacheBytes = 16 * 1024 * 1024;
+
+    // Worker pools for API handlers and background writes; 0 keeps the default
+    int apiThreads = 0;
+    int backgroundThreads = 0;
+
+    // What happens to the page while its window is hidden
+    QWebEnginePage::LifecycleState hiddenPageState = QWebEnginePage::LifecycleState::Active;
+    int hiddenPageDelaySec = 0;
+
+    // Background tabs: frozen after a while, discarded beyond the budgets; 0 for none
+    int freezeBackgroundTabsSec = 300;
+    int maxLiveTabs = 8;
+    int tabMemoryBudgetMb = 0;
+
+    QByteArray chromiumFlags() const;
+    void applyTo(QWebEngineProfile *profile) const;
+    QJsonObject toJson() const;
+
+    static QStringList names();
+    static bool fromName(const QString &name, LaunchProfile &profile, QString &error);
+};
+
+// Applies the profile's Chromium flags through QTWEBENGINE_CHROMIUM_FLAGS,
+// after any flags already set there
+void applyChromiumFlags(const LaunchProfile &profile);
+
+// Moves the page to the profile's hidden state once its window has been
+// hidden or minimized for the configured delay, and back to active when the
+// window is shown again. Switching tabs does not count as hidden.
+void applyHiddenPagePolicy(QWebEnginePage *page, QWidget *window, const LaunchProfile &profile);
+
+#endif // LAUNCHPROFILE_H
@@ -3,14 +3,57 @@
 #include <QWebEngineProfile>
 #include <QWebEngineSettings>
 #include <QWebChannel>
+#include <QPointer>
+#include <QTimer>
+#include <QThreadPool>
+#include <memory>
 #include <QFile>
+#include <QScopeGuard>
 #include <QFileInfo>
+#include <QDir>
 #include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include "mywebview.h"
 #include "mywebpage.h"
 #include "../backend/backendobject.h"
 #include "mainwindow.h"
+#include "tabmanager.h"
 #include "app_setup.h"
+#include "launchprofile.h"
+#include "taqyonscheme.h"
+#include "responsecache.h"
+#include "apirequestinterceptor.h"
+#include "assetcache.h"
+#include "routeprefetcher.h"
+#include "shutdowncoordinator.h"
+#include "sessionstore.h"
+#include "plotoverlay.h"
+#include "bridgeendpoint.h"
+#include "apirouter.h"
+#include "metrics.h"
+#include "bridgerecorder.h"
+#include "replaytransport.h"
+#include "soaktest.h"
+#include "transportconditions.h"
+#include "guiprofiler.h"
+#ifdef TAQYON_WEBSOCKETS
+#include "devtoolscapture.h"
+#endif
+#include "allocationtracker.h"
+#include "startuptrace.h"
+#include "startupsplash.h"
+#include "pluginregistry.h"
+#include "pluginhotreloader.h"
+#ifdef TAQYON_WEBSOCKETS
+#include "websocketbridge.h"
+#endif
+#include "memocache.h"
+#include "../bench/benchmarkrunner.h"
+#include "../bench/corebenchmarks.h"
+#include "../bench/renderbenchmarks.h"
+#include "../bench/servebenchmarks.h"
+#include "../bench/windowbenchmarks.h"
 
 // Custom message handler for logging (as before)
 void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg) {
@@ -23,6 +66,7 @@ void messageHandler(QtMsgType type, const QMessageLogContext &context, const QSt
     case QtFatalMsg:    logMessage = QString("Fatal: %1").arg(msg); break;
     }
     fprintf(stderr, "%s\n", qPrintable(logMessage));
+    appendToLogFile(logMessage);
 }
 
 int main(int argc, char *argv[]) {
@@ -32,6 +76,36 @@ int main(int argc, char *argv[]) {
     QCoreApplication::setOrganizationName("Taqyon");
     QCoreApplication::setApplicationVersion("1.0.0");
 
+    // Launch milestones are timed from here
+    StartupTrace startupTrace;
+
+    // Benchmarks measure the app, not the display server: use the offscreen
+    // platform unless one was chosen explicitly
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        for (int i = 1; i < argc; ++i) {
+            const QByteArray argument(argv[i]);
+            if (argument == "--benchmark" || argument.startsWith("--benchmark=")) {
+                qputenv("QT_QPA_PLATFORM", "offscreen");
+                break;
+            }
+        }
+    }
+
+    // Custom schemes have to be known before the web engine starts
+    registerTaqyonUrlScheme();
+
+    // The log file is closed last, after the teardown the watchdog times, so
+    // the watchdog's lines reach it on every path out of main()
+    QFile *logFile = nullptr;
+    const auto logFileCloser = qScopeGuard([&logFile]() {
+        closeLogFile();
+        delete logFile;
+    });
+
+    // Declared before QApplication so it also bounds the WebEngine teardown
+    // that happens when the application object is destroyed
+    ShutdownWatchdog shutdownWatchdog;
+
     QApplication app(argc, argv);
 
     // Command-line parser and options
@@ -40,19 +114,188 @@ int main(int argc, char *argv[]) {
     parser.process(QCoreApplication::arguments());
     AppOptions options = parseCommandLine(parser);
 
+    // The previous run's last frame decodes while the web engine starts; a
+    // frame saved while the option was on is deleted once it is off
+    if (!options.lastFrameSplash) {
+        removeLastFrame();
+    } else if (options.benchmarks.isEmpty()) {
+        preloadLastFrame();
+    }
+
     // Logging
-    if (options.verbose) {
+    if (options.verbose || !options.logFilePath.isEmpty()) {
         qInstallMessageHandler(messageHandler);
+    }
+    if (options.verbose) {
         qInfo() << "Verbose mode enabled";
         qInfo() << "Application directory:" << QCoreApplication::applicationDirPath();
     }
-    QFile *logFile = nullptr;
     setupLogging(options, logFile);
 
+    // Allocation accounting, as early as possible so startup is included
+    if (options.trackAllocations && AllocationTracker::enable()) {
+        Metrics::global().addCollector(QStringLiteral("allocations"), []() {
+            return AllocationTracker::snapshot();
+        });
+    }
+
+    // Memory and speed trade-offs for Chromium, V8, caches and worker pools
+    LaunchProfile launchProfile;
+    QString launchProfileError;
+    if (!LaunchProfile::fromName(options.launchProfile, launchProfile, launchProfileError)) {
+        qCritical() << "Invalid --launch-profile:" << launchProfileError;
+        return 1;
+    }
+    qInfo().noquote() << "Launch profile:" << QJsonDocument(launchProfile.toJson()).toJson(QJsonDocument::Compact);
+    Metrics::global().addCollector(QStringLiteral("launchProfile"), [launchProfile]() {
+        return launchProfile.toJson();
+    });
+    if (launchProfile.backgroundThreads > 0) {
+        QThreadPool::globalInstance()->setMaxThreadCount(launchProfile.backgroundThreads);
+    }
+
+    // Results of memoized backend methods, kept across runs; see docs/memoization.md
+    MemoCache::global().setMaxMemoryBytes(launchProfile.memoCacheBytes);
+    if (options.clearMemoCache) {
+        MemoCache::global().clear();
+    }
+    Metrics::global().addCollector(QStringLiteral("memo"), []() {
+        return MemoCache::global().stats();
+    });
+
+    // Shutdown: hide, flush in parallel, then bounded teardown
+    ShutdownCoordinator shutdownCoordinator(&shutdownWatchdog);
+    shutdownCoordinator.setTeardownDeadline(options.shutdownDeadlineMs);
+    shutdownCoordinator.addFlushTask(QStringLiteral("background-writes"), []() {
+        // Response cache and memo entries, and other fire-and-forget disk writes
+        QThreadPool::globalInstance()->waitForDone(1500);
+    });
+
+    // Chromium reads its flags when the web engine starts, with the first profile
+    applyChromiumFlags(launchProfile);
+    if (options.softwareRendering) {
+        const QByteArray flags = qgetenv("QTWEBENGINE_CHROMIUM_FLAGS") + " --disable-gpu --disable-gpu-compositing";
+        qputenv("QTWEBENGINE_CHROMIUM_FLAGS", flags.trimmed());
+        qInfo() << "Software rendering: Chromium flags" << flags.trimmed();
+    }
+
+#ifdef TAQYON_WEBSOCKETS
+    // The DevTools protocol is only served on the remote debugging port,
+    // which has to be configured before the web engine starts
+    if (options.devToolsPort > 0) {
+        DevToolsCapture::enableRemoteDebugging(options.devToolsPort);
+        qInfo() << "DevTools protocol on 127.0.0.1:" << options.devToolsPort;
+    }
+#endif
+
+    // taqyon:// scheme, owned by the profile
+    QWebEngineProfile *profile = QWebEngineProfile::defaultProfile();
+    TaqyonSchemeHandler *schemeHandler = new TaqyonSchemeHandler(profile);
+    profile->installUrlSchemeHandler(TaqyonSchemeHandler::schemeName(), schemeHandler);
+    launchProfile.applyTo(profile);
+
+    // Optional response cache for remote API routes
+    if (!options.apiCacheConfig.isEmpty()) {
+        ResponseCache *responseCache = new ResponseCache(profile);
+        if (responseCache->loadConfig(options.apiCacheConfig)) {
+            profile->setUrlRequestInterceptor(new ApiRequestInterceptor(responseCache, profile));
+            schemeHandler->addHost(QStringLiteral("cache"), [responseCache](QWebEngineUrlRequestJob *job) {
+                if (job->requestMethod() != "GET") {
+                    job->fail(QWebEngineUrlRequestJob::RequestDenied);
+                    return;
+                }
+                QPointer<QWebEngineUrlRequestJob> guard(job);
+                responseCache->fetch(ApiRequestInterceptor::remoteUrlFrom(job->requestUrl()),
+                                     ApiRequestInterceptor::requestHeadersFrom(job->requestUrl()),
+                                     [guard, responseCache](const ResponseCache::Response &response, bool ok) {
+                    if (!guard) {
+                        return; // Request was cancelled by the page
+                    }
+                    if (!ok) {
+                        guard->fail(QWebEngineUrlRequestJob::RequestFailed);
+                        return;
+                    }
+                    if (response.isPassThrough()) {
+                        // The page gets the real status from the network
+                        guard->redirect(responseCache->passThrough(response.url));
+                        return;
+                    }
+                    // Reached by redirect from the page's cross-origin API request
+                    QMultiMap<QByteArray, QByteArray> headers;
+                    headers.insert("Access-Control-Allow-Origin", "*");
+                    TaqyonSchemeHandler::replyWithData(guard, response.contentType, response.body, headers);
+                });
+            });
+            Metrics::global().addCollector(QStringLiteral("responseCache"), [responseCache]() {
+                const ResponseCache::Stats stats = responseCache->stats();
+                QJsonObject object;
+                object.insert(QStringLiteral("hits"), qint64(stats.hits));
+                object.insert(QStringLiteral("staleHits"), qint64(stats.staleHits));
+                object.insert(QStringLiteral("misses"), qint64(stats.misses));
+                object.insert(QStringLiteral("coalesced"), qint64(stats.coalesced));
+                object.insert(QStringLiteral("upstreamFetches"), qint64(stats.upstreamFetches));
+                object.insert(QStringLiteral("upstreamErrors"), qint64(stats.upstreamErrors));
+                object.insert(QStringLiteral("uncacheable"), qint64(stats.uncacheable));
+                object.insert(QStringLiteral("passedThrough"), qint64(stats.passedThrough));
+                return object;
+            });
+        } else {
+            qWarning() << "API response cache disabled";
+            delete responseCache;
+        }
+    }
+
+    // fetch() endpoints under taqyon://api/, handled on a worker pool
+    ApiRouter apiRouter;
+    if (launchProfile.apiThreads > 0) {
+        apiRouter.setMaxThreadCount(launchProfile.apiThreads);
+    }
+    apiRouter.addRoute("GET", QStringLiteral("/metrics"), [](const ApiRequest &) {
+        return ApiResponse::json(Metrics::global().snapshot());
+    }, ApiRouter::RunOnGuiThread);
+    schemeHandler->addHost(QStringLiteral("api"), [&apiRouter](QWebEngineUrlRequestJob *job) {
+        apiRouter.handleRequest(job);
+    });
+    if (options.verbose) {
+        QObject::connect(&shutdownCoordinator, &ShutdownCoordinator::aboutToShutdown, []() {
+            qInfo().noquote() << "Metrics:" << QJsonDocument(Metrics::global().snapshot()).toJson(QJsonDocument::Compact);
+        });
+    }
+
+    // Benchmark suite: runs without the main window, then exits
+    if (!options.benchmarks.isEmpty()) {
+        BenchmarkEnvironment environment;
+        environment.profile = profile;
+        environment.schemeHandler = schemeHandler;
+        environment.frontendUrl = resolveFrontendUrl(parser);
+        if (environment.frontendUrl.isLocalFile()) {
+            environment.frontendRoot = QFileInfo(environment.frontendUrl.toLocalFile()).absolutePath();
+        }
+        BenchmarkRunner runner;
+        runner.setPerfCountersEnabled(options.perfCounters);
+        if (options.benchmarkScale > 0) {
+            runner.setIterationScale(options.benchmarkScale);
+        }
+        if (options.benchmarkWindows > 0) {
+            environment.windowCount = options.benchmarkWindows;
+        }
+        runner.setReportPath(options.benchmarkReportPath);
+        runner.setReportField(QStringLiteral("launchProfile"), launchProfile.toJson());
+        registerCoreBenchmarks(runner, environment);
+        registerServeBenchmarks(runner, environment);
+        registerRenderBenchmarks(runner, environment);
+        registerWindowBenchmarks(runner, environment);
+        return runner.run(options.benchmarks);
+    }
+
     // Web view and page
     MyWebView *webView = new MyWebView();
-    MyWebPage *webPage = new MyWebPage(QWebEngineProfile::defaultProfile(), webView);
+    MyWebPage *webPage = new MyWebPage(profile, webView);
     webView->setPage(webPage);
+    // Owned here until the main window takes it, so that paths returning
+    // before then, such as the headless replay, release the page before the
+    // profile goes away
+    std::unique_ptr<MyWebView> webViewOwner(webView);
 
     // Web engine settings
     webPage->settings()->setAttribute(QWebEngineSettings::JavascriptEnabled, true);
@@ -70,23 +313,288 @@ int main(int argc, char *argv[]) {
     }
     channel.registerObject(QStringLiteral("backend"), &backend);
     webPage->setWebChannel(&channel);
+    if (AllocationTracker::isEnabled()) {
+        AllocationTracker::trackChannel(&channel);
+    }
+
+    // The same backend over fetch(), for Web Workers
+    BridgeEndpoint bridgeEndpoint;
+    bridgeEndpoint.registerObject(QStringLiteral("backend"), &backend);
+    schemeHandler->addHost(QStringLiteral("bridge"), [&bridgeEndpoint](QWebEngineUrlRequestJob *job) {
+        bridgeEndpoint.handleRequest(job);
+    });
+
+    // Frontend session state, restored at document creation
+    SessionStore sessionStore;
+    if (options.freshSession) {
+        sessionStore.clear();
+    } else {
+        sessionStore.load();
+    }
+    sessionStore.attachToPage(webPage);
+    channel.registerObject(QStringLiteral("session"), &sessionStore);
+    shutdownCoordinator.addFlushTask(QStringLiteral("session"), [&sessionStore]() {
+        sessionStore.writeNow();
+    });
+
+    // The bridge reports when the UI is usable; see docs/startup-splash.md
+    channel.registerObject(QStringLiteral("startup"), &startupTrace);
+
+    // Backend services shipped as plugins: listed from their metadata, and
+    // loaded when the page first asks for one
+    PluginRegistry pluginRegistry;
+    pluginRegistry.setStartupTrace(&startupTrace);
+    pluginRegistry.scan(options.pluginDir);
+    channel.registerObject(QStringLiteral("plugins"), &pluginRegistry);
+    auto publishPlugin = [&bridgeEndpoint](const QString &name, QObject *object) {
+        bridgeEndpoint.registerObject(name, object);  // Workers reach it once loaded
+    };
+    QObject::connect(&pluginRegistry, &PluginRegistry::loaded, &pluginRegistry, publishPlugin);
+    QObject::connect(&pluginRegistry, &PluginRegistry::reloaded, &pluginRegistry, publishPlugin);
+    std::unique_ptr<PluginHotReloader> pluginHotReloader;
+    if (options.hotReloadPlugins) {
+        pluginRegistry.setShadowCopyDir(QDir::temp().filePath(
+            QString("%1-plugins-%2").arg(appName).arg(QCoreApplication::applicationPid())));
+        pluginHotReloader.reset(new PluginHotReloader(&pluginRegistry));
+        pluginHotReloader->setBuildCommand(options.pluginSourceDir, options.pluginBuildCommand);
+        pluginHotReloader->start();
+    }
+    Metrics::global().addCollector(QStringLiteral("plugins"), [&pluginRegistry]() {
+        return pluginRegistry.stats();
+    });
+
+#ifdef TAQYON_WEBSOCKETS
+    // The same channel over a local WebSocket, for the frontend running in
+    // an external browser; see docs/bridge-websocket.md
+    std::unique_ptr<WebSocketBridge> webSocketBridge;
+    if (options.bridgeWebSocketPort > 0) {
+        webSocketBridge.reset(new WebSocketBridge(&channel));
+        if (!options.devServerUrl.isEmpty()) {
+            webSocketBridge->setAllowedOrigins({QUrl(options.devServerUrl).adjusted(
+                QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment).toString()});
+        }
+        if (webSocketBridge->listen(options.bridgeWebSocketPort)) {
+            WebSocketBridge *bridge = webSocketBridge.get();
+            Metrics::global().addCollector(QStringLiteral("bridgeWebSocket"), [bridge]() {
+                return bridge->stats();
+            });
+        } else {
+            webSocketBridge.reset();
+        }
+    }
+#endif
+
+    // Native plots composited over placeholder elements of the page
+    PlotOverlay plotOverlay(webView);
+    channel.registerObject(QStringLiteral("plots"), &plotOverlay);
+
+    // Sampling profiler for the GUI thread: --profile-gui, SIGUSR2 or the page
+    GuiProfiler guiProfiler;
+    guiProfiler.installToggleSignal();
+    channel.registerObject(QStringLiteral("profiler"), &guiProfiler);
+    Metrics::global().addCollector(QStringLiteral("profiler"), [&guiProfiler]() {
+        return guiProfiler.status();
+    });
+    QObject::connect(&shutdownCoordinator, &ShutdownCoordinator::aboutToShutdown, &guiProfiler, &GuiProfiler::stop);
+    if (options.profileGui && !guiProfiler.start(options.profileRateHz, options.profileWallClock)) {
+        return 1;
+    }
+
+#ifdef TAQYON_WEBSOCKETS
+    // JS CPU profiles, heap snapshots and traces over the DevTools protocol
+    std::unique_ptr<DevToolsCapture> devToolsCapture;
+    if (options.devToolsPort > 0) {
+        devToolsCapture.reset(new DevToolsCapture(webPage, options.devToolsPort));
+        DevToolsCapture *capture = devToolsCapture.get();
+        channel.registerObject(QStringLiteral("devtools"), capture);
+        Metrics::global().addCollector(QStringLiteral("devtools"), [capture]() {
+            return capture->status();
+        });
+        capture->setHeapThreshold(options.captureHeapAboveMb);
+        if (options.captureCpuProfileSec > 0) {
+            const int durationMs = options.captureCpuProfileSec * 1000;
+            QObject::connect(webView, &QWebEngineView::loadFinished, capture, [capture, durationMs](bool ok) {
+                if (ok) {
+                    capture->startCpuProfile();
+                    QTimer::singleShot(durationMs, capture, &DevToolsCapture::stopCpuProfile);
+                }
+            }, Qt::SingleShotConnection);
+        }
+    }
+#endif
+
+    // Channel traffic recording, captured by the bridge module in the page
+    BridgeRecorder bridgeRecorder;
+    if (!options.recordBridgePath.isEmpty() && bridgeRecorder.start(options.recordBridgePath)) {
+        bridgeRecorder.attachToPage(webPage);
+        channel.registerObject(QStringLiteral("bridgeRecorder"), &bridgeRecorder);
+        shutdownCoordinator.addFlushTask(QStringLiteral("bridge-recording"), [&bridgeRecorder]() {
+            bridgeRecorder.stop();
+        });
+    }
+
+    // Simulated latency, jitter, reordering and bandwidth between page and backend
+    if (!options.bridgeConditions.isEmpty()) {
+        TransportConditions conditions;
+        QString error;
+        if (!TransportConditions::parse(options.bridgeConditions, conditions, error)) {
+            qCritical() << "Invalid --bridge-conditions:" << error;
+            return 1;
+        }
+        if (conditions.isActive()) {
+            qInfo().noquote() << "Bridge conditions:" << conditions.toString();
+            injectTransportConditions(webPage, conditions);
+            Metrics::global().addCollector(QStringLiteral("bridgeConditions"), [conditions]() {
+                return conditions.toJson();
+            });
+        }
+    }
+
+    // Replay of recorded traffic through a second channel with the same objects
+    std::unique_ptr<ReplayTransport> replayTransport;
+    std::unique_ptr<QWebChannel> replayChannel;
+    if (!options.replayBridgePath.isEmpty()) {
+        replayTransport.reset(new ReplayTransport);
+        if (!replayTransport->load(options.replayBridgePath)) {
+            return 1;
+        }
+        replayTransport->setSpeed(options.replaySpeed);
+        replayChannel.reset(new QWebChannel);
+        replayChannel->registerObjects(channel.registeredObjects());
+        replayChannel->connectTo(replayTransport.get());
+        ReplayTransport *replay = replayTransport.get();
+        QObject::connect(replay, &ReplayTransport::finished, replay, &ReplayTransport::logReport);
+        if (options.replayHeadless) {
+            QObject::connect(replay, &ReplayTransport::finished, &app, &QCoreApplication::quit, Qt::QueuedConnection);
+            QTimer::singleShot(0, replay, &ReplayTransport::start);
+            return app.exec();
+        }
+        QObject::connect(webView, &QWebEngineView::loadFinished, replay, [replay](bool ok) {
+            if (ok) {
+                replay->start();
+            }
+        }, Qt::SingleShotConnection);
+    }
+
+    // Soak test: synthetic load with resource sampling, then exit
+    std::unique_ptr<SoakTest> soakTest;
+    if (!options.soakConfigPath.isEmpty() || options.soakDurationSec > 0) {
+        soakTest.reset(new SoakTest(webView, &channel));
+        if (!options.soakConfigPath.isEmpty() && !soakTest->loadConfig(options.soakConfigPath)) {
+            return 1;
+        }
+        if (options.soakDurationSec > 0) {
+            soakTest->setDuration(options.soakDurationSec);
+        }
+        soakTest->setReportPath(options.soakReportPath);
+        SoakTest *soak = soakTest.get();
+        QObject::connect(webView, &QWebEngineView::loadFinished, soak, &SoakTest::start, Qt::SingleShotConnection);
+        QObject::connect(soak, &SoakTest::finished, &shutdownCoordinator, [&shutdownCoordinator](bool leaksSuspected) {
+            shutdownCoordinator.shutdown(leaksSuspected ? 3 : 0);
+        }, Qt::QueuedConnection);
+    }
 
     // Frontend URL
     QUrl frontendUrl = resolveFrontendUrl(parser);
     if (!frontendUrl.isValid()) {
         return 1;
     }
+
+    // Built frontends are served from memory under taqyon://app/, with route
+    // chunks prefetched from the Vite manifest
+    std::unique_ptr<AssetCache> assetCache;
+    std::unique_ptr<RoutePrefetcher> prefetcher;
+    if (frontendUrl.isLocalFile() && !options.useFileUrls) {
+        assetCache.reset(new AssetCache(QFileInfo(frontendUrl.toLocalFile()).absolutePath(),
+                                        launchProfile.assetCacheBytes));
+        AssetCache *cache = assetCache.get();
+        schemeHandler->addHost(QStringLiteral("app"), [cache](QWebEngineUrlRequestJob *job) {
+            cache->handleRequest(job);
+        });
+        Metrics::global().addCollector(QStringLiteral("assets"), [cache]() {
+            const AssetCache::Stats stats = cache->stats();
+            QJsonObject object;
+            object.insert(QStringLiteral("hits"), qint64(stats.hits));
+            object.insert(QStringLiteral("misses"), qint64(stats.misses));
+            object.insert(QStringLiteral("preloaded"), qint64(stats.preloaded));
+            object.insert(QStringLiteral("bytes"), stats.bytes);
+            return object;
+        });
+        prefetcher.reset(new RoutePrefetcher(cache));
+        if (prefetcher->loadManifest()) {
+            channel.registerObject(QStringLiteral("prefetch"), prefetcher.get());
+            RoutePrefetcher *routePrefetcher = prefetcher.get();
+            QObject::connect(webView, &QWebEngineView::loadFinished, routePrefetcher, [routePrefetcher](bool ok) {
+                if (ok) {
+                    // Give the page a moment to settle before reading more chunks
+                    QTimer::singleShot(500, routePrefetcher, &RoutePrefetcher::startIdlePrefetch);
+                }
+            });
+        }
+        frontendUrl = QUrl(QStringLiteral("taqyon://app/index.html"));
+        qInfo() << "Serving frontend from" << cache->rootPath() << "as" << frontendUrl.toString();
+    }
+    // Only the frontend's own pages and workers may call into C++
+    bridgeEndpoint.setAllowedOrigins(TaqyonSchemeHandler::originsOf(frontendUrl));
+    apiRouter.setAllowedOrigins(TaqyonSchemeHandler::originsOf(frontendUrl));
     webView->setUrl(frontendUrl);
 
     // Main window with menu bar and tray icon
     MainWindow mainWindow(webView);
+    webViewOwner.release();
+    applyHiddenPagePolicy(webPage, &mainWindow, launchProfile);
+    mainWindow.setShutdownCoordinator(&shutdownCoordinator);
+
+    // Pages opened from the frontend become tabs, frozen and discarded in
+    // the background as the launch profile allows
+    TabManager *tabManager = mainWindow.tabManager();
+    if (soakTest) {
+        soakTest->setTabManager(tabManager);
+    }
+    TabManager::Policy tabPolicy;
+    tabPolicy.freezeAfterSec = launchProfile.freezeBackgroundTabsSec;
+    tabPolicy.maxLiveTabs = launchProfile.maxLiveTabs;
+    tabPolicy.memoryBudgetKb = launchProfile.tabMemoryBudgetMb * 1024.0;
+    tabManager->setPolicy(tabPolicy);
+    Metrics::global().addCollector(QStringLiteral("tabs"), [tabManager]() {
+        return tabManager->stats();
+    });
+
     mainWindow.show();
+    startupTrace.mark(QStringLiteral("windowShown"));
 
-    int result = app.exec();
+    // Until the page is interactive the view is covered by the last frame of
+    // the previous run, or by a native splash when there is none that fits
+    QWidget *coveredView = mainWindow.centralWidget();
+    const QImage lastFrame = takeLastFrame(frontendUrl, coveredView->size() * coveredView->devicePixelRatioF());
+    StartupSplash *splash = new StartupSplash(coveredView, lastFrame);
+    QObject::connect(&startupTrace, &StartupTrace::interactive, splash, &StartupSplash::finish);
+    QObject::connect(webView, &QWebEngineView::loadFinished, splash, [&startupTrace, splash](bool ok) {
+        startupTrace.mark(QStringLiteral("loadFinished"));
+        if (!ok) {
+            splash->finish(); // Show Chromium's error page
+        } else if (!startupTrace.isInteractive()) {
+            // Frontends without the bridge never report interactivity
+            QTimer::singleShot(3000, splash, &StartupSplash::finish);
+        }
+    });
 
-    if (logFile) {
-        logFile->close();
-        delete logFile;
+    // The frame for the next launch is grabbed before the window hides and
+    // written with the other flush tasks
+    QImage shutdownFrame;
+    if (options.lastFrameSplash) {
+        QObject::connect(&shutdownCoordinator, &ShutdownCoordinator::aboutToShutdown, webView,
+                         [&shutdownFrame, &startupTrace, webView]() {
+            if (startupTrace.isInteractive() && webView->isVisible()) {
+                shutdownFrame = webView->grab().toImage();
+            }
+        });
+        shutdownCoordinator.addFlushTask(QStringLiteral("last-frame"), [&shutdownFrame, frontendUrl]() {
+            if (!shutdownFrame.isNull()) {
+                saveLastFrame(shutdownFrame, frontendUrl);
+            }
+        });
     }
-    return result;
+
+    return app.exec();
 }
\ No newline at end of file
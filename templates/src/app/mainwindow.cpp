@@ -1,16 +1,22 @@
 #include "mainwindow.h"
 #include "mywebview.h"
+#include "shutdowncoordinator.h"
+#include "tabmanager.h"
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QApplication>
 #include <QIcon>
+#include <QTabWidget>
 
 MainWindow::MainWindow(MyWebView *webView, QWidget *parent)
-    : QMainWindow(parent), trayIcon(nullptr), showAction(nullptr), quitAction(nullptr), trayMenu(nullptr)
+    : QMainWindow(parent), trayIcon(nullptr), showAction(nullptr), quitAction(nullptr), trayMenu(nullptr),
+      shutdownCoordinator(nullptr)
 {
     setWindowTitle("Taqyon App");
     resize(1200, 800);
-    setCentralWidget(webView);
+    tabWidget = new QTabWidget(this);
+    tabs = new TabManager(tabWidget, webView, this);
+    setCentralWidget(tabWidget);
 
     setupMenuBar();
     setupTrayIcon();
@@ -26,6 +32,16 @@ MainWindow::~MainWindow()
     // Actions are deleted by trayMenu
 }
 
+void MainWindow::setShutdownCoordinator(ShutdownCoordinator *coordinator)
+{
+    shutdownCoordinator = coordinator;
+    connect(coordinator, &ShutdownCoordinator::aboutToShutdown, this, [this]() {
+        if (trayIcon) {
+            trayIcon->hide();
+        }
+    });
+}
+
 void MainWindow::setupMenuBar()
 {
     QMenuBar *menuBar = this->menuBar();
@@ -81,5 +97,9 @@ void MainWindow::showMainWindow()
 
 void MainWindow::quitApp()
 {
-    QApplication::quit();
+    if (shutdownCoordinator) {
+        shutdownCoordinator->shutdown();
+    } else {
+        QApplication::quit();
+    }
 }
\ No newline at end of file
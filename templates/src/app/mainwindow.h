@@ -7,6 +7,9 @@
 #include <QMenu>
 
 class MyWebView;
+class QTabWidget;
+class ShutdownCoordinator;
+class TabManager;
 
 class MainWindow : public QMainWindow
 {
@@ -16,6 +19,10 @@ public:
     explicit MainWindow(MyWebView *webView, QWidget *parent = nullptr);
     ~MainWindow();
 
+    void setShutdownCoordinator(ShutdownCoordinator *coordinator);
+    // The main view and the pages it opens, as tabs
+    TabManager *tabManager() const { return tabs; }
+
 private slots:
     void showAboutDialog();
     void showMainWindow();
@@ -29,6 +36,9 @@ private:
     QAction *showAction;
     QAction *quitAction;
     QMenu *trayMenu;
+    QTabWidget *tabWidget;
+    TabManager *tabs;
+    ShutdownCoordinator *shutdownCoordinator;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
@@ -0,0 +1,350 @@
+#include "memocache.h"
+#include "metrics.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <algorithm>
+
+namespace {
+
+const quint32 kEntryMagic = 0x54514d31; // "TQM1"
+const qint64 kDefaultMaxDiskBytes = 128 * 1024 * 1024;
+const qsizetype kDefaultMaxMemoryBytes = 16 * 1024 * 1024;
+// Charged for results that cannot be serialized, whose size is unknown
+const qsizetype kUnknownResultBytes = 1024;
+
+QString versionFilePath(const QString &methodDir)
+{
+    return methodDir + QStringLiteral("/version.json");
+}
+
+// Oldest entries first, across all methods, until the directory fits
+void trimDirectory(const QString &dirPath, qint64 maxBytes)
+{
+    QFileInfoList entries;
+    QDirIterator it(dirPath, QStringList() << "*.entry", QDir::Files, QDirIterator::Subdirectories);
+    qint64 total = 0;
+    while (it.hasNext()) {
+        it.next();
+        entries.append(it.fileInfo());
+        total += it.fileInfo().size();
+    }
+    if (total <= maxBytes) {
+        return;
+    }
+    std::sort(entries.begin(), entries.end(), [](const QFileInfo &a, const QFileInfo &b) {
+        return a.lastModified() < b.lastModified();
+    });
+    for (const QFileInfo &info : entries) {
+        if (total <= maxBytes) {
+            break;
+        }
+        total -= info.size();
+        QFile::remove(info.absoluteFilePath());
+    }
+}
+
+double hitRate(quint64 hits, quint64 misses)
+{
+    return hits + misses > 0 ? double(hits) / double(hits + misses) : 0;
+}
+
+} // namespace
+
+MemoCache &MemoCache::global()
+{
+    static MemoCache cache;
+    return cache;
+}
+
+MemoCache::MemoCache()
+    : m_maxDiskBytes(kDefaultMaxDiskBytes)
+{
+    m_memory.setMaxCost(kDefaultMaxMemoryBytes);
+}
+
+void MemoCache::setDirectory(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    m_directory = path;
+    for (MethodStats &stats : m_methods) {
+        stats.synced = false;
+        stats.generation++;
+    }
+    m_memory.clear();
+}
+
+void MemoCache::setMaxMemoryBytes(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_memory.setMaxCost(static_cast<qsizetype>(bytes));
+}
+
+QString MemoCache::directory() const
+{
+    if (!m_directory.isEmpty()) {
+        return m_directory;
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/memo");
+}
+
+QByteArray MemoCache::methodKey(const QString &method)
+{
+    return QCryptographicHash::hash(method.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+}
+
+QString MemoCache::methodDirectory(const QString &method) const
+{
+    return directory() + "/" + QString::fromLatin1(methodKey(method));
+}
+
+QVariant MemoCache::call(const QString &method, const QString &version, const QVariantList &args,
+                         const std::function<QVariant()> &compute)
+{
+    const QByteArray argsJson = QJsonDocument(QJsonArray::fromVariantList(args)).toJson(QJsonDocument::Compact);
+    const QByteArray argsKey = QCryptographicHash::hash(argsJson, QCryptographicHash::Sha1).toHex();
+    const QByteArray key = methodKey(method) + '/' + argsKey;
+    QString path;
+    quint64 generation = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        syncVersion(method, version);
+        path = methodDirectory(method) + "/" + QString::fromLatin1(argsKey) + ".entry";
+        MethodStats &stats = m_methods[method];
+        generation = stats.generation;
+        if (const Entry *cached = m_memory.object(key)) {
+            stats.memoryHits++;
+            stats.savedMs += cached->computeMs;
+            return cached->value;
+        }
+        Entry stored;
+        if (readEntry(path, version, stored)) {
+            stats.diskHits++;
+            stats.savedMs += stored.computeMs;
+            m_memory.insert(key, new Entry(stored), stored.bytes);
+            return stored.value;
+        }
+        stats.misses++;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    Entry entry;
+    entry.value = compute();
+    entry.computeMs = timer.nsecsElapsed() / 1e6;
+    Metrics::global().recordLatency(QStringLiteral("memo.") + method, entry.computeMs);
+    if (!entry.value.isValid()) {
+        return entry.value; // A failure; computed again next time
+    }
+
+    QByteArray value;
+    if (entry.value.metaType().hasRegisteredDataStreamOperators()) {
+        QDataStream out(&value, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << entry.value;
+    } else {
+        qWarning() << "MemoCache: results of" << method << "are kept in memory only;"
+                   << entry.value.metaType().name() << "cannot be written to a QDataStream";
+    }
+    entry.bytes = value.isEmpty() ? kUnknownResultBytes : value.size();
+
+    QMutexLocker locker(&m_mutex);
+    const MethodStats stats = m_methods.value(method);
+    if (stats.generation != generation || stats.version != version) {
+        return entry.value; // Invalidated while computing
+    }
+    m_memory.insert(key, new Entry(entry), entry.bytes);
+    if (!value.isEmpty()) {
+        writeEntry(method, generation, path, version, entry, value);
+    }
+    return entry.value;
+}
+
+// Runs once per method and run, and again when the version changes: results
+// stored under another version, in this run or an earlier one, are dropped
+void MemoCache::syncVersion(const QString &method, const QString &version)
+{
+    MethodStats &stats = m_methods[method];
+    if (stats.synced && stats.version == version) {
+        return;
+    }
+    const QString dir = methodDirectory(method);
+    QString storedVersion;
+    QFile file(versionFilePath(dir));
+    if (file.open(QIODevice::ReadOnly)) {
+        storedVersion = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("version")).toString();
+        file.close();
+    }
+    if (storedVersion != version) {
+        const int dropped = dropEntries(method);
+        stats.invalidated += dropped;
+        if (dropped > 0) {
+            qInfo() << "MemoCache: version of" << method << "is now" << version << "- dropped" << dropped << "results";
+        }
+    }
+    stats.synced = true;
+    stats.version = version;
+    QDir().mkpath(dir);
+    if (storedVersion == version) {
+        return;
+    }
+
+    QJsonObject object;
+    object.insert(QStringLiteral("method"), method);
+    object.insert(QStringLiteral("version"), version);
+    QSaveFile versionFile(versionFilePath(dir));
+    if (!versionFile.open(QIODevice::WriteOnly) || versionFile.write(QJsonDocument(object).toJson()) < 0
+        || !versionFile.commit()) {
+        qWarning() << "MemoCache: could not write" << versionFile.fileName();
+    }
+}
+
+int MemoCache::dropEntries(const QString &method)
+{
+    m_methods[method].generation++;
+    const QByteArray prefix = methodKey(method) + '/';
+    const QList<QByteArray> keys = m_memory.keys();
+    for (const QByteArray &key : keys) {
+        if (key.startsWith(prefix)) {
+            m_memory.remove(key);
+        }
+    }
+    QDir dir(methodDirectory(method));
+    const QStringList files = dir.entryList(QStringList() << "*.entry", QDir::Files);
+    for (const QString &file : files) {
+        dir.remove(file);
+    }
+    return files.size();
+}
+
+bool MemoCache::readEntry(const QString &path, const QString &version, Entry &entry) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    QString entryVersion;
+    QByteArray value;
+    in >> magic;
+    if (magic != kEntryMagic) {
+        return false;
+    }
+    in >> entryVersion >> entry.computeMs >> value;
+    if (in.status() != QDataStream::Ok || entryVersion != version) {
+        // Written for an older version after the method was invalidated
+        file.remove();
+        return false;
+    }
+    QDataStream valueIn(value);
+    valueIn.setVersion(QDataStream::Qt_6_0);
+    valueIn >> entry.value;
+    if (valueIn.status() != QDataStream::Ok || !entry.value.isValid()) {
+        qWarning() << "MemoCache: could not read" << path;
+        return false;
+    }
+    entry.bytes = value.size();
+    return true;
+}
+
+void MemoCache::writeEntry(const QString &method, quint64 generation, const QString &path, const QString &version,
+                           const Entry &entry, const QByteArray &value)
+{
+    // Disk writes and trimming stay off the calling thread
+    const QString dir = directory();
+    const qint64 maxBytes = m_maxDiskBytes;
+    const double computeMs = entry.computeMs;
+    QThreadPool::globalInstance()->start([this, method, generation, dir, path, version, computeMs, value, maxBytes]() {
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "MemoCache: could not write" << path;
+            return;
+        }
+        QDataStream out(&file);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << kEntryMagic << version << computeMs << value;
+        {
+            // Checked and committed under the lock, so an invalidation
+            // cannot slip in between and leave the old result on disk
+            QMutexLocker locker(&m_mutex);
+            if (m_methods.value(method).generation != generation) {
+                return; // Invalidated since; the uncommitted file is discarded
+            }
+            if (!file.commit()) {
+                qWarning() << "MemoCache: could not commit" << path;
+                return;
+            }
+        }
+        trimDirectory(dir, maxBytes);
+    });
+}
+
+void MemoCache::invalidate(const QString &method)
+{
+    QMutexLocker locker(&m_mutex);
+    m_methods[method].invalidated += dropEntries(method);
+}
+
+void MemoCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_memory.clear();
+    QDir(directory()).removeRecursively();
+    for (MethodStats &stats : m_methods) {
+        stats.synced = false;
+        stats.generation++;
+    }
+}
+
+QJsonObject MemoCache::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    QJsonObject methods;
+    quint64 memoryHits = 0;
+    quint64 diskHits = 0;
+    quint64 misses = 0;
+    quint64 invalidated = 0;
+    double savedMs = 0;
+    for (auto it = m_methods.cbegin(); it != m_methods.cend(); ++it) {
+        const MethodStats &stats = it.value();
+        QJsonObject object;
+        object.insert(QStringLiteral("version"), stats.version);
+        object.insert(QStringLiteral("memoryHits"), qint64(stats.memoryHits));
+        object.insert(QStringLiteral("diskHits"), qint64(stats.diskHits));
+        object.insert(QStringLiteral("misses"), qint64(stats.misses));
+        object.insert(QStringLiteral("hitRate"), hitRate(stats.memoryHits + stats.diskHits, stats.misses));
+        object.insert(QStringLiteral("invalidated"), qint64(stats.invalidated));
+        object.insert(QStringLiteral("savedMs"), stats.savedMs);
+        methods.insert(it.key(), object);
+        memoryHits += stats.memoryHits;
+        diskHits += stats.diskHits;
+        misses += stats.misses;
+        invalidated += stats.invalidated;
+        savedMs += stats.savedMs;
+    }
+
+    QJsonObject object;
+    object.insert(QStringLiteral("memoryHits"), qint64(memoryHits));
+    object.insert(QStringLiteral("diskHits"), qint64(diskHits));
+    object.insert(QStringLiteral("misses"), qint64(misses));
+    object.insert(QStringLiteral("hitRate"), hitRate(memoryHits + diskHits, misses));
+    object.insert(QStringLiteral("invalidated"), qint64(invalidated));
+    object.insert(QStringLiteral("savedMs"), savedMs);
+    object.insert(QStringLiteral("memoryEntries"), qint64(m_memory.count()));
+    object.insert(QStringLiteral("memoryBytes"), qint64(m_memory.totalCost()));
+    object.insert(QStringLiteral("methods"), methods);
+    return object;
+}
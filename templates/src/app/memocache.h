@@ -0,0 +1,120 @@
+#ifndef MEMOCACHE_H
+#define MEMOCACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <QVariant>
+#include <QVariantList>
+#include <functional>
+
+// Results of backend methods that are pure functions of their arguments and
+// a version token, such as reports and aggregations, kept across runs (see
+// docs/memoization.md). Results are keyed by method and arguments, held in a
+// memory LRU and written to one file per entry under the cache directory.
+//
+// The version token is declared with the method: bump it when the code
+// changes, or pass the revision of the data the method reads. The first call
+// with another version drops every stored result of that method.
+//
+// Thread-safe. compute() runs outside the lock on the calling thread, so
+// concurrent first calls with the same arguments may both compute.
+class MemoCache
+{
+public:
+    static MemoCache &global();
+
+    // Defaults to "memo" under the app's cache location
+    void setDirectory(const QString &path);
+    void setMaxMemoryBytes(qint64 bytes);
+    void setMaxDiskBytes(qint64 bytes) { m_maxDiskBytes = bytes; }
+
+    // The stored result for (method, args) at version, otherwise the result
+    // of compute(), which is stored unless it is an invalid QVariant.
+    // Arguments must convert to JSON; results are stored on disk when their
+    // type can be written to a QDataStream, and in memory only otherwise.
+    QVariant call(const QString &method, const QString &version, const QVariantList &args,
+                  const std::function<QVariant()> &compute);
+
+    // Drops stored results, from memory and disk
+    void invalidate(const QString &method);
+    void clear();
+
+    // Hit rates overall and per method, for the "memo" metrics collector
+    QJsonObject stats() const;
+
+private:
+    struct Entry {
+        QVariant value;
+        double computeMs = 0;
+        qsizetype bytes = 0;
+    };
+
+    struct MethodStats {
+        bool synced = false; // The version has been checked against the disk
+        QString version;
+        // Bumped whenever stored results are dropped; results computed or
+        // written under an older generation are discarded
+        quint64 generation = 0;
+        quint64 memoryHits = 0;
+        quint64 diskHits = 0;
+        quint64 misses = 0;
+        quint64 invalidated = 0;
+        double savedMs = 0;
+    };
+
+    MemoCache();
+
+    QString directory() const;
+    QString methodDirectory(const QString &method) const;
+    void syncVersion(const QString &method, const QString &version);
+    // Removes the method's results from memory and disk and starts a new
+    // generation; returns the number of files
+    int dropEntries(const QString &method);
+    bool readEntry(const QString &path, const QString &version, Entry &entry) const;
+    void writeEntry(const QString &method, quint64 generation, const QString &path, const QString &version,
+                    const Entry &entry, const QByteArray &value);
+
+    static QByteArray methodKey(const QString &method);
+
+    mutable QMutex m_mutex;
+    QString m_directory;
+    qint64 m_maxDiskBytes;
+    QCache<QByteArray, Entry> m_memory;
+    QHash<QString, MethodStats> m_methods;
+};
+
+// A memoized method, declared next to the method it caches:
+//
+//   const Memoized m_report{QStringLiteral("BackendObject::report"), QStringLiteral("3")};
+//
+//   QVariantMap BackendObject::report(int year) {
+//       return m_report({year}, [&]() { return QVariant(buildReport(year)); }).toMap();
+//   }
+class Memoized
+{
+public:
+    Memoized(const QString &method, const QString &version)
+        : m_method(method)
+        , m_version(version)
+    {
+    }
+
+    QVariant operator()(const QVariantList &args, const std::function<QVariant()> &compute) const
+    {
+        return MemoCache::global().call(m_method, m_version, args, compute);
+    }
+
+    // For results that depend on data: the data's revision
+    void setVersion(const QString &version) { m_version = version; }
+    QString version() const { return m_version; }
+
+private:
+    QString m_method;
+    QString m_version;
+};
+
+#endif // MEMOCACHE_H
@@ -0,0 +1,118 @@
+#include "metrics.h"
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace {
+
+double percentile(const QVector<double> &sorted, double fraction)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    const int index = qBound(0, static_cast<int>(fraction * sorted.size()), static_cast<int>(sorted.size()) - 1);
+    return sorted.at(index);
+}
+
+} // namespace
+
+Metrics &Metrics::global()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+void Metrics::addCount(const QString &name, qint64 delta)
+{
+    QMutexLocker locker(&m_mutex);
+    m_counters[name] += delta;
+}
+
+void Metrics::setGauge(const QString &name, double value)
+{
+    QMutexLocker locker(&m_mutex);
+    m_gauges[name] = value;
+}
+
+void Metrics::recordLatency(const QString &name, double ms)
+{
+    QMutexLocker locker(&m_mutex);
+    Latency &latency = m_latencies[name];
+    if (latency.count == 0 || ms < latency.min) latency.min = ms;
+    if (latency.count == 0 || ms > latency.max) latency.max = ms;
+    ++latency.count;
+    latency.total += ms;
+    if (latency.recent.size() < RecentSamples) {
+        latency.recent.append(ms);
+    } else {
+        latency.recent[latency.next] = ms;
+        latency.next = (latency.next + 1) % RecentSamples;
+    }
+}
+
+void Metrics::addCollector(const QString &name, Collector collector)
+{
+    QMutexLocker locker(&m_mutex);
+    removeCollectorLocked(name);
+    m_collectors.append(qMakePair(name, std::move(collector)));
+}
+
+void Metrics::removeCollector(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    removeCollectorLocked(name);
+}
+
+void Metrics::removeCollectorLocked(const QString &name)
+{
+    m_collectors.removeIf([&name](const QPair<QString, Collector> &entry) { return entry.first == name; });
+}
+
+QJsonObject Metrics::snapshot() const
+{
+    QJsonObject counters;
+    QJsonObject gauges;
+    QJsonObject latencies;
+    QList<QPair<QString, Collector>> collectors;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_counters.constBegin(); it != m_counters.constEnd(); ++it) {
+            counters.insert(it.key(), it.value());
+        }
+        for (auto it = m_gauges.constBegin(); it != m_gauges.constEnd(); ++it) {
+            gauges.insert(it.key(), it.value());
+        }
+        for (auto it = m_latencies.constBegin(); it != m_latencies.constEnd(); ++it) {
+            const Latency &latency = it.value();
+            QVector<double> sorted = latency.recent;
+            std::sort(sorted.begin(), sorted.end());
+            QJsonObject entry;
+            entry.insert(QStringLiteral("count"), latency.count);
+            entry.insert(QStringLiteral("mean"), latency.count ? latency.total / latency.count : 0.0);
+            entry.insert(QStringLiteral("min"), latency.min);
+            entry.insert(QStringLiteral("max"), latency.max);
+            entry.insert(QStringLiteral("p50"), percentile(sorted, 0.50));
+            entry.insert(QStringLiteral("p95"), percentile(sorted, 0.95));
+            entry.insert(QStringLiteral("p99"), percentile(sorted, 0.99));
+            latencies.insert(it.key(), entry);
+        }
+        collectors = m_collectors;
+    }
+
+    QJsonObject snapshot;
+    snapshot.insert(QStringLiteral("counters"), counters);
+    snapshot.insert(QStringLiteral("gauges"), gauges);
+    snapshot.insert(QStringLiteral("latency"), latencies);
+    // Outside the lock, so collectors may record metrics themselves
+    for (const auto &collector : collectors) {
+        snapshot.insert(collector.first, collector.second());
+    }
+    return snapshot;
+}
+
+void Metrics::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_counters.clear();
+    m_gauges.clear();
+    m_latencies.clear();
+}
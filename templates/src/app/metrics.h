@@ -0,0 +1,63 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <functional>
+
+// Process-wide registry of performance counters, gauges and latency
+// distributions. Recording is thread-safe and cheap enough for hot paths
+// (one mutex, no allocation after a name is first seen). Components that
+// already keep their own statistics register a collector instead, which is
+// asked for a JSON object whenever a snapshot is taken.
+//
+// Names are dotted by component ("api.GET /items/:id", "startup.plugins").
+class Metrics
+{
+public:
+    using Collector = std::function<QJsonObject()>;
+
+    static Metrics &global();
+
+    void addCount(const QString &name, qint64 delta = 1);
+    void setGauge(const QString &name, double value);
+    void recordLatency(const QString &name, double ms);
+
+    // Collectors run on the thread calling snapshot(), which is the GUI
+    // thread for everything in this app. They must outlive the registry's use.
+    void addCollector(const QString &name, Collector collector);
+    void removeCollector(const QString &name);
+
+    // {"counters": {...}, "gauges": {...}, "latency": {name: {count, mean,
+    // min, max, p50, p95, p99}}, <collector name>: {...}}
+    QJsonObject snapshot() const;
+    void reset();
+
+private:
+    struct Latency {
+        qint64 count = 0;
+        double total = 0;
+        double min = 0;
+        double max = 0;
+        // The most recent samples, for percentiles
+        QVector<double> recent;
+        int next = 0;
+    };
+
+    static const int RecentSamples = 1024;
+
+    void removeCollectorLocked(const QString &name);
+
+    mutable QMutex m_mutex;
+    QHash<QString, qint64> m_counters;
+    QHash<QString, double> m_gauges;
+    QHash<QString, Latency> m_latencies;
+    QList<QPair<QString, Collector>> m_collectors;
+};
+
+#endif // METRICS_H
@@ -1,20 +1,46 @@
 #include "mywebpage.h"
 #include <QDesktopServices>
+#include <QWebChannel>
 #include <QDebug> // For logging
 
+namespace {
+
+QUrl originOf(const QUrl &url)
+{
+    return url.adjusted(QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment | QUrl::RemoveUserInfo);
+}
+
+} // namespace
+
 MyWebPage::MyWebPage(QWebEngineProfile *profile, QObject *parent)
     : QWebEnginePage(profile, parent)
 {
 }
 
+void MyWebPage::setTrustedChannel(QWebChannel *channel, const QUrl &url)
+{
+    m_trustedChannel = channel;
+    m_trustedOrigin = originOf(url);
+}
+
 bool MyWebPage::acceptNavigationRequest(const QUrl &url, NavigationType type, bool isMainFrame)
 {
     if (isMainFrame && type == QWebEnginePage::NavigationTypeLinkClicked) {
         if (url.scheme() == QLatin1String("http") || url.scheme() == QLatin1String("https")) {
             qInfo() << "Intercepted link click to:" << url.toString() << ". Opening externally.";
             QDesktopServices::openUrl(url);
+            if (this->url().isEmpty()) {
+                // A page opened only for this link; nothing is left to show
+                emit windowCloseRequested();
+            }
             return false; // We've handled it
         }
     }
+    if (isMainFrame && m_trustedChannel) {
+        QWebChannel *channel = originOf(url) == m_trustedOrigin ? m_trustedChannel.data() : nullptr;
+        if (webChannel() != channel) {
+            setWebChannel(channel);
+        }
+    }
     return QWebEnginePage::acceptNavigationRequest(url, type, isMainFrame);
 } 
\ No newline at end of file
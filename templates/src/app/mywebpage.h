@@ -2,8 +2,11 @@
 #define MYWEBPAGE_H
 
 #include <QWebEnginePage>
+#include <QPointer>
 #include <QUrl>
 
+class QWebChannel;
+
 class MyWebPage : public QWebEnginePage
 {
     Q_OBJECT
@@ -11,8 +14,17 @@ class MyWebPage : public QWebEnginePage
 public:
     explicit MyWebPage(QWebEngineProfile *profile, QObject *parent = nullptr);
 
+    // Publishes `channel` only to documents from the same origin as `url`;
+    // the page gets no channel while it shows anything else. For pages the
+    // frontend opens with window.open(), which may also lead elsewhere.
+    void setTrustedChannel(QWebChannel *channel, const QUrl &url);
+
 protected:
     bool acceptNavigationRequest(const QUrl &url, NavigationType type, bool isMainFrame) override;
+
+private:
+    QPointer<QWebChannel> m_trustedChannel;
+    QUrl m_trustedOrigin;
 };
 
 #endif // MYWEBPAGE_H 
\ No newline at end of file
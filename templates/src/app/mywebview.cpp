@@ -14,6 +14,11 @@ MyWebView::MyWebView(QWidget *parent)
 {
 }
 
+void MyWebView::setViewFactory(ViewFactory factory)
+{
+    m_viewFactory = std::move(factory);
+}
+
 void MyWebView::contextMenuEvent(QContextMenuEvent *event)
 {
     QWebEngineContextMenuRequest *request = lastContextMenuRequest();
@@ -92,6 +97,11 @@ QWebEngineView* MyWebView::createWindow(QWebEnginePage::WebWindowType type)
 {
     qInfo() << "MyWebView::createWindow called with type:" << static_cast<int>(type);
 
+    if (m_viewFactory && (type == QWebEnginePage::WebBrowserTab || type == QWebEnginePage::WebBrowserBackgroundTab
+                          || type == QWebEnginePage::WebBrowserWindow)) {
+        return m_viewFactory(type);
+    }
+
     if (type == QWebEnginePage::WebBrowserTab || type == QWebEnginePage::WebBrowserWindow) {
         qInfo() << "createWindow: Creating a new MyWebView for WebBrowserTab/WebBrowserWindow.";
 
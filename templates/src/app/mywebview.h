@@ -4,17 +4,27 @@
 #include <QWebEnginePage>    // Ensure QWebEnginePage is fully defined early
 #include <QWebEngineView>
 #include <QContextMenuEvent>
+#include <functional>
 
 class MyWebView : public QWebEngineView
 {
     Q_OBJECT
 
 public:
+    // Creates the view for a page opened by this one (window.open(), target
+    // links, View Source). Without one, each opens in its own window.
+    using ViewFactory = std::function<MyWebView *(QWebEnginePage::WebWindowType type)>;
+
     explicit MyWebView(QWidget *parent = nullptr);
 
+    void setViewFactory(ViewFactory factory);
+
 protected:
     void contextMenuEvent(QContextMenuEvent *event) override;
     QWebEngineView *createWindow(QWebEnginePage::WebWindowType type) override;
+
+private:
+    ViewFactory m_viewFactory;
 };
 
 #endif // MYWEBVIEW_H 
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "plotoverlay.h"
+#include "plotwidget.h"
+#include <QWebEngineView>
+#include <QRectF>
+#include <utility>
+
+PlotOverlay::PlotOverlay(QWebEngineView *view, QObject *parent)
+    : QObject(parent), m_view(view)
+{
+    // Placeholders disappear with the document; the page places them again
+    connect(view, &QWebEngineView::loadStarted, this, &PlotOverlay::hideAll);
+}
+
+PlotWidget *PlotOverlay::findPlot(const QString &id) const
+{
+    return m_plots.value(id).data();
+}
+
+PlotWidget *PlotOverlay::plot(const QString &id)
+{
+    if (PlotWidget *existing = findPlot(id)) {
+        return existing;
+    }
+    if (!m_view) {
+        return nullptr;
+    }
+    PlotWidget *widget = new PlotWidget(m_view);
+    widget->setObjectName(id);
+    widget->hide();
+    m_plots.insert(id, widget);
+    emit plotCreated(id);
+    return widget;
+}
+
+void PlotOverlay::setPlotGeometry(const QString &id, double x, double y, double width, double height, bool visible)
+{
+    PlotWidget *widget = plot(id);
+    if (!widget) {
+        return;
+    }
+    if (!visible || width <= 0 || height <= 0) {
+        widget->hide();
+        return;
+    }
+    // CSS pixels to widget coordinates; device pixel ratio is handled by Qt
+    const double zoom = m_view->zoomFactor();
+    widget->setGeometry(QRectF(x * zoom, y * zoom, width * zoom, height * zoom).toAlignedRect());
+    widget->show();
+    // The view may have recreated its render widget on top of ours
+    widget->raise();
+}
+
+void PlotOverlay::removePlot(const QString &id)
+{
+    QPointer<PlotWidget> widget = m_plots.take(id);
+    if (widget) {
+        widget->deleteLater();
+    }
+}
+
+void PlotOverlay::hideAll()
+{
+    for (const QPointer<PlotWidget> &widget : std::as_const(m_plots)) {
+        if (widget) {
+            widget->hide();
+        }
+    }
+}
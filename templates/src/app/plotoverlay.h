@@ -0,0 +1,43 @@
+#ifndef PLOTOVERLAY_H
+#define PLOTOVERLAY_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QString>
+
+class QWebEngineView;
+class PlotWidget;
+
+// Places native PlotWidgets on top of a web view, over placeholder elements
+// in the page. The page reports each placeholder's bounding rectangle (CSS
+// pixels) through setPlotGeometry; C++ code feeds the plots directly through
+// plot(id), so sample data never goes through the channel.
+//
+// Published to the page as "plots".
+class PlotOverlay : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlotOverlay(QWebEngineView *view, QObject *parent = nullptr);
+
+    // Creates the plot on first use; it stays hidden until the page places it
+    PlotWidget *plot(const QString &id);
+    PlotWidget *findPlot(const QString &id) const;
+
+public slots:
+    void setPlotGeometry(const QString &id, double x, double y, double width, double height, bool visible);
+    void removePlot(const QString &id);
+
+signals:
+    void plotCreated(const QString &id);
+
+private:
+    void hideAll();
+
+    QPointer<QWebEngineView> m_view;
+    QHash<QString, QPointer<PlotWidget>> m_plots;
+};
+
+#endif // PLOTOVERLAY_H
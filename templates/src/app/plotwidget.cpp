@@ -0,0 +1,207 @@
+#include "plotwidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPen>
+#include <QLineF>
+#include <algorithm>
+#include <limits>
+
+namespace {
+const int kMargin = 4;
+}
+
+PlotWidget::PlotWidget(QWidget *parent)
+    : QWidget(parent), m_autoX(true), m_minX(0), m_maxX(1), m_background(Qt::white)
+{
+    // Every pixel is painted in paintEvent, no need to clear first
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+int PlotWidget::addSeries(const QString &name, const QColor &color)
+{
+    Series series;
+    series.name = name;
+    series.color = color;
+    m_series.append(series);
+    return m_series.size() - 1;
+}
+
+void PlotWidget::setSeriesData(int series, const QVector<QPointF> &points)
+{
+    if (series < 0 || series >= m_series.size()) {
+        return;
+    }
+    m_series[series].points = points;
+    trim(m_series[series]);
+    update();
+}
+
+void PlotWidget::appendPoints(int series, const QVector<QPointF> &points)
+{
+    if (series < 0 || series >= m_series.size()) {
+        return;
+    }
+    m_series[series].points += points;
+    trim(m_series[series]);
+    update(); // Coalesced by Qt, so bursts of appends paint once
+}
+
+void PlotWidget::clearSeries(int series)
+{
+    if (series < 0 || series >= m_series.size()) {
+        return;
+    }
+    m_series[series].points.clear();
+    update();
+}
+
+void PlotWidget::setMaxPoints(int series, int maxPoints)
+{
+    if (series < 0 || series >= m_series.size()) {
+        return;
+    }
+    m_series[series].maxPoints = maxPoints;
+    trim(m_series[series]);
+}
+
+void PlotWidget::trim(Series &series)
+{
+    // Trim in batches: dropping the head on every append would move the
+    // whole buffer each time
+    if (series.maxPoints > 0 && series.points.size() > series.maxPoints + series.maxPoints / 4) {
+        series.points.remove(0, series.points.size() - series.maxPoints);
+    }
+}
+
+void PlotWidget::setXRange(double minX, double maxX)
+{
+    m_autoX = false;
+    m_minX = minX;
+    m_maxX = maxX;
+    update();
+}
+
+void PlotWidget::setAutoXRange()
+{
+    m_autoX = true;
+    update();
+}
+
+void PlotWidget::setBackgroundColor(const QColor &color)
+{
+    m_background = color;
+    update();
+}
+
+bool PlotWidget::dataXRange(double &minX, double &maxX) const
+{
+    bool found = false;
+    for (const Series &series : m_series) {
+        if (series.points.isEmpty()) {
+            continue;
+        }
+        const double first = series.points.first().x();
+        const double last = series.points.last().x();
+        minX = found ? std::min(minX, first) : first;
+        maxX = found ? std::max(maxX, last) : last;
+        found = true;
+    }
+    return found;
+}
+
+void PlotWidget::decimate(const Series &series, double minX, double maxX, int columns,
+                          QVector<Column> &out, double &minY, double &maxY) const
+{
+    out.fill(Column(), columns);
+    const QVector<QPointF> &points = series.points;
+    auto begin = std::lower_bound(points.cbegin(), points.cend(), minX,
+                                  [](const QPointF &point, double x) { return point.x() < x; });
+    const double scale = (columns - 1) / (maxX - minX);
+
+    for (auto it = begin; it != points.cend() && it->x() <= maxX; ++it) {
+        const double y = it->y();
+        Column &column = out[static_cast<int>((it->x() - minX) * scale)];
+        if (!column.used) {
+            column.used = true;
+            column.minY = column.maxY = column.firstY = y;
+        } else {
+            column.minY = std::min(column.minY, y);
+            column.maxY = std::max(column.maxY, y);
+        }
+        column.lastY = y;
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
+}
+
+void PlotWidget::drawColumns(QPainter &painter, const QVector<Column> &columns, const QRectF &area,
+                             double minY, double maxY) const
+{
+    const double yScale = area.height() / (maxY - minY);
+    auto toY = [&](double y) { return area.bottom() - (y - minY) * yScale; };
+
+    QVector<QLineF> lines;
+    lines.reserve(columns.size() * 2);
+    int previous = -1;
+    for (int i = 0; i < columns.size(); ++i) {
+        const Column &column = columns.at(i);
+        if (!column.used) {
+            continue;
+        }
+        const double x = area.left() + i;
+        if (previous >= 0) {
+            lines.append(QLineF(area.left() + previous, toY(columns.at(previous).lastY), x, toY(column.firstY)));
+        }
+        if (column.maxY > column.minY) {
+            lines.append(QLineF(x, toY(column.minY), x, toY(column.maxY)));
+        } else if (previous < 0) {
+            // Lone first point: draw a dot so single samples stay visible
+            lines.append(QLineF(x - 0.5, toY(column.minY), x + 0.5, toY(column.minY)));
+        }
+        previous = i;
+    }
+    painter.drawLines(lines);
+}
+
+void PlotWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), m_background);
+
+    const QRectF area = QRectF(rect()).adjusted(kMargin, kMargin, -kMargin, -kMargin);
+    const int columns = static_cast<int>(area.width());
+    double minX = m_minX;
+    double maxX = m_maxX;
+    if (columns < 2 || (m_autoX && !dataXRange(minX, maxX)) || maxX <= minX) {
+        return;
+    }
+
+    // One pass per series collects min/max per pixel column and the y range
+    double minY = std::numeric_limits<double>::max();
+    double maxY = std::numeric_limits<double>::lowest();
+    QVector<QVector<Column>> decimated(m_series.size());
+    for (int i = 0; i < m_series.size(); ++i) {
+        decimate(m_series.at(i), minX, maxX, columns, decimated[i], minY, maxY);
+    }
+    if (minY > maxY) {
+        return;
+    }
+    if (minY == maxY) {
+        minY -= 1;
+        maxY += 1;
+    }
+
+    painter.setPen(QPen(QColor(0, 0, 0, 30), 0));
+    for (int i = 1; i < 4; ++i) {
+        const double y = area.top() + area.height() * i / 4;
+        painter.drawLine(QLineF(area.left(), y, area.right(), y));
+    }
+
+    // Dense data gains nothing from antialiasing
+    painter.setRenderHint(QPainter::Antialiasing, false);
+    for (int i = 0; i < m_series.size(); ++i) {
+        painter.setPen(QPen(m_series.at(i).color, 0));
+        drawColumns(painter, decimated.at(i), area, minY, maxY);
+    }
+}
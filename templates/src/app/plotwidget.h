@@ -0,0 +1,75 @@
+#ifndef PLOTWIDGET_H
+#define PLOTWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <QColor>
+#include <QString>
+
+class QPainter;
+
+// Software-rendered (QPainter) line chart for large, live series. Series with
+// more points than there are pixel columns are decimated to the min/max of
+// each column before drawing, so a 500k point series costs one pass over the
+// visible data and a few thousand line segments per repaint.
+//
+// Points of a series must be appended in increasing x order.
+class PlotWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PlotWidget(QWidget *parent = nullptr);
+
+    int addSeries(const QString &name, const QColor &color);
+    int seriesCount() const { return m_series.size(); }
+
+    void setSeriesData(int series, const QVector<QPointF> &points);
+    void appendPoints(int series, const QVector<QPointF> &points);
+    void clearSeries(int series);
+
+    // Keep only the newest maxPoints points of a live series (0 = unlimited)
+    void setMaxPoints(int series, int maxPoints);
+
+    // Fixed x window; by default the plot follows the data
+    void setXRange(double minX, double maxX);
+    void setAutoXRange();
+
+    void setBackgroundColor(const QColor &color);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    struct Series {
+        QString name;
+        QColor color;
+        QVector<QPointF> points;
+        int maxPoints = 0;
+    };
+
+    struct Column {
+        double minY = 0;
+        double maxY = 0;
+        double firstY = 0;
+        double lastY = 0;
+        bool used = false;
+    };
+
+    void trim(Series &series);
+    bool dataXRange(double &minX, double &maxX) const;
+    void drawColumns(QPainter &painter, const QVector<Column> &columns, const QRectF &area,
+                     double minY, double maxY) const;
+    void decimate(const Series &series, double minX, double maxX, int columns,
+                  QVector<Column> &out, double &minY, double &maxY) const;
+
+    QVector<Series> m_series;
+    bool m_autoX;
+    double m_minX;
+    double m_maxX;
+    QColor m_background;
+};
+
+#endif // PLOTWIDGET_H
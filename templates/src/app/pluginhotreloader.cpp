@@ -0,0 +1,199 @@
+#include "pluginhotreloader.h"
+#include "pluginregistry.h"
+#include "metrics.h"
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QPluginLoader>
+#include <QProcess>
+#include <QTemporaryDir>
+
+namespace {
+
+// Linkers write in several steps; wait for the last one
+const int kSettleMs = 300;
+// Editors save in several steps as well
+const int kBuildDelayMs = 150;
+
+} // namespace
+
+PluginHotReloader::PluginHotReloader(PluginRegistry *registry, QObject *parent)
+    : QObject(parent)
+    , m_registry(registry)
+    , m_build(nullptr)
+    , m_buildAgain(false)
+{
+    m_reloadTimer.setSingleShot(true);
+    m_reloadTimer.setInterval(kSettleMs);
+    m_buildTimer.setSingleShot(true);
+    m_buildTimer.setInterval(kBuildDelayMs);
+    connect(&m_reloadTimer, &QTimer::timeout, this, &PluginHotReloader::reloadPending);
+    connect(&m_buildTimer, &QTimer::timeout, this, &PluginHotReloader::build);
+    connect(&m_libraryWatcher, &QFileSystemWatcher::fileChanged, this, &PluginHotReloader::libraryChanged);
+    connect(&m_libraryWatcher, &QFileSystemWatcher::directoryChanged, this, &PluginHotReloader::directoryChanged);
+    connect(&m_sourceWatcher, &QFileSystemWatcher::fileChanged, this, &PluginHotReloader::sourceChanged);
+    connect(&m_sourceWatcher, &QFileSystemWatcher::directoryChanged, this, &PluginHotReloader::sourceChanged);
+}
+
+void PluginHotReloader::setBuildCommand(const QString &sourceDir, const QString &command)
+{
+    m_sourceDir = sourceDir;
+    m_buildCommand = command;
+}
+
+void PluginHotReloader::start()
+{
+    const QStringList loaded = m_registry->loadedNames();
+    for (const QString &name : loaded) {
+        watchLibrary(name);
+    }
+    connect(m_registry, &PluginRegistry::loaded, this, &PluginHotReloader::watchLibrary);
+    if (!m_sourceDir.isEmpty() && !m_buildCommand.isEmpty()) {
+        watchSources();
+    }
+    qInfo().noquote() << "PluginHotReloader: watching loaded plugins"
+                      << (m_buildCommand.isEmpty() ? QString() : QString("and rebuilding them from %1").arg(m_sourceDir));
+}
+
+void PluginHotReloader::watchLibrary(const QString &name)
+{
+    const QString path = m_registry->libraryPath(name);
+    m_pluginByLibrary.insert(path, name);
+    m_libraryWatcher.addPath(path);
+    // Linkers often replace the file, which ends the watch on it
+    m_libraryWatcher.addPath(QFileInfo(path).absolutePath());
+}
+
+void PluginHotReloader::libraryChanged(const QString &path)
+{
+    const QString name = m_pluginByLibrary.value(path);
+    if (name.isEmpty()) {
+        return;
+    }
+    if (!m_cycle.isValid()) {
+        m_cycle.start();
+    }
+    const QFileInfo info(path);
+    m_libraryStamps.insert(path, qMakePair(info.size(), info.lastModified()));
+    m_pending.insert(name);
+    m_reloadTimer.start();
+}
+
+void PluginHotReloader::directoryChanged(const QString &)
+{
+    const QStringList watched = m_libraryWatcher.files();
+    for (auto it = m_pluginByLibrary.cbegin(); it != m_pluginByLibrary.cend(); ++it) {
+        if (!watched.contains(it.key()) && QFileInfo::exists(it.key())) {
+            m_libraryWatcher.addPath(it.key());
+            libraryChanged(it.key());
+        }
+    }
+}
+
+void PluginHotReloader::reloadPending()
+{
+    const QSet<QString> pending = m_pending;
+    for (const QString &name : pending) {
+        if (!libraryComplete(m_registry->libraryPath(name))) {
+            m_reloadTimer.start();
+            return;
+        }
+    }
+    m_pending.clear();
+    for (const QString &name : pending) {
+        if (m_registry->reload(name) && m_cycle.isValid()) {
+            const double ms = m_cycle.nsecsElapsed() / 1e6;
+            Metrics::global().recordLatency(QStringLiteral("plugins.hotReloadCycleMs"), ms);
+            qInfo().noquote() << QString("PluginHotReloader: %1 live %2 ms after the change").arg(name).arg(qRound(ms));
+        }
+    }
+    m_cycle.invalidate();
+}
+
+// A library still being written changes size or time during the settle
+// delay, or has no readable metadata yet
+bool PluginHotReloader::libraryComplete(const QString &path)
+{
+    const QFileInfo info(path);
+    const QPair<qint64, QDateTime> stamp(info.size(), info.lastModified());
+    if (m_libraryStamps.value(path) != stamp) {
+        m_libraryStamps.insert(path, stamp);
+        return false;
+    }
+    // Qt caches a library's metadata by file name, and the registry keeps
+    // a loader for the original, so the check reads a fresh copy
+    QTemporaryDir dir;
+    const QString copy = dir.filePath(info.fileName());
+    return dir.isValid() && QFile::copy(path, copy) && !QPluginLoader(copy).metaData().isEmpty();
+}
+
+void PluginHotReloader::watchSources()
+{
+    QStringList paths{m_sourceDir};
+    QDirIterator it(m_sourceDir, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        paths.append(it.next());
+    }
+    const QStringList watched = m_sourceWatcher.files() + m_sourceWatcher.directories();
+    for (const QString &path : paths) {
+        if (!watched.contains(path)) {
+            m_sourceWatcher.addPath(path);
+        }
+    }
+}
+
+void PluginHotReloader::sourceChanged()
+{
+    if (!m_cycle.isValid()) {
+        m_cycle.start();
+    }
+    m_buildTimer.start();
+}
+
+void PluginHotReloader::build()
+{
+    // New files and files replaced on save need watching again
+    watchSources();
+    if (m_build) {
+        m_buildAgain = true;
+        return;
+    }
+    qInfo().noquote() << "PluginHotReloader: building:" << m_buildCommand;
+    m_build = new QProcess(this);
+    m_build->setProcessChannelMode(QProcess::MergedChannels);
+    connect(m_build, &QProcess::finished, this, &PluginHotReloader::buildFinished);
+    connect(m_build, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            qWarning() << "PluginHotReloader: could not run" << m_buildCommand;
+            m_build->deleteLater();
+            m_build = nullptr;
+            m_cycle.invalidate();
+        }
+    });
+    m_build->startCommand(m_buildCommand);
+}
+
+void PluginHotReloader::buildFinished(int exitCode)
+{
+    const QByteArray output = m_build->readAll();
+    m_build->deleteLater();
+    m_build = nullptr;
+    if (exitCode != 0) {
+        qWarning().noquote() << "PluginHotReloader: build failed with exit code" << exitCode << "\n" << output;
+        m_cycle.invalidate();
+    } else {
+        // The linker's writes were reported during the build; without any,
+        // nothing changed
+        QTimer::singleShot(kSettleMs, this, [this]() {
+            if (m_pending.isEmpty() && !m_reloadTimer.isActive() && !m_build) {
+                m_cycle.invalidate();
+            }
+        });
+    }
+    if (m_buildAgain) {
+        m_buildAgain = false;
+        build();
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef PLUGINHOTRELOADER_H
+#define PLUGINHOTRELOADER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+class PluginRegistry;
+class QProcess;
+
+// Development mode for backend plugins (--hot-reload-plugins). Watches the
+// libraries of loaded plugins and reloads a plugin in place when its library
+// is rebuilt, without restarting the app or reloading the page. With a
+// source directory and a build command it also runs the build when a source
+// file changes, so saving the file is enough.
+//
+// The registry must load from shadow copies (PluginRegistry::setShadowCopyDir)
+// so the linker can replace the libraries while they are loaded.
+class PluginHotReloader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PluginHotReloader(PluginRegistry *registry, QObject *parent = nullptr);
+
+    // `command` runs through the shell, e.g. "cmake --build build --target myplugin"
+    void setBuildCommand(const QString &sourceDir, const QString &command);
+    void start();
+
+private:
+    void watchLibrary(const QString &name);
+    void libraryChanged(const QString &path);
+    void directoryChanged(const QString &path);
+    void reloadPending();
+    bool libraryComplete(const QString &path);
+    void watchSources();
+    void sourceChanged();
+    void build();
+    void buildFinished(int exitCode);
+
+    PluginRegistry *m_registry;
+    QFileSystemWatcher m_libraryWatcher;
+    QFileSystemWatcher m_sourceWatcher;
+    QHash<QString, QString> m_pluginByLibrary;
+    // Size and modification time of each library when it last changed
+    QHash<QString, QPair<qint64, QDateTime>> m_libraryStamps;
+    QSet<QString> m_pending;
+    QTimer m_reloadTimer;
+    QTimer m_buildTimer;
+    QProcess *m_build;
+    bool m_buildAgain;
+    QString m_sourceDir;
+    QString m_buildCommand;
+    // From the first change of a cycle to the reload
+    QElapsedTimer m_cycle;
+};
+
+#endif // PLUGINHOTRELOADER_H
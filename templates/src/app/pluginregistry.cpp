@@ -0,0 +1,284 @@
+#include "pluginregistry.h"
+#include "startuptrace.h"
+#include "metrics.h"
+#include "../backend/backendplugin.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLibrary>
+#include <QMetaProperty>
+#include <QPluginLoader>
+#include <QVariantMap>
+
+namespace {
+
+// The object's saveState() if it has one, otherwise its stored, writable
+// properties
+QVariantMap saveObjectState(QObject *object)
+{
+    QVariantMap state;
+    const QMetaObject *metaObject = object->metaObject();
+    if (metaObject->indexOfMethod("saveState()") >= 0) {
+        QMetaObject::invokeMethod(object, "saveState", Qt::DirectConnection, Q_RETURN_ARG(QVariantMap, state));
+        return state;
+    }
+    for (int i = QObject::staticMetaObject.propertyCount(); i < metaObject->propertyCount(); ++i) {
+        const QMetaProperty property = metaObject->property(i);
+        if (property.isReadable() && property.isWritable() && property.isStored()) {
+            state.insert(QString::fromLatin1(property.name()), property.read(object));
+        }
+    }
+    return state;
+}
+
+void restoreObjectState(QObject *object, const QVariantMap &state)
+{
+    const QMetaObject *metaObject = object->metaObject();
+    if (metaObject->indexOfMethod("restoreState(QVariantMap)") >= 0) {
+        QMetaObject::invokeMethod(object, "restoreState", Qt::DirectConnection, Q_ARG(QVariantMap, state));
+        return;
+    }
+    for (auto it = state.cbegin(); it != state.cend(); ++it) {
+        const int index = metaObject->indexOfProperty(it.key().toLatin1().constData());
+        if (index >= 0 && metaObject->property(index).isWritable()) {
+            metaObject->property(index).write(object, it.value());
+        }
+    }
+}
+
+} // namespace
+
+PluginRegistry::PluginRegistry(QObject *parent)
+    : QObject(parent)
+    , m_trace(nullptr)
+    , m_reloads(0)
+{
+}
+
+PluginRegistry::~PluginRegistry()
+{
+    if (!m_shadowCopyDir.isEmpty()) {
+        QDir(m_shadowCopyDir).removeRecursively();
+    }
+}
+
+int PluginRegistry::scan(const QString &directory)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const QDir dir(directory);
+    int found = 0;
+    const QFileInfoList files = dir.entryInfoList(QDir::Files, QDir::Name);
+    for (const QFileInfo &file : files) {
+        if (!QLibrary::isLibrary(file.fileName())) {
+            continue;
+        }
+        // Reads the metadata section of the file; nothing is loaded yet
+        QPluginLoader *loader = new QPluginLoader(file.absoluteFilePath(), this);
+        const QJsonObject metaData = loader->metaData();
+        if (metaData.value(QStringLiteral("IID")).toString() != QLatin1String(BackendPluginInterface_iid)) {
+            delete loader;
+            continue;
+        }
+        const QJsonObject info = metaData.value(QStringLiteral("MetaData")).toObject();
+        const QString name = info.value(QStringLiteral("name")).toString();
+        if (name.isEmpty()) {
+            qWarning() << "PluginRegistry:" << file.fileName() << "has no name in its metadata; ignoring it";
+            delete loader;
+            continue;
+        }
+        if (m_plugins.contains(name)) {
+            qWarning() << "PluginRegistry:" << file.fileName() << "is another plugin named" << name << "; ignoring it";
+            delete loader;
+            continue;
+        }
+        Plugin plugin;
+        plugin.metaData = info;
+        plugin.libraryPath = file.absoluteFilePath();
+        plugin.loader = loader;
+        m_plugins.insert(name, plugin);
+        m_order.append(name);
+        ++found;
+    }
+    qInfo().noquote() << QString("PluginRegistry: %1 plugins in %2 (%3 ms)")
+                             .arg(found).arg(dir.absolutePath()).arg(timer.elapsed());
+    return found;
+}
+
+QObject *PluginRegistry::object(const QString &name) const
+{
+    return m_plugins.value(name).object;
+}
+
+QString PluginRegistry::libraryPath(const QString &name) const
+{
+    return m_plugins.value(name).libraryPath;
+}
+
+QStringList PluginRegistry::loadedNames() const
+{
+    QStringList names;
+    for (const QString &name : m_order) {
+        if (m_plugins[name].object) {
+            names.append(name);
+        }
+    }
+    return names;
+}
+
+QJsonArray PluginRegistry::available() const
+{
+    QJsonArray list;
+    for (const QString &name : m_order) {
+        const Plugin &plugin = m_plugins[name];
+        QJsonObject entry;
+        entry.insert(QStringLiteral("name"), name);
+        entry.insert(QStringLiteral("description"), plugin.metaData.value(QStringLiteral("description")));
+        entry.insert(QStringLiteral("file"), QFileInfo(plugin.libraryPath).fileName());
+        entry.insert(QStringLiteral("loaded"), plugin.object != nullptr);
+        list.append(entry);
+    }
+    return list;
+}
+
+QObject *PluginRegistry::load(const QString &name)
+{
+    auto it = m_plugins.find(name);
+    if (it == m_plugins.end()) {
+        qWarning() << "PluginRegistry: no plugin named" << name;
+        return nullptr;
+    }
+    Plugin &plugin = *it;
+    if (plugin.object || plugin.failed) {
+        return plugin.object;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QPluginLoader *loader = libraryLoader(name, plugin);
+    plugin.object = loader ? createObject(name, loader) : nullptr;
+    if (!plugin.object) {
+        plugin.failed = true;
+        return nullptr;
+    }
+    plugin.activeLoader = loader;
+    plugin.loadMs = timer.nsecsElapsed() / 1e6;
+
+    Metrics::global().recordLatency(QStringLiteral("plugins.loadMs"), plugin.loadMs);
+    if (m_trace) {
+        m_trace->recordSpan(QStringLiteral("plugin.") + name, plugin.loadMs);
+    }
+    emit loaded(name, plugin.object);
+    return plugin.object;
+}
+
+bool PluginRegistry::reload(const QString &name)
+{
+    auto it = m_plugins.find(name);
+    if (it == m_plugins.end() || !it->object) {
+        return false;
+    }
+    Plugin &plugin = *it;
+    if (m_shadowCopyDir.isEmpty()) {
+        qWarning() << "PluginRegistry: reloading" << name << "needs a shadow copy directory";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QPluginLoader *loader = libraryLoader(name, plugin);
+    QObject *object = loader ? createObject(name, loader) : nullptr;
+    if (!object) {
+        if (loader) {
+            const QString file = loader->fileName();
+            loader->unload();
+            delete loader;
+            QFile::remove(file);
+        }
+        return false;
+    }
+    int stateValues = 0;
+    {
+        // Released before the old library is unloaded
+        const QVariantMap state = saveObjectState(plugin.object);
+        restoreObjectState(object, state);
+        stateValues = state.size();
+    }
+
+    QObject *oldObject = plugin.object;
+    QPluginLoader *oldLoader = plugin.activeLoader;
+    plugin.object = object;
+    plugin.activeLoader = loader;
+    ++m_reloads;
+    emit reloaded(name, object);
+
+    // The old library's code runs until its object is gone
+    delete oldObject;
+    const QString oldFile = oldLoader->fileName();
+    oldLoader->unload();
+    delete oldLoader;
+    QFile::remove(oldFile);
+
+    const double ms = timer.nsecsElapsed() / 1e6;
+    Metrics::global().recordLatency(QStringLiteral("plugins.reloadMs"), ms);
+    qInfo().noquote() << QString("PluginRegistry: reloaded %1 in %2 ms with %3 state values")
+                             .arg(name).arg(ms, 0, 'f', 1).arg(stateValues);
+    return true;
+}
+
+QPluginLoader *PluginRegistry::libraryLoader(const QString &name, Plugin &plugin)
+{
+    if (m_shadowCopyDir.isEmpty()) {
+        return plugin.loader;
+    }
+    // A new file name each time: the dynamic loader would return the
+    // library already loaded under the old one
+    const QFileInfo library(plugin.libraryPath);
+    const QString copy = QDir(m_shadowCopyDir).filePath(QString("%1-%2.%3")
+                                                            .arg(library.completeBaseName())
+                                                            .arg(++plugin.generation)
+                                                            .arg(library.suffix()));
+    QDir().mkpath(m_shadowCopyDir);
+    QFile::remove(copy);
+    if (!QFile::copy(plugin.libraryPath, copy)) {
+        qWarning() << "PluginRegistry: could not copy" << plugin.libraryPath << "for" << name << "to" << copy;
+        return nullptr;
+    }
+    return new QPluginLoader(copy, this);
+}
+
+QObject *PluginRegistry::createObject(const QString &name, QPluginLoader *loader)
+{
+    BackendPluginInterface *backendPlugin = qobject_cast<BackendPluginInterface *>(loader->instance());
+    if (!backendPlugin) {
+        qWarning() << "PluginRegistry: could not load" << name << ":" << loader->errorString();
+        return nullptr;
+    }
+    QObject *object = backendPlugin->createBackendObject(this);
+    if (!object) {
+        qWarning() << "PluginRegistry:" << name << "did not create its object";
+        return nullptr;
+    }
+    object->setObjectName(name);
+    return object;
+}
+
+QJsonObject PluginRegistry::stats() const
+{
+    QJsonObject loadMs;
+    int loadedCount = 0;
+    for (auto it = m_plugins.cbegin(); it != m_plugins.cend(); ++it) {
+        if (it->object) {
+            ++loadedCount;
+            loadMs.insert(it.key(), it->loadMs);
+        }
+    }
+    QJsonObject stats;
+    stats.insert(QStringLiteral("available"), m_plugins.size());
+    stats.insert(QStringLiteral("loaded"), loadedCount);
+    stats.insert(QStringLiteral("loadMs"), loadMs);
+    stats.insert(QStringLiteral("reloads"), m_reloads);
+    return stats;
+}
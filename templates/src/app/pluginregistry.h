@@ -0,0 +1,87 @@
+#ifndef PLUGINREGISTRY_H
+#define PLUGINREGISTRY_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+class QPluginLoader;
+class StartupTrace;
+
+// Backend services shipped as plugins (see backend/backendplugin.h). scan()
+// reads the JSON metadata of every library in the plugins directory without
+// loading it; a plugin is loaded, and its object created, the first time it
+// is asked for. Each load is timed in the startup trace as
+// "plugin.<name>".
+//
+// Published to the page as "plugins": available() lists them and
+// load(name) returns the plugin's object, which the page can use like any
+// channel object.
+//
+// For hot reload (see PluginHotReloader) libraries are loaded from copies in
+// a shadow directory, so the originals can be rebuilt while loaded, and
+// reload(name) swaps a plugin's object for one from the rebuilt library.
+class PluginRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PluginRegistry(QObject *parent = nullptr);
+    ~PluginRegistry() override;
+
+    void setStartupTrace(StartupTrace *trace) { m_trace = trace; }
+    // Load libraries from copies in `directory`; needed by reload()
+    void setShadowCopyDir(const QString &directory) { m_shadowCopyDir = directory; }
+    // Returns the number of plugins found
+    int scan(const QString &directory);
+    // The plugin's object if it is loaded, without loading it
+    QObject *object(const QString &name) const;
+    QJsonObject stats() const;
+    // The library a plugin was found as, before any shadow copy
+    QString libraryPath(const QString &name) const;
+    QStringList loadedNames() const;
+    // Loads the plugin's library again and replaces its object, carrying
+    // the old object's state over (see docs/backend-plugins.md). The old
+    // object is deleted and its library unloaded. On failure the old object
+    // stays in place.
+    bool reload(const QString &name);
+
+public slots:
+    // name, description, file and loaded for every plugin found
+    QJsonArray available() const;
+    // Loads the plugin on first use; null if it is unknown or fails to load
+    QObject *load(const QString &name);
+
+signals:
+    void loaded(const QString &name, QObject *object);
+    void reloaded(const QString &name, QObject *object);
+
+private:
+    struct Plugin {
+        QJsonObject metaData;
+        QString libraryPath;
+        QPluginLoader *loader = nullptr;
+        // loader, or the loader of the shadow copy in use
+        QPluginLoader *activeLoader = nullptr;
+        QObject *object = nullptr;
+        double loadMs = 0;
+        bool failed = false;
+        int generation = 0;
+    };
+
+    // Instantiates the plugin from `loader` and creates its object
+    QObject *createObject(const QString &name, QPluginLoader *loader);
+    // A loader for the plugin's library, or for a fresh copy of it
+    QPluginLoader *libraryLoader(const QString &name, Plugin &plugin);
+
+    QHash<QString, Plugin> m_plugins;
+    QStringList m_order;
+    StartupTrace *m_trace;
+    QString m_shadowCopyDir;
+    int m_reloads;
+};
+
+#endif // PLUGINREGISTRY_H
@@ -0,0 +1,126 @@
+#include "processmemory.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QList>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+
+// Rss/Pss from /proc/<pid>/smaps_rollup, or VmRSS from status on older kernels
+MemoryUsage processMemory(const QString &pid)
+{
+    MemoryUsage usage;
+    QFile rollup(QString("/proc/%1/smaps_rollup").arg(pid));
+    if (rollup.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        const QList<QByteArray> lines = rollup.readAll().split('\n');
+        for (const QByteArray &line : lines) {
+            if (line.startsWith("Rss:")) {
+                usage.rssKb = line.mid(4).trimmed().split(' ').value(0).toDouble();
+            } else if (line.startsWith("Pss:")) {
+                usage.pssKb = line.mid(4).trimmed().split(' ').value(0).toDouble();
+            }
+        }
+        return usage;
+    }
+    QFile status(QString("/proc/%1/status").arg(pid));
+    if (status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        const QList<QByteArray> lines = status.readAll().split('\n');
+        for (const QByteArray &line : lines) {
+            if (line.startsWith("VmRSS:")) {
+                usage.rssKb = line.mid(6).trimmed().split(' ').value(0).toDouble();
+            }
+        }
+    }
+    return usage;
+}
+
+QStringList descendantProcesses(const QString &rootPid)
+{
+    QHash<QString, QStringList> children;
+    const QStringList entries = QDir(QStringLiteral("/proc")).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        bool numeric = false;
+        entry.toInt(&numeric);
+        if (!numeric) {
+            continue;
+        }
+        QFile stat(QString("/proc/%1/stat").arg(entry));
+        if (!stat.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        // "pid (comm) state ppid ..."; comm may contain spaces, so parse after the last ')'
+        const QByteArray line = stat.readAll();
+        const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+        if (fields.size() > 1) {
+            children[QString::fromLatin1(fields.at(1))].append(entry);
+        }
+    }
+
+    QStringList result;
+    QStringList pending = children.value(rootPid);
+    while (!pending.isEmpty()) {
+        const QString pid = pending.takeLast();
+        result.append(pid);
+        pending.append(children.value(pid));
+    }
+    return result;
+}
+
+int openFileDescriptorCount()
+{
+    return QDir(QStringLiteral("/proc/self/fd")).entryList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System).size();
+}
+
+double processCpuTimeMs(const QString &pid)
+{
+    QFile stat(QString("/proc/%1/stat").arg(pid));
+    if (!stat.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    // utime and stime are fields 14 and 15, in clock ticks
+    const QByteArray line = stat.readAll();
+    const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 13) {
+        return -1;
+    }
+    const double ticks = fields.at(11).toDouble() + fields.at(12).toDouble();
+    return ticks * 1000.0 / sysconf(_SC_CLK_TCK);
+}
+#else
+MemoryUsage processMemory(const QString &)
+{
+    return MemoryUsage();
+}
+
+QStringList descendantProcesses(const QString &)
+{
+    return QStringList();
+}
+
+int openFileDescriptorCount()
+{
+    return -1;
+}
+
+double processCpuTimeMs(const QString &)
+{
+    return -1;
+}
+#endif // Q_OS_LINUX
+
+ProcessTreeMemory sampleProcessTreeMemory()
+{
+    ProcessTreeMemory memory;
+    const QString self = QString::number(QCoreApplication::applicationPid());
+    memory.self = processMemory(self);
+    const QStringList children = descendantProcesses(self);
+    for (const QString &pid : children) {
+        const MemoryUsage usage = processMemory(pid);
+        memory.childRssKb += qMax(0.0, usage.rssKb);
+        memory.childPssKb += qMax(0.0, usage.pssKb);
+    }
+    memory.childProcesses = children.size();
+    return memory;
+}
@@ -0,0 +1,35 @@
+#ifndef PROCESSMEMORY_H
+#define PROCESSMEMORY_H
+
+#include <QString>
+#include <QStringList>
+
+// Memory of the app and of the renderer, GPU and utility processes that
+// QtWebEngine spawns as its descendants, read from /proc. Linux only;
+// elsewhere every value is -1 and no processes are found.
+struct MemoryUsage {
+    double rssKb = -1;
+    double pssKb = -1; // Needs smaps_rollup (Linux 4.14+)
+};
+
+struct ProcessTreeMemory {
+    MemoryUsage self;
+    double childRssKb = 0;
+    double childPssKb = 0;
+    int childProcesses = 0;
+
+    // PSS splits shared pages between processes, so the sum is not inflated
+    // by shared libraries; -1 without PSS
+    double totalPssKb() const { return self.pssKb >= 0 ? self.pssKb + childPssKb : -1; }
+};
+
+MemoryUsage processMemory(const QString &pid);
+QStringList descendantProcesses(const QString &rootPid);
+ProcessTreeMemory sampleProcessTreeMemory();
+int openFileDescriptorCount();
+
+// User plus system CPU time the process has used so far, from
+// /proc/<pid>/stat; -1 when unknown
+double processCpuTimeMs(const QString &pid);
+
+#endif // PROCESSMEMORY_H
@@ -0,0 +1,162 @@
+#include "replaytransport.h"
+#include "metrics.h"
+#include <QJsonDocument>
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// QWebChannel's message type for replies to requests carrying an id
+const int kMessageTypeResponse = 10;
+const int kFlatOutBatch = 1000;
+
+QJsonObject distribution(QVector<double> values)
+{
+    QJsonObject object;
+    if (values.isEmpty()) {
+        return object;
+    }
+    std::sort(values.begin(), values.end());
+    object.insert(QStringLiteral("p50"), values.at(values.size() / 2));
+    object.insert(QStringLiteral("p95"), values.at(qMin(values.size() - 1, static_cast<int>(values.size() * 0.95))));
+    object.insert(QStringLiteral("max"), values.last());
+    return object;
+}
+
+} // namespace
+
+ReplayTransport::ReplayTransport(QObject *parent)
+    : QWebChannelAbstractTransport(parent),
+      m_next(0),
+      m_speed(1.0),
+      m_received(0),
+      m_durationNs(0)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &ReplayTransport::deliverDue);
+}
+
+bool ReplayTransport::load(const QString &path)
+{
+    QList<BridgeRecorder::Record> records;
+    if (!BridgeRecorder::readRecording(path, records)) {
+        return false;
+    }
+
+    // Latencies the user saw, for comparison with the replay
+    QHash<int, qint64> sentAt;
+    m_requests.clear();
+    m_recordedLatencies.clear();
+    for (const BridgeRecorder::Record &record : std::as_const(records)) {
+        if (record.direction == BridgeRecorder::PageToBackend) {
+            m_requests.append(record);
+            if (record.message.contains(QStringLiteral("id"))) {
+                sentAt.insert(record.message.value(QStringLiteral("id")).toInt(), record.timeUs);
+            }
+        } else if (record.message.value(QStringLiteral("type")).toInt() == kMessageTypeResponse) {
+            const int id = record.message.value(QStringLiteral("id")).toInt();
+            if (sentAt.contains(id)) {
+                m_recordedLatencies.append((record.timeUs - sentAt.take(id)) / 1000.0);
+            }
+        }
+    }
+    qInfo() << "ReplayTransport: loaded" << m_requests.size() << "page messages from" << path;
+    return !m_requests.isEmpty();
+}
+
+void ReplayTransport::start()
+{
+    m_next = 0;
+    m_received = 0;
+    m_pending.clear();
+    m_latencies.clear();
+    m_clock.start();
+    deliverDue();
+}
+
+void ReplayTransport::deliverDue()
+{
+    const qint64 originUs = m_requests.isEmpty() ? 0 : m_requests.first().timeUs;
+    int delivered = 0;
+    while (m_next < m_requests.size()) {
+        const BridgeRecorder::Record &record = m_requests.at(m_next);
+        if (m_speed > 0) {
+            const qint64 dueNs = static_cast<qint64>((record.timeUs - originUs) * 1000 / m_speed);
+            const qint64 waitNs = dueNs - m_clock.nsecsElapsed();
+            if (waitNs > 0) {
+                m_timer.start(static_cast<int>(waitNs / 1000000));
+                return;
+            }
+        } else if (delivered == kFlatOutBatch) {
+            // Let the event loop run queued signal emissions between batches
+            m_timer.start(0);
+            return;
+        }
+
+        if (record.message.contains(QStringLiteral("id"))) {
+            m_pending.insert(record.message.value(QStringLiteral("id")).toInt(), m_clock.nsecsElapsed());
+        }
+        ++m_next;
+        ++delivered;
+        emit messageReceived(record.message, this);
+    }
+    // Give asynchronous responses a moment before reporting
+    QTimer::singleShot(100, this, &ReplayTransport::finish);
+}
+
+void ReplayTransport::sendMessage(const QJsonObject &message)
+{
+    ++m_received;
+    if (message.value(QStringLiteral("type")).toInt() != kMessageTypeResponse) {
+        return;
+    }
+    const int id = message.value(QStringLiteral("id")).toInt();
+    if (m_pending.contains(id)) {
+        const double ms = (m_clock.nsecsElapsed() - m_pending.take(id)) / 1e6;
+        m_latencies.append(ms);
+        Metrics::global().recordLatency(QStringLiteral("replay.response"), ms);
+    }
+}
+
+void ReplayTransport::finish()
+{
+    m_durationNs = m_clock.nsecsElapsed();
+    Metrics::global().setGauge(QStringLiteral("replay.messagesPerSecond"),
+                               m_durationNs ? m_requests.size() * 1e9 / m_durationNs : 0);
+    emit finished();
+}
+
+QJsonObject ReplayTransport::report() const
+{
+    QJsonObject report;
+    report.insert(QStringLiteral("messages"), static_cast<int>(m_requests.size()));
+    report.insert(QStringLiteral("durationMs"), m_durationNs / 1e6);
+    report.insert(QStringLiteral("messagesPerSecond"), m_durationNs ? m_requests.size() * 1e9 / m_durationNs : 0.0);
+    report.insert(QStringLiteral("backendMessages"), m_received);
+    report.insert(QStringLiteral("responses"), static_cast<int>(m_latencies.size()));
+    report.insert(QStringLiteral("unanswered"), static_cast<int>(m_pending.size()));
+    report.insert(QStringLiteral("latencyMs"), distribution(m_latencies));
+    report.insert(QStringLiteral("recordedLatencyMs"), distribution(m_recordedLatencies));
+    return report;
+}
+
+void ReplayTransport::logReport() const
+{
+    const QJsonObject report = this->report();
+    const QJsonObject latency = report.value(QStringLiteral("latencyMs")).toObject();
+    const QJsonObject recorded = report.value(QStringLiteral("recordedLatencyMs")).toObject();
+    qInfo().noquote() << QString("Replay: %1 messages in %2 ms (%3 msg/s), %4 responses")
+                             .arg(report.value(QStringLiteral("messages")).toInt())
+                             .arg(report.value(QStringLiteral("durationMs")).toDouble(), 0, 'f', 1)
+                             .arg(report.value(QStringLiteral("messagesPerSecond")).toDouble(), 0, 'f', 0)
+                             .arg(report.value(QStringLiteral("responses")).toInt());
+    qInfo().noquote() << QString("Replay: response latency p50 %1 ms, p95 %2 ms, max %3 ms (recorded p50 %4 ms, p95 %5 ms)")
+                             .arg(latency.value(QStringLiteral("p50")).toDouble(), 0, 'f', 3)
+                             .arg(latency.value(QStringLiteral("p95")).toDouble(), 0, 'f', 3)
+                             .arg(latency.value(QStringLiteral("max")).toDouble(), 0, 'f', 3)
+                             .arg(recorded.value(QStringLiteral("p50")).toDouble(), 0, 'f', 3)
+                             .arg(recorded.value(QStringLiteral("p95")).toDouble(), 0, 'f', 3);
+    qInfo().noquote() << "Replay report:" << QJsonDocument(report).toJson(QJsonDocument::Compact);
+}
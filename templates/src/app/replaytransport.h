@@ -0,0 +1,64 @@
+#ifndef REPLAYTRANSPORT_H
+#define REPLAYTRANSPORT_H
+
+#include <QWebChannelAbstractTransport>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QTimer>
+#include <QVector>
+#include "bridgerecorder.h"
+
+// Plays a BridgeRecorder file back into a QWebChannel, standing in for the
+// page. Page-to-backend messages are delivered at their recorded times
+// divided by the speed factor (0 delivers them as fast as possible); what the
+// channel sends back is matched to the recorded requests to measure response
+// latency and throughput.
+//
+// Connect it to a QWebChannel holding the same objects as the page's channel:
+//
+//     replayChannel.registerObjects(channel.registeredObjects());
+//     replayChannel.connectTo(&replayTransport);
+//
+// Objects created at runtime and returned by id to the page cannot be
+// replayed, since their ids differ between runs.
+class ReplayTransport : public QWebChannelAbstractTransport
+{
+    Q_OBJECT
+
+public:
+    explicit ReplayTransport(QObject *parent = nullptr);
+
+    bool load(const QString &path);
+    void setSpeed(double speed) { m_speed = speed; }
+
+    // {"messages", "durationMs", "messagesPerSecond", "responses",
+    //  "latencyMs": {p50, p95, max}, "recordedLatencyMs": {p50, p95, max}}
+    QJsonObject report() const;
+    void logReport() const;
+
+public slots:
+    void start();
+    void sendMessage(const QJsonObject &message) override;
+
+signals:
+    void finished();
+
+private:
+    void deliverDue();
+    void finish();
+
+    QList<BridgeRecorder::Record> m_requests;
+    QVector<double> m_recordedLatencies;
+    QHash<int, qint64> m_pending;
+    QVector<double> m_latencies;
+    int m_next;
+    double m_speed;
+    qint64 m_received;
+    qint64 m_durationNs;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+};
+
+#endif // REPLAYTRANSPORT_H
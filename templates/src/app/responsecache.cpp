@@ -0,0 +1,371 @@
+#include "responsecache.h"
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QDebug>
+
+namespace {
+
+const quint32 kEntryMagic = 0x54514331; // "TQC1"
+const qint64 kDefaultMaxDiskBytes = 64 * 1024 * 1024;
+const qsizetype kDefaultMaxMemoryBytes = 8 * 1024 * 1024;
+
+void trimDirectory(const QString &dirPath, qint64 maxBytes)
+{
+    QDir dir(dirPath);
+    QFileInfoList entries = dir.entryInfoList(QStringList() << "*.entry", QDir::Files, QDir::Time | QDir::Reversed);
+    qint64 total = 0;
+    for (const QFileInfo &info : entries) {
+        total += info.size();
+    }
+    // Oldest first thanks to QDir::Reversed
+    for (const QFileInfo &info : entries) {
+        if (total <= maxBytes) {
+            break;
+        }
+        total -= info.size();
+        QFile::remove(info.absoluteFilePath());
+    }
+}
+
+// Responses that differ per user must not be stored for everyone
+bool variesOnCredentials(const QByteArray &vary)
+{
+    const QList<QByteArray> names = vary.toLower().split(',');
+    for (const QByteArray &name : names) {
+        const QByteArray trimmed = name.trimmed();
+        if (trimmed == "*" || trimmed == "cookie" || trimmed == "authorization") {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+ResponseCache::ResponseCache(QObject *parent)
+    : QObject(parent),
+      m_maxDiskBytes(kDefaultMaxDiskBytes),
+      m_network(new QNetworkAccessManager(this))
+{
+    m_memory.setMaxCost(kDefaultMaxMemoryBytes);
+}
+
+bool ResponseCache::loadConfig(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "ResponseCache: could not open config file:" << path;
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        qWarning() << "ResponseCache: invalid config" << path << ":" << parseError.errorString();
+        return false;
+    }
+    const QJsonObject config = doc.object();
+
+    m_cacheDir = config.value("cacheDir").toString();
+    if (m_cacheDir.isEmpty()) {
+        m_cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/api-cache";
+    }
+    if (!QDir().mkpath(m_cacheDir)) {
+        qWarning() << "ResponseCache: could not create cache directory:" << m_cacheDir;
+        return false;
+    }
+    m_maxDiskBytes = static_cast<qint64>(config.value("maxDiskBytes").toDouble(kDefaultMaxDiskBytes));
+    m_memory.setMaxCost(static_cast<qsizetype>(config.value("maxMemoryBytes").toDouble(kDefaultMaxMemoryBytes)));
+    m_upstream = QUrl(config.value("upstream").toString());
+
+    m_routes.clear();
+    const QJsonArray routes = config.value("routes").toArray();
+    for (const QJsonValue &value : routes) {
+        const QJsonObject routeObject = value.toObject();
+        Route route;
+        route.prefix = routeObject.value("prefix").toString();
+        const QString pattern = routeObject.value("pattern").toString();
+        if (!pattern.isEmpty()) {
+            route.pattern = QRegularExpression(pattern);
+            if (!route.pattern.isValid()) {
+                qWarning() << "ResponseCache: skipping route with invalid pattern:" << pattern;
+                continue;
+            }
+        }
+        if (route.prefix.isEmpty() && pattern.isEmpty()) {
+            qWarning() << "ResponseCache: skipping route without prefix or pattern";
+            continue;
+        }
+        route.ttlMs = static_cast<qint64>(routeObject.value("ttl").toDouble(0) * 1000);
+        route.staleMs = static_cast<qint64>(routeObject.value("staleWhileRevalidate").toDouble(0) * 1000);
+        m_routes.append(route);
+    }
+
+    qInfo() << "ResponseCache: loaded" << m_routes.size() << "routes from" << path << "cache dir:" << m_cacheDir;
+    if (m_upstream.isValid()) {
+        qInfo() << "ResponseCache: forwarding cached routes to upstream" << m_upstream.toString();
+    }
+    return true;
+}
+
+bool ResponseCache::matches(const QUrl &url) const
+{
+    return routeFor(url) != nullptr;
+}
+
+const ResponseCache::Route *ResponseCache::routeFor(const QUrl &url) const
+{
+    const QString urlString = url.toString(QUrl::FullyEncoded);
+    for (const Route &route : m_routes) {
+        if (!route.prefix.isEmpty() && urlString.startsWith(route.prefix)) {
+            return &route;
+        }
+        if (route.pattern.isValid() && !route.pattern.pattern().isEmpty()
+            && route.pattern.match(urlString).hasMatch()) {
+            return &route;
+        }
+    }
+    return nullptr;
+}
+
+QUrl ResponseCache::upstreamUrl(const QUrl &url) const
+{
+    if (!m_upstream.isValid() || m_upstream.isEmpty()) {
+        return url;
+    }
+    QUrl target = url;
+    target.setScheme(m_upstream.scheme());
+    target.setHost(m_upstream.host());
+    target.setPort(m_upstream.port());
+    return target;
+}
+
+const QList<QByteArray> &ResponseCache::varyHeaderNames()
+{
+    static const QList<QByteArray> names = {QByteArrayLiteral("Accept"), QByteArrayLiteral("Accept-Language")};
+    return names;
+}
+
+QByteArray ResponseCache::keyFor(const QUrl &url, const RequestHeaders &headers)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(url.toEncoded(QUrl::FullyEncoded));
+    for (const auto &header : headers) {
+        hash.addData(QByteArray("\n" + header.first.toLower() + ": " + header.second));
+    }
+    return hash.result().toHex();
+}
+
+void ResponseCache::fetch(const QUrl &url, const RequestHeaders &headers, Callback callback)
+{
+    const Route *route = routeFor(url);
+    if (!route) {
+        callback(Response(), false);
+        return;
+    }
+
+    const QByteArray key = keyFor(url, headers);
+    const Response cached = lookup(key);
+    if (cached.isValid()) {
+        const qint64 age = QDateTime::currentMSecsSinceEpoch() - cached.fetchedAtMs;
+        if (age <= route->ttlMs) {
+            ++m_stats.hits;
+            callback(cached, true);
+            return;
+        }
+        if (age <= route->ttlMs + route->staleMs) {
+            ++m_stats.staleHits;
+            callback(cached, true);
+            if (!m_inflight.contains(key)) {
+                m_inflight.insert(key, QList<Callback>());
+                startUpstream(url, headers, key, cached);
+            }
+            return;
+        }
+    }
+
+    auto inflight = m_inflight.find(key);
+    if (inflight != m_inflight.end()) {
+        ++m_stats.coalesced;
+        inflight->append(std::move(callback));
+        return;
+    }
+
+    ++m_stats.misses;
+    QList<Callback> waiters;
+    waiters.append(std::move(callback));
+    m_inflight.insert(key, waiters);
+    startUpstream(url, headers, key, cached);
+}
+
+ResponseCache::Response ResponseCache::lookup(const QByteArray &key)
+{
+    if (const Response *inMemory = m_memory.object(key)) {
+        return *inMemory;
+    }
+    const Response fromDisk = readEntry(key);
+    if (fromDisk.isValid()) {
+        m_memory.insert(key, new Response(fromDisk), fromDisk.body.size());
+    }
+    return fromDisk;
+}
+
+ResponseCache::Response ResponseCache::readEntry(const QByteArray &key) const
+{
+    Response response;
+    QFile file(m_cacheDir + "/" + QString::fromLatin1(key) + ".entry");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return response;
+    }
+    QDataStream in(&file);
+    quint32 magic = 0;
+    in >> magic;
+    if (magic != kEntryMagic) {
+        return response;
+    }
+    in >> response.url >> response.contentType >> response.etag >> response.lastModified
+       >> response.fetchedAtMs >> response.body;
+    if (in.status() != QDataStream::Ok) {
+        return Response();
+    }
+    return response;
+}
+
+void ResponseCache::writeEntry(const QByteArray &key, const Response &response)
+{
+    m_memory.insert(key, new Response(response), response.body.size());
+
+    // Disk writes and trimming stay off the GUI thread.
+    const QString dir = m_cacheDir;
+    const qint64 maxBytes = m_maxDiskBytes;
+    QThreadPool::globalInstance()->start([dir, key, response, maxBytes]() {
+        QSaveFile file(dir + "/" + QString::fromLatin1(key) + ".entry");
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "ResponseCache: could not write cache entry for" << response.url.toString();
+            return;
+        }
+        QDataStream out(&file);
+        out << kEntryMagic << response.url << response.contentType << response.etag
+            << response.lastModified << response.fetchedAtMs << response.body;
+        if (!file.commit()) {
+            qWarning() << "ResponseCache: could not commit cache entry for" << response.url.toString();
+            return;
+        }
+        trimDirectory(dir, maxBytes);
+    });
+}
+
+void ResponseCache::startUpstream(const QUrl &url, const RequestHeaders &headers, const QByteArray &key,
+                                  const Response &previous)
+{
+    ++m_stats.upstreamFetches;
+
+    QNetworkRequest request(upstreamUrl(url));
+    for (const auto &header : headers) {
+        request.setRawHeader(header.first, header.second);
+    }
+    // Never send or keep cookies: cached responses are shared
+    request.setAttribute(QNetworkRequest::CookieLoadControlAttribute, QNetworkRequest::Manual);
+    request.setAttribute(QNetworkRequest::CookieSaveControlAttribute, QNetworkRequest::Manual);
+    if (previous.isValid()) {
+        if (!previous.etag.isEmpty()) {
+            request.setRawHeader("If-None-Match", previous.etag);
+        }
+        if (!previous.lastModified.isEmpty()) {
+            request.setRawHeader("If-Modified-Since", previous.lastModified);
+        }
+    }
+
+    QNetworkReply *reply = m_network->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, url, key, previous]() {
+        reply->deleteLater();
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+        if (status == 304 && previous.isValid()) {
+            Response refreshed = previous;
+            refreshed.fetchedAtMs = QDateTime::currentMSecsSinceEpoch();
+            writeEntry(key, refreshed);
+            finishUpstream(key, refreshed, true);
+            return;
+        }
+
+        // Only transport errors and server errors fall back to the stale entry
+        const bool failed = status == 0 || status >= 500;
+        if (failed && (previous.isValid() || status == 0)) {
+            ++m_stats.upstreamErrors;
+            qWarning() << "ResponseCache: upstream fetch failed for" << url.toString()
+                       << "status:" << status << reply->errorString();
+            finishUpstream(key, previous, previous.isValid());
+            return;
+        }
+        if (status < 200 || status >= 300) {
+            // Redirects, client errors and server errors without a stale
+            // entry are the page's to handle
+            ++m_stats.passedThrough;
+            Response passed;
+            passed.url = url;
+            passed.status = status;
+            finishUpstream(key, passed, true);
+            return;
+        }
+
+        Response response;
+        response.url = url;
+        response.contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString().toUtf8();
+        if (response.contentType.isEmpty()) {
+            response.contentType = "application/octet-stream";
+        }
+        response.etag = reply->rawHeader("ETag");
+        response.lastModified = reply->rawHeader("Last-Modified");
+        response.body = reply->readAll();
+        response.fetchedAtMs = QDateTime::currentMSecsSinceEpoch();
+        if (variesOnCredentials(reply->rawHeader("Vary"))) {
+            ++m_stats.uncacheable;
+            qWarning() << "ResponseCache: not storing" << url.toString() << "- it varies on"
+                       << reply->rawHeader("Vary") << "; remove its route from the config";
+            finishUpstream(key, response, true);
+            return;
+        }
+        writeEntry(key, response);
+        finishUpstream(key, response, true);
+    });
+}
+
+QUrl ResponseCache::passThrough(const QUrl &url)
+{
+    const QUrl target = upstreamUrl(url);
+    ++m_passThrough[target];
+    return target;
+}
+
+bool ResponseCache::takePassThrough(const QUrl &url)
+{
+    auto it = m_passThrough.find(url);
+    if (it == m_passThrough.end()) {
+        return false;
+    }
+    if (--it.value() == 0) {
+        m_passThrough.erase(it);
+    }
+    return true;
+}
+
+void ResponseCache::finishUpstream(const QByteArray &key, const Response &response, bool ok)
+{
+    const QList<Callback> waiters = m_inflight.take(key);
+    for (const Callback &callback : waiters) {
+        callback(response, ok);
+    }
+}
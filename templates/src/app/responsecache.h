@@ -0,0 +1,111 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include <QObject>
+#include <QUrl>
+#include <QList>
+#include <QHash>
+#include <QCache>
+#include <QByteArray>
+#include <QString>
+#include <QRegularExpression>
+#include <QPair>
+#include <functional>
+
+class QNetworkAccessManager;
+
+// On-disk cache for remote API responses, configured per route from a JSON
+// file (see docs/api-response-cache.md). Fresh entries are served without
+// touching the network, stale entries inside the stale-while-revalidate window
+// are served immediately while a background fetch refreshes them, and
+// identical requests that arrive while a fetch is in flight share that fetch.
+//
+// Upstream requests carry no credentials, so only responses that are the same
+// for every user can be cached. Requests with an Authorization or Cookie
+// header are left to the network (see ApiRequestInterceptor), and responses
+// that vary on credentials are not stored. The content negotiation headers in
+// varyHeaderNames() are forwarded and are part of the cache key.
+class ResponseCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Response {
+        QUrl url;
+        QByteArray contentType;
+        QByteArray body;
+        QByteArray etag;
+        QByteArray lastModified;
+        qint64 fetchedAtMs = 0;
+        // Upstream status; anything but 2xx is not cached and is left to the
+        // network, see passThrough()
+        int status = 200;
+
+        bool isValid() const { return fetchedAtMs > 0; }
+        bool isPassThrough() const { return status < 200 || status >= 300; }
+    };
+
+    struct Stats {
+        quint64 hits = 0;
+        quint64 staleHits = 0;
+        quint64 misses = 0;
+        quint64 coalesced = 0;
+        quint64 upstreamFetches = 0;
+        quint64 upstreamErrors = 0;
+        quint64 uncacheable = 0;
+        quint64 passedThrough = 0;
+    };
+
+    using Callback = std::function<void(const Response &response, bool ok)>;
+    // Request headers forwarded upstream, in the order of varyHeaderNames()
+    using RequestHeaders = QList<QPair<QByteArray, QByteArray>>;
+
+    static const QList<QByteArray> &varyHeaderNames();
+
+    explicit ResponseCache(QObject *parent = nullptr);
+
+    bool loadConfig(const QString &path);
+
+    bool matches(const QUrl &url) const;
+    void fetch(const QUrl &url, const RequestHeaders &headers, Callback callback);
+
+    // For responses the cache passes through: lets the next request for url
+    // reach the network, and returns the URL to redirect the page to, so it
+    // sees the real status and body
+    QUrl passThrough(const QUrl &url);
+    bool takePassThrough(const QUrl &url);
+
+    Stats stats() const { return m_stats; }
+    QString cacheDirectory() const { return m_cacheDir; }
+
+private:
+    struct Route {
+        QString prefix;
+        QRegularExpression pattern;
+        qint64 ttlMs = 0;
+        qint64 staleMs = 0;
+    };
+
+    const Route *routeFor(const QUrl &url) const;
+    QUrl upstreamUrl(const QUrl &url) const;
+    static QByteArray keyFor(const QUrl &url, const RequestHeaders &headers);
+
+    Response lookup(const QByteArray &key);
+    Response readEntry(const QByteArray &key) const;
+    void writeEntry(const QByteArray &key, const Response &response);
+    void startUpstream(const QUrl &url, const RequestHeaders &headers, const QByteArray &key,
+                       const Response &previous);
+    void finishUpstream(const QByteArray &key, const Response &response, bool ok);
+
+    QList<Route> m_routes;
+    QString m_cacheDir;
+    QUrl m_upstream;
+    qint64 m_maxDiskBytes;
+    QNetworkAccessManager *m_network;
+    QCache<QByteArray, Response> m_memory;
+    QHash<QByteArray, QList<Callback>> m_inflight;
+    QHash<QUrl, int> m_passThrough;
+    Stats m_stats;
+};
+
+#endif // RESPONSECACHE_H
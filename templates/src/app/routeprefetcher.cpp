@@ -0,0 +1,212 @@
+#include "routeprefetcher.h"
+#include "assetcache.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QFile>
+#include <QDebug>
+
+namespace {
+
+QStringList toStringList(const QJsonValue &value)
+{
+    QStringList list;
+    const QJsonArray array = value.toArray();
+    for (const QJsonValue &item : array) {
+        list << item.toString();
+    }
+    return list;
+}
+
+} // namespace
+
+RoutePrefetcher::RoutePrefetcher(AssetCache *cache, QObject *parent)
+    : QObject(parent), m_cache(cache), m_busy(false), m_idleStarted(false)
+{
+    // One reader is enough: the point is to stay ahead of the page, not to
+    // compete with it for the disk.
+    m_pool.setMaxThreadCount(1);
+}
+
+RoutePrefetcher::~RoutePrefetcher()
+{
+    m_queue.clear();
+    m_pool.waitForDone();
+}
+
+bool RoutePrefetcher::loadManifest()
+{
+    // Vite 5 writes .vite/manifest.json, older versions manifest.json
+    QFile file(m_cache->filePathFor(QStringLiteral(".vite/manifest.json")));
+    if (!file.exists()) {
+        file.setFileName(m_cache->filePathFor(QStringLiteral("manifest.json")));
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        qInfo() << "RoutePrefetcher: no Vite manifest in" << m_cache->rootPath() << "- route prefetch disabled";
+        return false;
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) {
+        qWarning() << "RoutePrefetcher: could not parse" << file.fileName();
+        return false;
+    }
+
+    const QJsonObject manifest = doc.object();
+    for (auto it = manifest.constBegin(); it != manifest.constEnd(); ++it) {
+        const QJsonObject chunk = it.value().toObject();
+        ManifestEntry entry;
+        entry.file = chunk.value("file").toString();
+        entry.name = chunk.value("name").toString();
+        entry.imports = toStringList(chunk.value("imports"));
+        entry.css = toStringList(chunk.value("css"));
+        entry.assets = toStringList(chunk.value("assets"));
+        entry.isEntry = chunk.value("isEntry").toBool();
+        entry.isDynamicEntry = chunk.value("isDynamicEntry").toBool();
+        m_manifest.insert(it.key(), entry);
+    }
+
+    // The entry chunk is needed for the very first paint, so start on it now.
+    QStringList entryFiles;
+    QSet<QString> visited;
+    for (auto it = m_manifest.constBegin(); it != m_manifest.constEnd(); ++it) {
+        if (it.value().isEntry) {
+            collectFiles(it.key(), entryFiles, visited);
+        }
+    }
+    enqueue(entryFiles, true);
+
+    qInfo() << "RoutePrefetcher: manifest has" << m_manifest.size() << "chunks," << routes().size() << "lazy routes";
+    return true;
+}
+
+QStringList RoutePrefetcher::routes() const
+{
+    QStringList result;
+    for (auto it = m_manifest.constBegin(); it != m_manifest.constEnd(); ++it) {
+        if (it.value().isDynamicEntry) {
+            result << it.key();
+        }
+    }
+    return result;
+}
+
+QString RoutePrefetcher::keyForRoute(const QString &route) const
+{
+    if (m_manifest.contains(route)) {
+        return route;
+    }
+    for (auto it = m_manifest.constBegin(); it != m_manifest.constEnd(); ++it) {
+        if (it.value().isDynamicEntry && it.value().name.compare(route, Qt::CaseInsensitive) == 0) {
+            return it.key();
+        }
+    }
+    return QString();
+}
+
+QStringList RoutePrefetcher::filesForRoute(const QString &route) const
+{
+    QStringList files;
+    QSet<QString> visited;
+    const QString key = keyForRoute(route);
+    if (!key.isEmpty()) {
+        collectFiles(key, files, visited);
+    }
+    return files;
+}
+
+void RoutePrefetcher::collectFiles(const QString &key, QStringList &files, QSet<QString> &visited) const
+{
+    if (visited.contains(key)) {
+        return;
+    }
+    visited.insert(key);
+    auto it = m_manifest.constFind(key);
+    if (it == m_manifest.constEnd()) {
+        return;
+    }
+    const ManifestEntry &entry = it.value();
+    if (!entry.file.isEmpty()) {
+        files << entry.file;
+    }
+    files << entry.css << entry.assets;
+    for (const QString &dependency : entry.imports) {
+        collectFiles(dependency, files, visited);
+    }
+}
+
+void RoutePrefetcher::hintRoutes(const QStringList &routes)
+{
+    QStringList files;
+    for (const QString &route : routes) {
+        const QStringList routeFiles = filesForRoute(route);
+        if (routeFiles.isEmpty()) {
+            qDebug() << "RoutePrefetcher: unknown route hint" << route;
+        }
+        files << routeFiles;
+    }
+    enqueue(files, true);
+}
+
+void RoutePrefetcher::startIdlePrefetch()
+{
+    if (m_idleStarted) {
+        return;
+    }
+    m_idleStarted = true;
+
+    QStringList files;
+    QSet<QString> visited;
+    for (const QString &route : routes()) {
+        collectFiles(route, files, visited);
+    }
+    enqueue(files, false);
+}
+
+void RoutePrefetcher::enqueue(const QStringList &files, bool urgent)
+{
+    int insertAt = 0;
+    for (const QString &file : files) {
+        if (urgent) {
+            // Hinted files jump the queue even if they were queued before
+            m_queue.removeAll(file);
+            if (m_cache->contains(file)) {
+                continue;
+            }
+            m_queue.insert(insertAt++, file);
+            m_seen.insert(file);
+            m_urgent.insert(file);
+        } else if (!m_seen.contains(file)) {
+            m_queue.append(file);
+            m_seen.insert(file);
+        }
+    }
+    pump();
+}
+
+void RoutePrefetcher::pump()
+{
+    if (m_busy || m_queue.isEmpty()) {
+        return;
+    }
+
+    // Idle prefetch must not push already cached chunks out of the cache
+    if (!m_urgent.contains(m_queue.first()) && m_cache->stats().bytes > m_cache->maxBytes() * 3 / 4) {
+        qInfo() << "RoutePrefetcher: asset cache budget reached, leaving" << m_queue.size() << "files on disk";
+        m_queue.clear();
+        return;
+    }
+
+    m_busy = true;
+    const QString file = m_queue.takeFirst();
+    m_urgent.remove(file);
+    AssetCache *cache = m_cache;
+    m_pool.start([this, cache, file]() {
+        if (!cache->preload(file)) {
+            qWarning() << "RoutePrefetcher: could not preload" << file;
+        }
+        QMetaObject::invokeMethod(this, [this]() {
+            m_busy = false;
+            pump();
+        }, Qt::QueuedConnection);
+    });
+}
@@ -0,0 +1,62 @@
+#ifndef ROUTEPREFETCHER_H
+#define ROUTEPREFETCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+
+class AssetCache;
+
+// Reads the Vite build manifest of the frontend and loads each route's JS/CSS
+// chunks into the AssetCache ahead of navigation. The entry chunk is loaded
+// right away; lazily imported routes are loaded once the page is idle, with
+// routes hinted by the frontend (see hintRoutes) moved to the front.
+//
+// Published to the page as "prefetch".
+class RoutePrefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RoutePrefetcher(AssetCache *cache, QObject *parent = nullptr);
+    ~RoutePrefetcher();
+
+    bool loadManifest();
+
+    QStringList routes() const;
+    QStringList filesForRoute(const QString &route) const;
+
+public slots:
+    // Routes are manifest keys ("src/pages/Settings.vue") or chunk names ("Settings")
+    void hintRoutes(const QStringList &routes);
+    void startIdlePrefetch();
+
+private:
+    struct ManifestEntry {
+        QString file;
+        QString name;
+        QStringList imports;
+        QStringList css;
+        QStringList assets;
+        bool isEntry = false;
+        bool isDynamicEntry = false;
+    };
+
+    QString keyForRoute(const QString &route) const;
+    void collectFiles(const QString &key, QStringList &files, QSet<QString> &visited) const;
+    void enqueue(const QStringList &files, bool urgent);
+    void pump();
+
+    AssetCache *m_cache;
+    QHash<QString, ManifestEntry> m_manifest;
+    QStringList m_queue;
+    QSet<QString> m_seen;
+    QSet<QString> m_urgent;
+    bool m_busy;
+    bool m_idleStarted;
+    QThreadPool m_pool;
+};
+
+#endif // ROUTEPREFETCHER_H
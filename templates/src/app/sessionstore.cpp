@@ -0,0 +1,170 @@
+#include "sessionstore.h"
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+#include <QWebEngineScriptCollection>
+#include <QJsonDocument>
+#include <QJsonValue>
+#include <QCborValue>
+#include <QStandardPaths>
+#include <QSaveFile>
+#include <QFile>
+#include <QDir>
+#include <QMutexLocker>
+#include <QDebug>
+
+namespace {
+
+const char kScriptName[] = "taqyon-session";
+const int kWriteDelayMs = 1000;
+
+// RFC 7396: null removes a key, objects merge recursively, anything else replaces
+QJsonObject applyMergePatch(QJsonObject target, const QJsonObject &patch)
+{
+    for (auto it = patch.constBegin(); it != patch.constEnd(); ++it) {
+        if (it.value().isNull()) {
+            target.remove(it.key());
+        } else if (it.value().isObject()) {
+            target.insert(it.key(), applyMergePatch(target.value(it.key()).toObject(), it.value().toObject()));
+        } else {
+            target.insert(it.key(), it.value());
+        }
+    }
+    return target;
+}
+
+} // namespace
+
+SessionStore::SessionStore(QObject *parent)
+    : QObject(parent), m_dirty(false)
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    m_filePath = dir + "/session.cbor";
+
+    m_writer.setMaxThreadCount(1);
+    m_writeTimer.setSingleShot(true);
+    m_writeTimer.setInterval(kWriteDelayMs);
+    connect(&m_writeTimer, &QTimer::timeout, this, [this]() {
+        QJsonObject state;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (!m_dirty) {
+                return;
+            }
+            m_dirty = false;
+            state = m_state;
+        }
+        m_writer.start([this, state]() { writeState(state); });
+        updateInjectedScript();
+    });
+}
+
+SessionStore::~SessionStore()
+{
+    m_writer.waitForDone();
+    writeNow();
+}
+
+void SessionStore::load()
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QCborValue value = QCborValue::fromCbor(file.readAll());
+    if (!value.isMap()) {
+        qWarning() << "SessionStore: ignoring unreadable session file" << m_filePath;
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_state = value.toJsonValue().toObject();
+    qInfo() << "SessionStore: restored session with" << m_state.size() << "keys from" << m_filePath;
+}
+
+void SessionStore::attachToPage(QWebEnginePage *page)
+{
+    m_page = page;
+    updateInjectedScript();
+}
+
+void SessionStore::applySnapshot(const QJsonObject &patch)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_state = applyMergePatch(m_state, patch);
+        m_dirty = true;
+    }
+    scheduleWrite();
+}
+
+void SessionStore::clear()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_state = QJsonObject();
+        m_dirty = true;
+    }
+    scheduleWrite();
+}
+
+void SessionStore::scheduleWrite()
+{
+    // Snapshots arrive in bursts; coalesce them into one write
+    if (!m_writeTimer.isActive()) {
+        m_writeTimer.start();
+    }
+}
+
+void SessionStore::writeNow()
+{
+    QJsonObject state;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_dirty) {
+            return;
+        }
+        m_dirty = false;
+        state = m_state;
+    }
+    writeState(state);
+}
+
+void SessionStore::writeState(const QJsonObject &state)
+{
+    QMutexLocker locker(&m_fileMutex);
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "SessionStore: could not write" << m_filePath;
+        return;
+    }
+    file.write(QCborValue::fromJsonValue(state).toCbor());
+    if (!file.commit()) {
+        qWarning() << "SessionStore: could not commit" << m_filePath;
+    }
+}
+
+void SessionStore::updateInjectedScript()
+{
+    if (!m_page) {
+        return;
+    }
+    QByteArray json;
+    {
+        QMutexLocker locker(&m_mutex);
+        json = QJsonDocument(m_state).toJson(QJsonDocument::Compact);
+    }
+
+    QWebEngineScript script;
+    script.setName(QString::fromLatin1(kScriptName));
+    script.setInjectionPoint(QWebEngineScript::DocumentCreation);
+    script.setWorldId(QWebEngineScript::MainWorld);
+    script.setRunsOnSubFrames(false);
+    script.setSourceCode(QStringLiteral("window.__TAQYON_SESSION__ = %1;").arg(QString::fromUtf8(json)));
+
+    QWebEngineScriptCollection &scripts = m_page->scripts();
+    const QList<QWebEngineScript> existing = scripts.find(QString::fromLatin1(kScriptName));
+    for (const QWebEngineScript &old : existing) {
+        scripts.remove(old);
+    }
+    scripts.insert(script);
+}
@@ -0,0 +1,55 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QObject>
+#include <QPointer>
+#include <QJsonObject>
+#include <QMutex>
+#include <QTimer>
+#include <QString>
+#include <QThreadPool>
+
+class QWebEnginePage;
+
+// Keeps the frontend's session state (router position, scroll offsets,
+// loaded data) across restarts. The page sends JSON merge patches (RFC 7396)
+// with only what changed since its last snapshot; they are applied in memory
+// and written to a compact CBOR file off the GUI thread. On the next launch
+// the stored state is injected at document creation as
+// window.__TAQYON_SESSION__, before any frontend code runs.
+//
+// Published to the page as "session".
+class SessionStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SessionStore(QObject *parent = nullptr);
+    ~SessionStore();
+
+    void load();
+    void attachToPage(QWebEnginePage *page);
+
+    // Thread-safe; used by the shutdown coordinator
+    void writeNow();
+
+public slots:
+    void applySnapshot(const QJsonObject &patch);
+    void clear();
+
+private:
+    void scheduleWrite();
+    void writeState(const QJsonObject &state);
+    void updateInjectedScript();
+
+    QString m_filePath;
+    QJsonObject m_state;
+    bool m_dirty;
+    mutable QMutex m_mutex;
+    QMutex m_fileMutex;
+    QTimer m_writeTimer;
+    QThreadPool m_writer;
+    QPointer<QWebEnginePage> m_page;
+};
+
+#endif // SESSIONSTORE_H
@@ -0,0 +1,152 @@
+#include "shutdowncoordinator.h"
+#include "app_setup.h"
+#include <QApplication>
+#include <QWidget>
+#include <QThreadPool>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QDebug>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+ShutdownWatchdog::ShutdownWatchdog()
+    : m_disarmed(false)
+{
+}
+
+ShutdownWatchdog::~ShutdownWatchdog()
+{
+    if (m_thread.joinable()) {
+        const qint64 elapsed = m_timer.elapsed();
+        disarm();
+        qInfo() << "Shutdown: teardown took" << elapsed << "ms";
+    }
+}
+
+void ShutdownWatchdog::arm(int deadlineMs, int exitCode)
+{
+    if (m_thread.joinable()) {
+        return;
+    }
+    m_timer.start();
+    m_thread = std::thread([this, deadlineMs, exitCode]() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_condition.wait_for(lock, std::chrono::milliseconds(deadlineMs), [this]() { return m_disarmed; })) {
+            return;
+        }
+        // The GUI thread is stuck in teardown; nothing left to save, so leave now.
+        const QString line = QString("Shutdown: teardown exceeded %1 ms deadline, exiting").arg(deadlineMs);
+        fprintf(stderr, "%s\n", qPrintable(line));
+        appendToLogFile(line);
+        flushLogFile();
+        std::_Exit(exitCode);
+    });
+}
+
+void ShutdownWatchdog::disarm()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_disarmed = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+ShutdownCoordinator::ShutdownCoordinator(ShutdownWatchdog *watchdog, QObject *parent)
+    : QObject(parent),
+      m_watchdog(watchdog),
+      m_flushDeadlineMs(2000),
+      m_teardownDeadlineMs(1000),
+      m_shuttingDown(false)
+{
+    // Quitting by other means (last window closed, session end) still flushes
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+        if (!m_shuttingDown) {
+            runPhases(0);
+        }
+    });
+}
+
+void ShutdownCoordinator::addFlushTask(const QString &name, FlushTask task)
+{
+    m_flushTasks.append(qMakePair(name, std::move(task)));
+}
+
+void ShutdownCoordinator::shutdown(int exitCode)
+{
+    if (m_shuttingDown) {
+        return;
+    }
+    runPhases(exitCode);
+    QCoreApplication::exit(exitCode);
+}
+
+void ShutdownCoordinator::runPhases(int exitCode)
+{
+    m_shuttingDown = true;
+    QElapsedTimer phase;
+    phase.start();
+
+    // Phase 1: get out of the user's way
+    emit aboutToShutdown();
+    const QWidgetList windows = QApplication::topLevelWidgets();
+    for (QWidget *window : windows) {
+        window->hide();
+    }
+    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+    const qint64 hideMs = phase.restart();
+
+    // Phase 2: flush tasks in parallel. State is shared through a pointer
+    // because tasks that miss the deadline are left running.
+    struct FlushState {
+        QMutex mutex;
+        QStringList timings;
+    };
+    auto state = std::make_shared<FlushState>();
+    QThreadPool *pool = new QThreadPool;
+    pool->setMaxThreadCount(qMax(1, static_cast<int>(m_flushTasks.size())));
+    for (const auto &entry : m_flushTasks) {
+        const QString name = entry.first;
+        const FlushTask task = entry.second;
+        pool->start([state, name, task]() {
+            QElapsedTimer timer;
+            timer.start();
+            task();
+            QMutexLocker locker(&state->mutex);
+            state->timings << QString("%1 %2 ms").arg(name).arg(timer.elapsed());
+        });
+    }
+    const bool flushed = pool->waitForDone(m_flushDeadlineMs);
+    const qint64 flushMs = phase.restart();
+
+    QStringList timings;
+    {
+        QMutexLocker locker(&state->mutex);
+        timings = state->timings;
+    }
+    qInfo().noquote() << QString("Shutdown: hide %1 ms, flush %2 ms (%3)")
+                             .arg(hideMs).arg(flushMs).arg(timings.join(", "));
+    if (!flushed) {
+        // The stragglers write through references to objects on main()'s
+        // stack, so returning into its destructors would pull them out from
+        // under the workers. Leave now; files written with QSaveFile keep
+        // their previous contents.
+        const QString line = QString("Shutdown: flush tasks still running after %1 ms deadline, exiting")
+                                 .arg(m_flushDeadlineMs);
+        fprintf(stderr, "%s\n", qPrintable(line));
+        appendToLogFile(line);
+        flushLogFile();
+        std::_Exit(exitCode);
+    }
+    delete pool;
+    flushLogFile();
+
+    // Phase 3: WebEngine teardown happens as main() unwinds, under the watchdog
+    if (m_watchdog) {
+        m_watchdog->arm(m_teardownDeadlineMs, exitCode);
+    }
+}
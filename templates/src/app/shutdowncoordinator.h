@@ -0,0 +1,75 @@
+#ifndef SHUTDOWNCOORDINATOR_H
+#define SHUTDOWNCOORDINATOR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Bounds the time spent tearing down QtWebEngine after the event loop has
+// stopped. Declared in main() before QApplication so that it outlives the
+// profile, view and renderer teardown it watches; if that teardown runs past
+// the deadline the process exits on the spot.
+class ShutdownWatchdog
+{
+public:
+    ShutdownWatchdog();
+    ~ShutdownWatchdog();
+
+    void arm(int deadlineMs, int exitCode);
+
+private:
+    void disarm();
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_disarmed;
+    QElapsedTimer m_timer;
+};
+
+// Runs the shutdown sequence: hide every window immediately, run the
+// registered flush tasks (logs, persistent backend state) in parallel, then
+// leave the event loop with the watchdog armed for the WebEngine teardown.
+// Each phase is timed and logged. If the flush tasks miss their deadline the
+// process exits on the spot, since tasks may reference objects that main()
+// would otherwise destroy under them.
+class ShutdownCoordinator : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Flush tasks run on worker threads and must be thread-safe
+    using FlushTask = std::function<void()>;
+
+    explicit ShutdownCoordinator(ShutdownWatchdog *watchdog, QObject *parent = nullptr);
+
+    void addFlushTask(const QString &name, FlushTask task);
+    void setFlushDeadline(int ms) { m_flushDeadlineMs = ms; }
+    void setTeardownDeadline(int ms) { m_teardownDeadlineMs = ms; }
+
+    bool isShuttingDown() const { return m_shuttingDown; }
+
+public slots:
+    void shutdown(int exitCode = 0);
+
+signals:
+    // Emitted before any window is hidden
+    void aboutToShutdown();
+
+private:
+    void runPhases(int exitCode);
+
+    ShutdownWatchdog *m_watchdog;
+    QList<QPair<QString, FlushTask>> m_flushTasks;
+    int m_flushDeadlineMs;
+    int m_teardownDeadlineMs;
+    bool m_shuttingDown;
+};
+
+#endif // SHUTDOWNCOORDINATOR_H
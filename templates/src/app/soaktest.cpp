@@ -0,0 +1,536 @@
+#include "soaktest.h"
+#include "metrics.h"
+#include "processmemory.h"
+#include "tabmanager.h"
+#include "mywebview.h"
+#include <QWebEngineView>
+#include <QWebEnginePage>
+#include <QWebChannel>
+#include <QApplication>
+#include <QWidget>
+#include <QMetaProperty>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QSet>
+#include <QDebug>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+const int kLagIntervalMs = 100;
+
+int countObjects(const QObject *object)
+{
+    int count = 1;
+    for (const QObject *child : object->children()) {
+        count += countObjects(child);
+    }
+    return count;
+}
+
+} // namespace
+
+SoakTest::SoakTest(QWebEngineView *view, QWebChannel *channel, QObject *parent)
+    : QObject(parent),
+      m_view(view),
+      m_channel(channel),
+      m_durationSec(3600),
+      m_sampleIntervalSec(10),
+      m_actionIntervalMs(50),
+      m_floodSize(500),
+      m_maxWindows(3),
+      m_warmupFraction(0.2),
+      m_leakThresholdPercent(5.0),
+      m_objects({QStringLiteral("backend")}),
+      m_seed(0),
+      m_lagMaxMs(0),
+      m_lagTotalMs(0),
+      m_lagTicks(0)
+{
+    m_weights.insert(QStringLiteral("slot"), 40);
+    m_weights.insert(QStringLiteral("property"), 30);
+    m_weights.insert(QStringLiteral("signalFlood"), 5);
+    m_weights.insert(QStringLiteral("window"), 5);
+    m_weights.insert(QStringLiteral("reload"), 1);
+
+    connect(&m_actionTimer, &QTimer::timeout, this, &SoakTest::performAction);
+    // Checked on each sample rather than with a timer: QTimer cannot span weeks
+    connect(&m_sampleTimer, &QTimer::timeout, this, [this]() {
+        sample();
+        if (m_clock.elapsed() >= qint64(m_durationSec) * 1000) {
+            finish();
+        }
+    });
+    m_lagTimer.setTimerType(Qt::PreciseTimer);
+    m_lagTimer.setInterval(kLagIntervalMs);
+    connect(&m_lagTimer, &QTimer::timeout, this, &SoakTest::measureLag);
+}
+
+bool SoakTest::loadConfig(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "SoakTest: could not open config" << path;
+        return false;
+    }
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (!document.isObject()) {
+        qWarning() << "SoakTest: invalid config" << path << error.errorString();
+        return false;
+    }
+    const QJsonObject config = document.object();
+    m_durationSec = config.value(QStringLiteral("durationSec")).toInt(m_durationSec);
+    m_sampleIntervalSec = qMax(1, config.value(QStringLiteral("sampleIntervalSec")).toInt(m_sampleIntervalSec));
+    m_actionIntervalMs = qMax(1, config.value(QStringLiteral("actionIntervalMs")).toInt(m_actionIntervalMs));
+    m_floodSize = config.value(QStringLiteral("signalFloodSize")).toInt(m_floodSize);
+    m_maxWindows = config.value(QStringLiteral("maxWindows")).toInt(m_maxWindows);
+    m_warmupFraction = qBound(0.0, config.value(QStringLiteral("warmupFraction")).toDouble(m_warmupFraction), 0.9);
+    m_leakThresholdPercent = config.value(QStringLiteral("leakThresholdPercent")).toDouble(m_leakThresholdPercent);
+    m_seed = static_cast<quint32>(config.value(QStringLiteral("seed")).toInteger(m_seed));
+    if (config.contains(QStringLiteral("objects"))) {
+        m_objects.clear();
+        const QJsonArray objects = config.value(QStringLiteral("objects")).toArray();
+        for (const QJsonValue &object : objects) {
+            m_objects << object.toString();
+        }
+    }
+    const QJsonObject weights = config.value(QStringLiteral("weights")).toObject();
+    for (auto it = weights.constBegin(); it != weights.constEnd(); ++it) {
+        if (m_weights.contains(it.key())) {
+            m_weights.insert(it.key(), qMax(0, it.value().toInt()));
+        } else {
+            qWarning() << "SoakTest: unknown action" << it.key();
+        }
+    }
+    return true;
+}
+
+void SoakTest::start()
+{
+    if (m_seed == 0) {
+        m_seed = QRandomGenerator::system()->generate();
+    }
+    m_random.seed(m_seed);
+    if (m_reportPath.isEmpty()) {
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dir);
+        m_reportPath = dir + QString("/soak-report-%1.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+    }
+#ifndef Q_OS_LINUX
+    qWarning() << "SoakTest: memory and file descriptor sampling is only implemented on Linux";
+#endif
+    qInfo() << "SoakTest: running for" << m_durationSec << "s with seed" << m_seed
+            << "on" << m_objects << "; report:" << m_reportPath;
+
+    m_clock.start();
+    m_lagClock.start();
+    m_actionTimer.start(m_actionIntervalMs);
+    m_sampleTimer.start(m_sampleIntervalSec * 1000);
+    m_lagTimer.start();
+    sample();
+}
+
+void SoakTest::performAction()
+{
+    int total = 0;
+    for (int weight : std::as_const(m_weights)) {
+        total += weight;
+    }
+    if (total == 0) {
+        return;
+    }
+    int pick = m_random.bounded(total);
+    QString action;
+    for (auto it = m_weights.constBegin(); it != m_weights.constEnd(); ++it) {
+        if (pick < it.value()) {
+            action = it.key();
+            break;
+        }
+        pick -= it.value();
+    }
+
+    bool done = true;
+    if (action == QLatin1String("slot")) {
+        done = callRandomSlot();
+    } else if (action == QLatin1String("property")) {
+        done = writeRandomProperty();
+    } else if (action == QLatin1String("signalFlood")) {
+        done = floodSignal();
+    } else if (action == QLatin1String("window")) {
+        openOrCloseWindow();
+    } else if (action == QLatin1String("reload")) {
+        reloadPage();
+    }
+    if (done) {
+        ++m_actionCounts[action];
+        Metrics::global().addCount(QStringLiteral("soak.actions.") + action);
+    }
+}
+
+QObject *SoakTest::randomTarget()
+{
+    if (m_objects.isEmpty()) {
+        return nullptr;
+    }
+    const QHash<QString, QObject *> registered = m_channel->registeredObjects();
+    return registered.value(m_objects.at(m_random.bounded(static_cast<int>(m_objects.size()))));
+}
+
+bool SoakTest::callRandomSlot()
+{
+    QObject *target = randomTarget();
+    if (!target) {
+        return false;
+    }
+    const QMetaObject *metaObject = target->metaObject();
+    QList<QMetaMethod> candidates;
+    for (int i = QObject::staticMetaObject.methodCount(); i < metaObject->methodCount(); ++i) {
+        const QMetaMethod method = metaObject->method(i);
+        if (method.access() == QMetaMethod::Public
+            && (method.methodType() == QMetaMethod::Slot || method.methodType() == QMetaMethod::Method)) {
+            candidates.append(method);
+        }
+    }
+    if (candidates.isEmpty()) {
+        return false;
+    }
+    const QMetaMethod method = candidates.at(m_random.bounded(static_cast<int>(candidates.size())));
+    QVariantList args;
+    if (!randomArguments(method, args)) {
+        return false;
+    }
+    QGenericArgument arguments[10];
+    for (int i = 0; i < args.size(); ++i) {
+        arguments[i] = QGenericArgument(args.at(i).typeName(), args.at(i).constData());
+    }
+    return method.invoke(target, Qt::DirectConnection,
+                         arguments[0], arguments[1], arguments[2], arguments[3], arguments[4],
+                         arguments[5], arguments[6], arguments[7], arguments[8], arguments[9]);
+}
+
+bool SoakTest::writeRandomProperty()
+{
+    QObject *target = randomTarget();
+    if (!target) {
+        return false;
+    }
+    const QMetaObject *metaObject = target->metaObject();
+    QList<QMetaProperty> candidates;
+    for (int i = QObject::staticMetaObject.propertyCount(); i < metaObject->propertyCount(); ++i) {
+        if (metaObject->property(i).isWritable()) {
+            candidates.append(metaObject->property(i));
+        }
+    }
+    if (candidates.isEmpty()) {
+        return false;
+    }
+    const QMetaProperty property = candidates.at(m_random.bounded(static_cast<int>(candidates.size())));
+    bool ok = false;
+    const QVariant value = randomValue(property.metaType(), &ok);
+    return ok && property.write(target, value);
+}
+
+bool SoakTest::floodSignal()
+{
+    QObject *target = randomTarget();
+    if (!target) {
+        return false;
+    }
+    const QMetaObject *metaObject = target->metaObject();
+    QList<QMetaMethod> signalList;
+    for (int i = QObject::staticMetaObject.methodCount(); i < metaObject->methodCount(); ++i) {
+        if (metaObject->method(i).methodType() == QMetaMethod::Signal) {
+            signalList.append(metaObject->method(i));
+        }
+    }
+    if (signalList.isEmpty()) {
+        return false;
+    }
+    // Every emission goes to the page through the channel
+    const QMetaMethod signal = signalList.at(m_random.bounded(static_cast<int>(signalList.size())));
+    for (int n = 0; n < m_floodSize; ++n) {
+        QVariantList args;
+        if (!randomArguments(signal, args)) {
+            return false;
+        }
+        QGenericArgument arguments[10];
+        for (int i = 0; i < args.size(); ++i) {
+            arguments[i] = QGenericArgument(args.at(i).typeName(), args.at(i).constData());
+        }
+        signal.invoke(target, Qt::DirectConnection,
+                      arguments[0], arguments[1], arguments[2], arguments[3], arguments[4],
+                      arguments[5], arguments[6], arguments[7], arguments[8], arguments[9]);
+    }
+    return true;
+}
+
+void SoakTest::setTabManager(TabManager *tabs)
+{
+    m_tabManager = tabs;
+    // Tabs may open after the action that asked for them, so they are
+    // counted when they appear
+    connect(tabs, &TabManager::tabOpened, this, [this](MyWebView *view) {
+        if (m_clock.isValid()) {
+            m_openedWindows.append(view);
+        }
+    });
+}
+
+void SoakTest::openOrCloseWindow()
+{
+    m_openedWindows.removeAll(QPointer<QWidget>());
+    const QWidgetList existing = QApplication::topLevelWidgets();
+    const QSet<QWidget *> before(existing.cbegin(), existing.cend());
+    if (m_view && m_openedWindows.size() < m_maxWindows && m_random.bounded(2) == 0) {
+        // View Source goes through MyWebView::createWindow like window.open() does
+        m_view->page()->triggerAction(QWebEnginePage::ViewSource);
+        const QWidgetList after = QApplication::topLevelWidgets();
+        for (QWidget *widget : after) {
+            if (!before.contains(widget)) {
+                m_openedWindows.append(widget);
+            }
+        }
+    } else if (!m_openedWindows.isEmpty()) {
+        QPointer<QWidget> window = m_openedWindows.takeFirst();
+        MyWebView *tab = qobject_cast<MyWebView *>(window.data());
+        if (tab && m_tabManager) {
+            m_tabManager->closeTab(tab);
+        } else if (window) {
+            window->close();
+        }
+    }
+}
+
+void SoakTest::reloadPage()
+{
+    if (m_view) {
+        m_view->reload();
+    }
+}
+
+bool SoakTest::randomArguments(const QMetaMethod &method, QVariantList &args)
+{
+    if (method.parameterCount() > 10) {
+        return false;
+    }
+    for (int i = 0; i < method.parameterCount(); ++i) {
+        bool ok = false;
+        args.append(randomValue(method.parameterMetaType(i), &ok));
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QVariant SoakTest::randomValue(QMetaType type, bool *ok)
+{
+    *ok = true;
+    switch (type.id()) {
+    case QMetaType::Bool:
+        return QVariant(m_random.bounded(2) == 1);
+    case QMetaType::Int:
+        return QVariant(m_random.bounded(-1000, 1000));
+    case QMetaType::UInt:
+        return QVariant(m_random.bounded(1000u));
+    case QMetaType::LongLong:
+        return QVariant(static_cast<qlonglong>(m_random.bounded(-1000000, 1000000)));
+    case QMetaType::Double:
+        return QVariant(m_random.bounded(2000.0) - 1000.0);
+    case QMetaType::QString: {
+        QString text;
+        const int length = m_random.bounded(64);
+        for (int i = 0; i < length; ++i) {
+            text.append(QChar(static_cast<ushort>(m_random.bounded(32, 127))));
+        }
+        return QVariant(text);
+    }
+    case QMetaType::QByteArray: {
+        QByteArray bytes(4 * m_random.bounded(64), Qt::Uninitialized);
+        m_random.fillRange(reinterpret_cast<quint32 *>(bytes.data()), bytes.size() / 4);
+        return QVariant(bytes);
+    }
+    case QMetaType::QStringList:
+        return QVariant(QStringList{QString::number(m_random.generate()), QString::number(m_random.generate())});
+    case QMetaType::QJsonObject: {
+        QJsonObject object;
+        object.insert(QStringLiteral("value"), static_cast<qint64>(m_random.generate()));
+        return QVariant(object);
+    }
+    case QMetaType::QJsonArray:
+        return QVariant(QJsonArray{static_cast<qint64>(m_random.generate())});
+    default:
+        *ok = false;
+        return QVariant();
+    }
+}
+
+void SoakTest::measureLag()
+{
+    const double lag = qMax(0.0, m_lagClock.nsecsElapsed() / 1e6 - kLagIntervalMs);
+    m_lagClock.restart();
+    m_lagMaxMs = qMax(m_lagMaxMs, lag);
+    m_lagTotalMs += lag;
+    ++m_lagTicks;
+}
+
+void SoakTest::sample()
+{
+    Sample sample;
+    sample.elapsedSec = m_clock.elapsed() / 1000.0;
+
+#ifdef Q_OS_LINUX
+    const ProcessTreeMemory memory = sampleProcessTreeMemory();
+    sample.values.insert(QStringLiteral("rssKb"), memory.self.rssKb);
+    if (memory.self.pssKb >= 0) {
+        sample.values.insert(QStringLiteral("pssKb"), memory.self.pssKb);
+        sample.values.insert(QStringLiteral("childPssKb"), memory.childPssKb);
+        sample.values.insert(QStringLiteral("totalPssKb"), memory.totalPssKb());
+    }
+    sample.values.insert(QStringLiteral("childRssKb"), memory.childRssKb);
+    sample.values.insert(QStringLiteral("childProcesses"), memory.childProcesses);
+    sample.values.insert(QStringLiteral("fileDescriptors"), openFileDescriptorCount());
+#endif
+
+    int objects = countObjects(QCoreApplication::instance());
+    const QWidgetList topLevels = QApplication::topLevelWidgets();
+    for (const QWidget *widget : topLevels) {
+        objects += countObjects(widget);
+    }
+    sample.values.insert(QStringLiteral("qobjects"), objects);
+    sample.values.insert(QStringLiteral("topLevelWindows"), topLevels.size());
+    if (m_tabManager) {
+        sample.values.insert(QStringLiteral("tabs"), m_tabManager->stats().value(QStringLiteral("tabs")).toInt());
+    }
+    sample.values.insert(QStringLiteral("publishedObjects"), m_channel->registeredObjects().size());
+    if (m_lagTicks > 0) {
+        sample.values.insert(QStringLiteral("eventLoopLagMaxMs"), m_lagMaxMs);
+        sample.values.insert(QStringLiteral("eventLoopLagMeanMs"), m_lagTotalMs / m_lagTicks);
+    }
+    m_lagMaxMs = 0;
+    m_lagTotalMs = 0;
+    m_lagTicks = 0;
+
+    for (auto it = sample.values.constBegin(); it != sample.values.constEnd(); ++it) {
+        Metrics::global().setGauge(QStringLiteral("soak.") + it.key(), it.value());
+    }
+    m_samples.append(sample);
+}
+
+QJsonObject SoakTest::analyze(QStringList &leaks) const
+{
+    QSet<QString> names;
+    for (const Sample &sample : m_samples) {
+        for (auto it = sample.values.constBegin(); it != sample.values.constEnd(); ++it) {
+            names.insert(it.key());
+        }
+    }
+
+    // Least-squares line through the samples after warm-up, per metric
+    const int first = static_cast<int>(m_samples.size() * m_warmupFraction);
+    QJsonObject trends;
+    for (const QString &name : std::as_const(names)) {
+        double n = 0, sumX = 0, sumY = 0, sumXX = 0, sumXY = 0, sumYY = 0;
+        for (int i = first; i < m_samples.size(); ++i) {
+            if (!m_samples.at(i).values.contains(name)) {
+                continue;
+            }
+            const double x = m_samples.at(i).elapsedSec;
+            const double y = m_samples.at(i).values.value(name);
+            n += 1;
+            sumX += x;
+            sumY += y;
+            sumXX += x * x;
+            sumXY += x * y;
+            sumYY += y * y;
+        }
+        if (n < 5) {
+            continue;
+        }
+        const double varX = n * sumXX - sumX * sumX;
+        const double varY = n * sumYY - sumY * sumY;
+        if (varX <= 0) {
+            continue;
+        }
+        const double slope = (n * sumXY - sumX * sumY) / varX;
+        const double intercept = (sumY - slope * sumX) / n;
+        const double r2 = varY > 0 ? std::pow(n * sumXY - sumX * sumY, 2) / (varX * varY) : 0;
+        const double startX = m_samples.at(first).elapsedSec;
+        const double endX = m_samples.last().elapsedSec;
+        const double startY = intercept + slope * startX;
+        const double growthPercent = startY != 0 ? slope * (endX - startX) / std::fabs(startY) * 100 : 0;
+        // A steady climb, not noise around a flat line
+        const bool suspected = slope > 0 && growthPercent > m_leakThresholdPercent && r2 > 0.5;
+
+        QJsonObject trend;
+        trend.insert(QStringLiteral("slopePerHour"), slope * 3600);
+        trend.insert(QStringLiteral("growthPercent"), growthPercent);
+        trend.insert(QStringLiteral("r2"), r2);
+        trend.insert(QStringLiteral("suspectedLeak"), suspected);
+        trends.insert(name, trend);
+        if (suspected) {
+            leaks << name;
+        }
+    }
+    leaks.sort();
+    return trends;
+}
+
+void SoakTest::finish()
+{
+    m_actionTimer.stop();
+    m_sampleTimer.stop();
+    m_lagTimer.stop();
+
+    QStringList leaks;
+    QJsonObject report;
+    report.insert(QStringLiteral("seed"), static_cast<qint64>(m_seed));
+    report.insert(QStringLiteral("durationSec"), m_clock.elapsed() / 1000.0);
+    report.insert(QStringLiteral("objects"), QJsonArray::fromStringList(m_objects));
+    QJsonObject actions;
+    for (auto it = m_actionCounts.constBegin(); it != m_actionCounts.constEnd(); ++it) {
+        actions.insert(it.key(), it.value());
+    }
+    report.insert(QStringLiteral("actions"), actions);
+    report.insert(QStringLiteral("trends"), analyze(leaks));
+    report.insert(QStringLiteral("suspectedLeaks"), QJsonArray::fromStringList(leaks));
+    QJsonArray samples;
+    for (const Sample &sample : std::as_const(m_samples)) {
+        QJsonObject entry;
+        entry.insert(QStringLiteral("t"), sample.elapsedSec);
+        for (auto it = sample.values.constBegin(); it != sample.values.constEnd(); ++it) {
+            entry.insert(it.key(), it.value());
+        }
+        samples.append(entry);
+    }
+    report.insert(QStringLiteral("samples"), samples);
+
+    if (writeReport(report)) {
+        qInfo() << "SoakTest: report written to" << m_reportPath;
+    }
+    if (leaks.isEmpty()) {
+        qInfo() << "SoakTest: finished," << m_samples.size() << "samples, no suspected leaks";
+    } else {
+        qWarning() << "SoakTest: finished," << m_samples.size() << "samples, suspected leaks in" << leaks;
+    }
+    emit finished(!leaks.isEmpty());
+}
+
+bool SoakTest::writeReport(const QJsonObject &report) const
+{
+    QSaveFile file(m_reportPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "SoakTest: could not write report" << m_reportPath;
+        return false;
+    }
+    file.write(QJsonDocument(report).toJson());
+    return file.commit();
+}
@@ -0,0 +1,110 @@
+#ifndef SOAKTEST_H
+#define SOAKTEST_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QMetaMethod>
+#include <QMetaType>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVariant>
+#include <QVector>
+
+class QWebChannel;
+class QWebEngineView;
+class QWidget;
+class TabManager;
+
+// Long-running soak test. Runs a randomized synthetic workload against the
+// app (backend slot calls, property writes, signal floods, tabs opened
+// through createWindow and closed again, page reloads) while sampling memory
+// (RSS/PSS of the app and its WebEngine child processes), open file
+// descriptors, live QObjects and event-loop lag. At the end every sampled
+// metric is fitted with a linear trend; metrics that keep growing are
+// reported as suspected leaks.
+//
+// Configured from a JSON file (see docs/soak-testing.md); the duration and
+// report path can be overridden from the command line.
+class SoakTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    SoakTest(QWebEngineView *view, QWebChannel *channel, QObject *parent = nullptr);
+
+    bool loadConfig(const QString &path);
+    void setDuration(int seconds) { m_durationSec = seconds; }
+    void setReportPath(const QString &path) { m_reportPath = path; }
+    // Windows opened through createWindow become tabs of tabs
+    void setTabManager(TabManager *tabs);
+
+public slots:
+    void start();
+
+signals:
+    void finished(bool leaksSuspected);
+
+private:
+    struct Sample {
+        double elapsedSec = 0;
+        QHash<QString, double> values;
+    };
+
+    void performAction();
+    bool callRandomSlot();
+    bool writeRandomProperty();
+    bool floodSignal();
+    void openOrCloseWindow();
+    void reloadPage();
+
+    QObject *randomTarget();
+    bool randomArguments(const QMetaMethod &method, QVariantList &args);
+    QVariant randomValue(QMetaType type, bool *ok);
+
+    void sample();
+    void measureLag();
+    void finish();
+    QJsonObject analyze(QStringList &leaks) const;
+    bool writeReport(const QJsonObject &report) const;
+
+    QPointer<QWebEngineView> m_view;
+    QPointer<TabManager> m_tabManager;
+    QWebChannel *m_channel;
+
+    // Configuration
+    int m_durationSec;
+    int m_sampleIntervalSec;
+    int m_actionIntervalMs;
+    int m_floodSize;
+    int m_maxWindows;
+    double m_warmupFraction;
+    double m_leakThresholdPercent;
+    QStringList m_objects;
+    // Ordered, so the same seed picks the same actions in every run
+    QMap<QString, int> m_weights;
+    quint32 m_seed;
+    QString m_reportPath;
+
+    // Run state
+    QRandomGenerator m_random;
+    QElapsedTimer m_clock;
+    QTimer m_actionTimer;
+    QTimer m_sampleTimer;
+    QTimer m_lagTimer;
+    QElapsedTimer m_lagClock;
+    double m_lagMaxMs;
+    double m_lagTotalMs;
+    int m_lagTicks;
+    QList<QPointer<QWidget>> m_openedWindows;
+    QHash<QString, qint64> m_actionCounts;
+    QVector<Sample> m_samples;
+};
+
+#endif // SOAKTEST_H
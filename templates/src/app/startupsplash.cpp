@@ -0,0 +1,171 @@
+#include "startupsplash.h"
+#include "metrics.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QFile>
+#include <QFileInfo>
+#include <QGraphicsOpacityEffect>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QPropertyAnimation>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <future>
+
+namespace {
+
+const int kFadeMs = 200;
+const int kJpegQuality = 90;
+
+struct LastFrame {
+    QImage image;
+    QUrl url;
+};
+
+std::shared_future<LastFrame> &preloadedFrame()
+{
+    static std::shared_future<LastFrame> frame;
+    return frame;
+}
+
+QString lastFramePath(const QString &suffix)
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation))
+        .filePath(QStringLiteral("last-frame.") + suffix);
+}
+
+LastFrame readLastFrame()
+{
+    QElapsedTimer timer;
+    timer.start();
+    LastFrame frame;
+    QFile sidecar(lastFramePath(QStringLiteral("json")));
+    if (!sidecar.open(QIODevice::ReadOnly)) {
+        return frame;
+    }
+    frame.url = QUrl(QJsonDocument::fromJson(sidecar.readAll()).object().value(QStringLiteral("url")).toString());
+    QImageReader reader(lastFramePath(QStringLiteral("jpg")));
+    if (!reader.read(&frame.image)) {
+        qWarning() << "StartupSplash: could not read the last frame:" << reader.errorString();
+        return frame;
+    }
+    Metrics::global().setGauge(QStringLiteral("startup.lastFrameDecodeMs"), timer.nsecsElapsed() / 1e6);
+    return frame;
+}
+
+} // namespace
+
+void preloadLastFrame()
+{
+    preloadedFrame() = std::async(std::launch::async, readLastFrame).share();
+}
+
+QImage takeLastFrame(const QUrl &url, const QSize &pixelSize)
+{
+    std::shared_future<LastFrame> &preloaded = preloadedFrame();
+    if (!preloaded.valid()) {
+        return QImage();
+    }
+    const LastFrame frame = preloaded.get();
+    preloaded = std::shared_future<LastFrame>();
+    if (frame.image.isNull() || frame.url != url || frame.image.size() != pixelSize) {
+        return QImage(); // Another frontend or window size; it would look wrong
+    }
+    return frame.image;
+}
+
+bool saveLastFrame(const QImage &frame, const QUrl &url)
+{
+    QDir().mkpath(QFileInfo(lastFramePath(QStringLiteral("jpg"))).absolutePath());
+    QSaveFile image(lastFramePath(QStringLiteral("jpg")));
+    if (!image.open(QIODevice::WriteOnly)) {
+        qWarning() << "StartupSplash: could not write" << image.fileName();
+        return false;
+    }
+    QImageWriter writer(&image, "jpg");
+    writer.setQuality(kJpegQuality);
+    if (!writer.write(frame.convertToFormat(QImage::Format_RGB32)) || !image.commit()) {
+        qWarning() << "StartupSplash: could not write" << image.fileName() << writer.errorString();
+        return false;
+    }
+
+    QJsonObject object;
+    object.insert(QStringLiteral("url"), url.toString());
+    object.insert(QStringLiteral("width"), frame.width());
+    object.insert(QStringLiteral("height"), frame.height());
+    object.insert(QStringLiteral("savedAt"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    QSaveFile sidecar(lastFramePath(QStringLiteral("json")));
+    if (!sidecar.open(QIODevice::WriteOnly) || sidecar.write(QJsonDocument(object).toJson()) < 0 || !sidecar.commit()) {
+        qWarning() << "StartupSplash: could not write" << sidecar.fileName();
+        return false;
+    }
+    return true;
+}
+
+void removeLastFrame()
+{
+    QFile::remove(lastFramePath(QStringLiteral("json")));
+    QFile::remove(lastFramePath(QStringLiteral("jpg")));
+}
+
+StartupSplash::StartupSplash(QWidget *covered, const QImage &frame)
+    : QWidget(covered->parentWidget())
+    , m_covered(covered)
+    , m_frame(frame)
+    , m_finishing(false)
+{
+    m_frame.setDevicePixelRatio(covered->devicePixelRatioF());
+    setAttribute(Qt::WA_OpaquePaintEvent, !m_frame.isNull());
+    setGeometry(covered->geometry());
+    covered->installEventFilter(this);
+    raise();
+    show();
+}
+
+void StartupSplash::finish()
+{
+    if (m_finishing) {
+        return;
+    }
+    m_finishing = true;
+    QGraphicsOpacityEffect *effect = new QGraphicsOpacityEffect(this);
+    setGraphicsEffect(effect);
+    QPropertyAnimation *fade = new QPropertyAnimation(effect, "opacity", this);
+    fade->setDuration(kFadeMs);
+    fade->setStartValue(1.0);
+    fade->setEndValue(0.0);
+    fade->setEasingCurve(QEasingCurve::OutCubic);
+    connect(fade, &QPropertyAnimation::finished, this, &QObject::deleteLater);
+    fade->start();
+}
+
+void StartupSplash::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    if (!m_frame.isNull()) {
+        painter.drawImage(QPoint(0, 0), m_frame);
+        return;
+    }
+    painter.fillRect(rect(), palette().window());
+    QFont font = painter.font();
+    font.setPointSizeF(font.pointSizeF() * 1.6);
+    painter.setFont(font);
+    painter.setPen(palette().color(QPalette::PlaceholderText));
+    painter.drawText(rect(), Qt::AlignCenter, QCoreApplication::applicationName());
+}
+
+bool StartupSplash::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_covered && (event->type() == QEvent::Resize || event->type() == QEvent::Move)) {
+        setGeometry(m_covered->geometry());
+        raise();
+    }
+    return QWidget::eventFilter(watched, event);
+}
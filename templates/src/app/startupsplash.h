@@ -0,0 +1,45 @@
+#ifndef STARTUPSPLASH_H
+#define STARTUPSPLASH_H
+
+#include <QImage>
+#include <QPointer>
+#include <QSize>
+#include <QUrl>
+#include <QWidget>
+
+// The main view's last frame from the previous run, kept in the app data
+// directory as last-frame.jpg with a small JSON sidecar. It is only reused
+// for the same frontend URL and the same view size in device pixels.
+//
+// Starts reading and decoding it on a worker thread; call early in main()
+void preloadLastFrame();
+// Waits for the preload; a null image when there is no usable frame
+QImage takeLastFrame(const QUrl &url, const QSize &pixelSize);
+// Writes the frame for the next launch; thread-safe
+bool saveLastFrame(const QImage &frame, const QUrl &url);
+void removeLastFrame();
+
+// Covers a widget (the main view) from the first paint of the window until
+// finish(), then cross-fades to it and deletes itself. Shows the last frame
+// when there is one, otherwise a plain native splash with the app's name.
+class StartupSplash : public QWidget
+{
+    Q_OBJECT
+
+public:
+    StartupSplash(QWidget *covered, const QImage &frame);
+
+public slots:
+    void finish();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    QPointer<QWidget> m_covered;
+    QImage m_frame;
+    bool m_finishing;
+};
+
+#endif // STARTUPSPLASH_H
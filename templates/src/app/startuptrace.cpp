@@ -0,0 +1,36 @@
+#include "startuptrace.h"
+#include "metrics.h"
+#include <QDebug>
+
+StartupTrace::StartupTrace(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.start();
+}
+
+void StartupTrace::mark(const QString &milestone)
+{
+    if (m_marked.contains(milestone)) {
+        return;
+    }
+    m_marked.insert(milestone);
+    const double ms = m_timer.nsecsElapsed() / 1e6;
+    Metrics::global().setGauge(QStringLiteral("startup.") + milestone + QStringLiteral("Ms"), ms);
+    qInfo().noquote() << "Startup:" << milestone << "after" << qRound(ms) << "ms";
+}
+
+void StartupTrace::recordSpan(const QString &name, double durationMs)
+{
+    Metrics::global().setGauge(QStringLiteral("startup.") + name + QStringLiteral("Ms"), durationMs);
+    qInfo().noquote() << "Startup:" << name << "took" << QString::number(durationMs, 'f', 1)
+                      << "ms, done after" << m_timer.elapsed() << "ms";
+}
+
+void StartupTrace::markInteractive()
+{
+    if (isInteractive()) {
+        return;
+    }
+    mark(QStringLiteral("interactive"));
+    emit interactive();
+}
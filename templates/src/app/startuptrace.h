@@ -0,0 +1,42 @@
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QString>
+
+// Times the milestones of a launch, from the start of main() to the page
+// being usable: "windowShown", "loadFinished" and "interactive". Each is
+// logged once and published as the gauge "startup.<milestone>Ms".
+// Spans such as plugin loads are logged the same way with their duration.
+//
+// Published to the page as "startup". The bridge calls markInteractive()
+// once the UI has rendered with the backend connected, or when the app
+// says so after deferInteractive().
+class StartupTrace : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StartupTrace(QObject *parent = nullptr);
+
+    void mark(const QString &milestone);
+    // Work done during or after startup, e.g. loading a plugin: published as
+    // "startup.<name>Ms" with its duration rather than its end time
+    void recordSpan(const QString &name, double durationMs);
+    bool isInteractive() const { return m_marked.contains(QStringLiteral("interactive")); }
+    qint64 elapsedMs() const { return m_timer.elapsed(); }
+
+public slots:
+    void markInteractive();
+
+signals:
+    void interactive();
+
+private:
+    QElapsedTimer m_timer;
+    QSet<QString> m_marked;
+};
+
+#endif // STARTUPTRACE_H
@@ -0,0 +1,373 @@
+#include "tabmanager.h"
+#include "metrics.h"
+#include "mywebpage.h"
+#include "mywebview.h"
+#include "processmemory.h"
+#include <QDebug>
+#include <QJsonDocument>
+#include <QStyle>
+#include <QTabBar>
+#include <QTabWidget>
+#include <QVariant>
+#include <QWebEngineScript>
+#include <QWebEngineScriptCollection>
+
+namespace {
+
+const int kMemoryCheckIntervalMs = 10000;
+const int kMaxTitleLength = 40;
+const char kRestoreScriptName[] = "taqyon-tab-restore";
+
+// Scroll position plus whatever the page chooses to keep
+const char kSaveStateScript[] = R"JS(
+(function () {
+    var state = null;
+    try {
+        if (typeof window.taqyonSaveTabState === 'function') {
+            state = window.taqyonSaveTabState();
+        }
+    } catch (error) {
+        console.warn('taqyonSaveTabState failed:', error);
+    }
+    return { scrollX: window.scrollX, scrollY: window.scrollY, state: state === undefined ? null : state };
+})()
+)JS";
+
+QString tabTitle(const QString &title)
+{
+    const QString simplified = title.simplified();
+    if (simplified.size() <= kMaxTitleLength) {
+        return simplified;
+    }
+    return simplified.left(kMaxTitleLength - 1) + QChar(0x2026);
+}
+
+} // namespace
+
+TabManager::TabManager(QTabWidget *tabs, MyWebView *mainView, QObject *parent)
+    : QObject(parent)
+    , m_tabs(tabs)
+    , m_discards(0)
+    , m_restores(0)
+{
+    m_clock.start();
+    m_tabs->setDocumentMode(true);
+    m_tabs->setTabsClosable(true);
+    m_tabs->setMovable(true);
+    // Looks like the single window it was, until a second page is opened
+    m_tabs->setTabBarAutoHide(true);
+    connect(m_tabs, &QTabWidget::currentChanged, this, &TabManager::onCurrentChanged);
+    connect(m_tabs, &QTabWidget::tabCloseRequested, this, qOverload<int>(&TabManager::closeTab));
+
+    m_memoryTimer.setInterval(kMemoryCheckIntervalMs);
+    connect(&m_memoryTimer, &QTimer::timeout, this, &TabManager::checkMemory);
+
+    addTab(mainView, true);
+    const int index = m_tabs->indexOf(mainView);
+    const QTabBar::ButtonPosition closeSide = static_cast<QTabBar::ButtonPosition>(
+        m_tabs->style()->styleHint(QStyle::SH_TabBar_CloseButtonPosition, nullptr, m_tabs->tabBar()));
+    m_tabs->tabBar()->setTabButton(index, closeSide, nullptr);
+    m_current = mainView;
+}
+
+TabManager::~TabManager()
+{
+    qDeleteAll(m_tabList);
+}
+
+void TabManager::setPolicy(const Policy &policy)
+{
+    m_policy = policy;
+    for (Tab *tab : std::as_const(m_tabList)) {
+        tab->freezeTimer.setInterval(qMax(0, m_policy.freezeAfterSec) * 1000);
+    }
+    if (m_policy.memoryBudgetKb > 0) {
+        m_memoryTimer.start();
+    } else {
+        m_memoryTimer.stop();
+    }
+    enforceBudget();
+}
+
+MyWebView *TabManager::openTab(QWebEnginePage *opener, bool background)
+{
+    MyWebView *view = new MyWebView;
+    MyWebPage *page = new MyWebPage(opener->profile(), view);
+    if (opener->webChannel()) {
+        page->setTrustedChannel(opener->webChannel(), opener->url());
+    }
+    view->setPage(page);
+
+    Tab *tab = addTab(view, false);
+    if (background) {
+        if (m_policy.freezeAfterSec > 0) {
+            tab->freezeTimer.start();
+        }
+    } else {
+        m_tabs->setCurrentWidget(view);
+    }
+    enforceBudget();
+    emit tabOpened(view);
+    return view;
+}
+
+void TabManager::closeTab(MyWebView *view)
+{
+    closeTab(m_tabs->indexOf(view));
+}
+
+TabManager::Tab *TabManager::addTab(MyWebView *view, bool pinned)
+{
+    Tab *tab = new Tab;
+    tab->view = view;
+    tab->pinned = pinned;
+    tab->lastActiveMs = m_clock.elapsed();
+    tab->freezeTimer.setSingleShot(true);
+    tab->freezeTimer.setInterval(qMax(0, m_policy.freezeAfterSec) * 1000);
+    connect(&tab->freezeTimer, &QTimer::timeout, this, [this, tab]() {
+        freeze(tab);
+    });
+    m_tabList.append(tab);
+
+    view->setViewFactory([this, view](QWebEnginePage::WebWindowType type) {
+        return openTab(view->page(), type == QWebEnginePage::WebBrowserBackgroundTab);
+    });
+    QWebEnginePage *page = view->page();
+    connect(page, &QWebEnginePage::titleChanged, this, [this, view](const QString &title) {
+        const int index = m_tabs->indexOf(view);
+        if (index >= 0) {
+            m_tabs->setTabText(index, tabTitle(title));
+            m_tabs->setTabToolTip(index, title);
+        }
+    });
+    connect(page, &QWebEnginePage::windowCloseRequested, this, [this, view]() {
+        closeTab(m_tabs->indexOf(view));
+    });
+    connect(page, &QWebEnginePage::lifecycleStateChanged, this, [this, tab](QWebEnginePage::LifecycleState state) {
+        onLifecycleStateChanged(tab, state);
+    });
+    connect(page, &QWebEnginePage::loadFinished, this, [this, tab]() {
+        onLoadFinished(tab);
+    });
+
+    m_tabs->addTab(view, tabTitle(page->title().isEmpty() ? tr("New Tab") : page->title()));
+    return tab;
+}
+
+TabManager::Tab *TabManager::tabFor(QWidget *widget) const
+{
+    for (Tab *tab : m_tabList) {
+        if (tab->view == widget) {
+            return tab;
+        }
+    }
+    return nullptr;
+}
+
+void TabManager::onCurrentChanged(int index)
+{
+    MyWebView *view = qobject_cast<MyWebView *>(m_tabs->widget(index));
+    if (Tab *previous = tabFor(m_current)) {
+        if (previous->view != view && !previous->pinned && m_policy.freezeAfterSec > 0) {
+            previous->freezeTimer.start();
+        }
+    }
+    m_current = view;
+    Tab *tab = tabFor(view);
+    if (!tab) {
+        return;
+    }
+    tab->freezeTimer.stop();
+    tab->lastActiveMs = m_clock.elapsed();
+    // Visible pages are made active by QtWebEngine itself; a discarded one
+    // reloads at that point
+    if (view->page()->lifecycleState() != QWebEnginePage::LifecycleState::Active) {
+        view->page()->setLifecycleState(QWebEnginePage::LifecycleState::Active);
+    }
+    enforceBudget();
+}
+
+void TabManager::onLifecycleStateChanged(Tab *tab, QWebEnginePage::LifecycleState state)
+{
+    if (state == QWebEnginePage::LifecycleState::Discarded) {
+        tab->discarding = false;
+        ++m_discards;
+        qInfo().noquote() << "Discarded background tab" << tab->view->page()->url().toString();
+    } else if (state == QWebEnginePage::LifecycleState::Active && tab->restoring) {
+        tab->restoreTimer.start();
+    }
+}
+
+void TabManager::onLoadFinished(Tab *tab)
+{
+    if (!tab->restoring || !tab->restoreTimer.isValid()) {
+        return;
+    }
+    tab->restoring = false;
+    ++m_restores;
+    Metrics::global().recordLatency(QStringLiteral("tabs.restoreMs"), tab->restoreTimer.nsecsElapsed() / 1e6);
+    tab->restoreTimer.invalidate();
+
+    QWebEnginePage *page = tab->view->page();
+    const QList<QWebEngineScript> scripts = page->scripts().find(QString::fromLatin1(kRestoreScriptName));
+    for (const QWebEngineScript &script : scripts) {
+        page->scripts().remove(script);
+    }
+    page->runJavaScript(QString("window.scrollTo(%1, %2);")
+                            .arg(tab->savedState.value(QStringLiteral("scrollX")).toDouble())
+                            .arg(tab->savedState.value(QStringLiteral("scrollY")).toDouble()));
+    tab->savedState = QJsonObject();
+}
+
+void TabManager::closeTab(int index)
+{
+    QWidget *widget = m_tabs->widget(index);
+    Tab *tab = tabFor(widget);
+    if (!tab || tab->pinned) {
+        return;
+    }
+    // The page lives until the view is deleted and must not reach the tab
+    tab->view->page()->disconnect(this);
+    m_tabList.removeOne(tab);
+    delete tab;
+    m_tabs->removeTab(index);
+    widget->deleteLater();
+}
+
+void TabManager::freeze(Tab *tab)
+{
+    QWebEnginePage *page = tab->view->page();
+    if (tab->pinned || page->isVisible() || page->recentlyAudible()
+        || page->lifecycleState() != QWebEnginePage::LifecycleState::Active) {
+        return;
+    }
+    // A frozen page runs no script, so its state is saved now for a later discard
+    saveState(tab, [](Tab *tab) {
+        QWebEnginePage *page = tab->view->page();
+        if (!page->isVisible() && page->lifecycleState() == QWebEnginePage::LifecycleState::Active) {
+            page->setLifecycleState(QWebEnginePage::LifecycleState::Frozen);
+        }
+    });
+}
+
+void TabManager::discard(Tab *tab)
+{
+    tab->discarding = true;
+    saveState(tab, [](Tab *tab) {
+        QWebEnginePage *page = tab->view->page();
+        if (page->isVisible() || page->lifecycleState() == QWebEnginePage::LifecycleState::Discarded) {
+            tab->discarding = false;
+            return;
+        }
+        // The page reloads when it is activated again; the script hands the
+        // saved state to the new document before any of its own code runs
+        QWebEngineScript script;
+        script.setName(QString::fromLatin1(kRestoreScriptName));
+        script.setInjectionPoint(QWebEngineScript::DocumentCreation);
+        script.setWorldId(QWebEngineScript::MainWorld);
+        script.setRunsOnSubFrames(false);
+        const QJsonValue state = tab->savedState.value(QStringLiteral("state"));
+        script.setSourceCode(QStringLiteral("window.__TAQYON_TAB_STATE__ = ")
+                             + QString::fromUtf8(QJsonDocument(QJsonObject{{QStringLiteral("state"), state}})
+                                                     .toJson(QJsonDocument::Compact))
+                             + QStringLiteral(".state;"));
+        page->scripts().insert(script);
+        tab->restoring = true;
+        page->setLifecycleState(QWebEnginePage::LifecycleState::Discarded);
+    });
+}
+
+void TabManager::saveState(Tab *tab, const std::function<void(Tab *tab)> &then)
+{
+    QWebEnginePage *page = tab->view->page();
+    if (page->lifecycleState() != QWebEnginePage::LifecycleState::Active) {
+        then(tab); // Saved when it was frozen
+        return;
+    }
+    QPointer<MyWebView> view = tab->view;
+    page->runJavaScript(QString::fromLatin1(kSaveStateScript), [this, view, then](const QVariant &result) {
+        Tab *tab = tabFor(view);
+        if (!tab) {
+            return; // Closed meanwhile
+        }
+        tab->savedState = QJsonObject::fromVariantMap(result.toMap());
+        then(tab);
+    });
+}
+
+void TabManager::enforceBudget()
+{
+    if (m_policy.maxLiveTabs <= 0) {
+        return;
+    }
+    while (liveTabCount() > m_policy.maxLiveTabs) {
+        Tab *tab = leastRecentlyUsedLiveTab();
+        if (!tab) {
+            return;
+        }
+        discard(tab);
+    }
+}
+
+void TabManager::checkMemory()
+{
+    const double usedKb = sampleProcessTreeMemory().totalPssKb();
+    if (usedKb <= m_policy.memoryBudgetKb) {
+        return;
+    }
+    // One per check; the memory of a discarded renderer is returned gradually
+    if (Tab *tab = leastRecentlyUsedLiveTab()) {
+        qInfo().noquote() << "Tabs use" << qRound(usedKb / 1024) << "MB of a" << qRound(m_policy.memoryBudgetKb / 1024)
+                          << "MB budget";
+        discard(tab);
+    }
+}
+
+TabManager::Tab *TabManager::leastRecentlyUsedLiveTab() const
+{
+    Tab *oldest = nullptr;
+    for (Tab *tab : m_tabList) {
+        if (tab->pinned || tab->discarding || tab->view == m_current
+            || tab->view->page()->lifecycleState() == QWebEnginePage::LifecycleState::Discarded
+            || tab->view->page()->recentlyAudible()) {
+            continue;
+        }
+        if (!oldest || tab->lastActiveMs < oldest->lastActiveMs) {
+            oldest = tab;
+        }
+    }
+    return oldest;
+}
+
+int TabManager::liveTabCount() const
+{
+    int count = 0;
+    for (const Tab *tab : m_tabList) {
+        if (!tab->discarding && tab->view->page()->lifecycleState() != QWebEnginePage::LifecycleState::Discarded) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+QJsonObject TabManager::stats() const
+{
+    int frozen = 0;
+    int discarded = 0;
+    for (const Tab *tab : m_tabList) {
+        const QWebEnginePage::LifecycleState state = tab->view->page()->lifecycleState();
+        if (state == QWebEnginePage::LifecycleState::Frozen) {
+            ++frozen;
+        } else if (state == QWebEnginePage::LifecycleState::Discarded) {
+            ++discarded;
+        }
+    }
+    QJsonObject object;
+    object.insert(QStringLiteral("tabs"), m_tabList.size());
+    object.insert(QStringLiteral("live"), liveTabCount());
+    object.insert(QStringLiteral("frozen"), frozen);
+    object.insert(QStringLiteral("discarded"), discarded);
+    object.insert(QStringLiteral("discards"), qint64(m_discards));
+    object.insert(QStringLiteral("restores"), qint64(m_restores));
+    return object;
+}
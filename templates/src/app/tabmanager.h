@@ -0,0 +1,92 @@
+#ifndef TABMANAGER_H
+#define TABMANAGER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+#include <QWebEnginePage>
+#include <functional>
+
+class MyWebView;
+class QTabWidget;
+
+// Hosts the main view and every page it opens as tabs of one QTabWidget,
+// all on the main page's profile. Pages opened from the frontend's origin
+// get the main page's web channel.
+//
+// Background tabs are frozen after a while (no timers or tasks, memory
+// kept) and discarded in least-recently-used order once there are more live
+// tabs than the budget allows or the app's processes use more memory than
+// it does. A discarded tab keeps its URL and history; when it is activated
+// again it reloads, with its scroll position and any state the page saved
+// restored:
+//     window.taqyonSaveTabState = () => ({ filter, selection });
+//     const restored = window.__TAQYON_TAB_STATE__; // on the reloaded page
+// The main tab is never frozen or discarded.
+class TabManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Policy {
+        int freezeAfterSec = 300;   // 0 never freezes
+        int maxLiveTabs = 0;        // Tabs that are not discarded; 0 for no limit
+        double memoryBudgetKb = 0;  // PSS of the app and its children; 0 for no limit
+    };
+
+    TabManager(QTabWidget *tabs, MyWebView *mainView, QObject *parent = nullptr);
+    ~TabManager() override;
+
+    void setPolicy(const Policy &policy);
+    Policy policy() const { return m_policy; }
+
+    MyWebView *openTab(QWebEnginePage *opener, bool background = false);
+    // Closes a tab opened with openTab(); the main tab stays
+    void closeTab(MyWebView *view);
+
+    // {tabs, live, frozen, discarded, discards, restores}
+    QJsonObject stats() const;
+
+signals:
+    void tabOpened(MyWebView *view);
+
+private:
+    struct Tab {
+        MyWebView *view = nullptr;
+        bool pinned = false;
+        qint64 lastActiveMs = 0;
+        QTimer freezeTimer;
+        bool discarding = false;
+        bool restoring = false;
+        QJsonObject savedState;
+        QElapsedTimer restoreTimer;
+    };
+
+    Tab *addTab(MyWebView *view, bool pinned);
+    Tab *tabFor(QWidget *widget) const;
+    void onCurrentChanged(int index);
+    void onLifecycleStateChanged(Tab *tab, QWebEnginePage::LifecycleState state);
+    void onLoadFinished(Tab *tab);
+    void closeTab(int index);
+    void freeze(Tab *tab);
+    void discard(Tab *tab);
+    void saveState(Tab *tab, const std::function<void(Tab *tab)> &then);
+    void enforceBudget();
+    void checkMemory();
+    Tab *leastRecentlyUsedLiveTab() const;
+    int liveTabCount() const;
+
+    QTabWidget *m_tabs;
+    QList<Tab *> m_tabList;
+    QPointer<MyWebView> m_current;
+    Policy m_policy;
+    QElapsedTimer m_clock;
+    QTimer m_memoryTimer;
+    quint64 m_discards;
+    quint64 m_restores;
+};
+
+#endif // TABMANAGER_H
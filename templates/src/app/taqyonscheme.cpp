@@ -0,0 +1,103 @@
+#include "taqyonscheme.h"
+#include "allocationtracker.h"
+#include <QWebEngineUrlScheme>
+#include <QBuffer>
+#include <QDebug>
+
+void registerTaqyonUrlScheme()
+{
+    QWebEngineUrlScheme scheme(TaqyonSchemeHandler::schemeName());
+    scheme.setSyntax(QWebEngineUrlScheme::Syntax::Host);
+    scheme.setDefaultPort(QWebEngineUrlScheme::PortUnspecified);
+    QWebEngineUrlScheme::Flags flags = QWebEngineUrlScheme::SecureScheme
+                                       | QWebEngineUrlScheme::LocalAccessAllowed
+                                       | QWebEngineUrlScheme::CorsEnabled;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    flags |= QWebEngineUrlScheme::FetchApiAllowed;
+#endif
+    scheme.setFlags(flags);
+    QWebEngineUrlScheme::registerScheme(scheme);
+}
+
+TaqyonSchemeHandler::TaqyonSchemeHandler(QObject *parent)
+    : QWebEngineUrlSchemeHandler(parent)
+{
+}
+
+QByteArray TaqyonSchemeHandler::schemeName()
+{
+    return QByteArrayLiteral("taqyon");
+}
+
+void TaqyonSchemeHandler::addHost(const QString &host, HostHandler handler)
+{
+    m_hosts.insert(host.toLower(), std::move(handler));
+}
+
+bool TaqyonSchemeHandler::hasHost(const QString &host) const
+{
+    return m_hosts.contains(host.toLower());
+}
+
+void TaqyonSchemeHandler::removeHost(const QString &host)
+{
+    m_hosts.remove(host.toLower());
+}
+
+void TaqyonSchemeHandler::requestStarted(QWebEngineUrlRequestJob *job)
+{
+    const QString host = job->requestUrl().host().toLower();
+    AllocationScope allocationScope([&host]() { return "scheme " + host.toUtf8(); });
+    auto it = m_hosts.constFind(host);
+    if (it == m_hosts.constEnd()) {
+        qWarning() << "TaqyonSchemeHandler: no handler for host" << host << "in" << job->requestUrl().toString();
+        job->fail(QWebEngineUrlRequestJob::UrlNotFound);
+        return;
+    }
+    it.value()(job);
+}
+
+QStringList TaqyonSchemeHandler::originsOf(const QUrl &frontendUrl)
+{
+    if (frontendUrl.isLocalFile()) {
+        return {QStringLiteral("file:"), QStringLiteral("file://"), QStringLiteral("null")};
+    }
+    return {frontendUrl.adjusted(QUrl::RemovePath | QUrl::RemoveQuery | QUrl::RemoveFragment
+                                 | QUrl::RemoveUserInfo).toString()};
+}
+
+bool TaqyonSchemeHandler::isAllowedInitiator(QWebEngineUrlRequestJob *job, const QStringList &origins)
+{
+    return origins.contains(job->initiator().toString());
+}
+
+QMultiMap<QByteArray, QByteArray> TaqyonSchemeHandler::corsHeaders(QWebEngineUrlRequestJob *job)
+{
+    QMultiMap<QByteArray, QByteArray> headers;
+    headers.insert("Access-Control-Allow-Origin", job->initiator().toEncoded());
+    headers.insert("Vary", "Origin");
+    return headers;
+}
+
+void TaqyonSchemeHandler::replyWithData(QWebEngineUrlRequestJob *job, const QByteArray &contentType,
+                                        const QByteArray &data,
+                                        const QMultiMap<QByteArray, QByteArray> &headers)
+{
+    QBuffer *buffer = new QBuffer;
+    buffer->setData(data);
+    buffer->open(QIODevice::ReadOnly);
+    replyWithDevice(job, contentType, buffer, headers);
+}
+
+void TaqyonSchemeHandler::replyWithDevice(QWebEngineUrlRequestJob *job, const QByteArray &contentType,
+                                          QIODevice *device,
+                                          const QMultiMap<QByteArray, QByteArray> &headers)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    job->setAdditionalResponseHeaders(headers);
+#else
+    Q_UNUSED(headers);
+#endif
+    device->setParent(job);
+    job->reply(contentType, device);
+}
@@ -0,0 +1,65 @@
+#ifndef TAQYONSCHEME_H
+#define TAQYONSCHEME_H
+
+#include <QWebEngineUrlSchemeHandler>
+#include <QWebEngineUrlRequestJob>
+#include <QHash>
+#include <QMultiMap>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <functional>
+
+class QIODevice;
+
+// The "taqyon" URL scheme is served entirely from C++. Each host under the
+// scheme (taqyon://<host>/...) is dispatched to its own handler, so features
+// can add endpoints without installing further scheme handlers on the profile.
+//
+// registerTaqyonUrlScheme() must be called before QApplication is constructed.
+void registerTaqyonUrlScheme();
+
+class TaqyonSchemeHandler : public QWebEngineUrlSchemeHandler
+{
+    Q_OBJECT
+
+public:
+    using HostHandler = std::function<void(QWebEngineUrlRequestJob *job)>;
+
+    explicit TaqyonSchemeHandler(QObject *parent = nullptr);
+
+    static QByteArray schemeName();
+
+    void addHost(const QString &host, HostHandler handler);
+    bool hasHost(const QString &host) const;
+    void removeHost(const QString &host);
+
+    void requestStarted(QWebEngineUrlRequestJob *job) override;
+
+    // Replies to job with an in-memory body. The buffer is owned by the job.
+    // Extra headers require Qt 6.6; older versions silently drop them. No
+    // CORS headers are added; hosts that serve other origins pass their own.
+    static void replyWithData(QWebEngineUrlRequestJob *job, const QByteArray &contentType,
+                              const QByteArray &data,
+                              const QMultiMap<QByteArray, QByteArray> &headers = {});
+    // Same for a device, which is reparented to the job
+    static void replyWithDevice(QWebEngineUrlRequestJob *job, const QByteArray &contentType,
+                                QIODevice *device,
+                                const QMultiMap<QByteArray, QByteArray> &headers = {});
+
+    // Origins whose pages may call the C++ endpoints (bridge, api) when the
+    // frontend is loaded from frontendUrl: its own origin, or for a file://
+    // frontend "file:" and the opaque "null" Chromium may report for it
+    static QStringList originsOf(const QUrl &frontendUrl);
+    // Whether the page or worker behind job is on one of origins. An empty
+    // list allows nothing.
+    static bool isAllowedInitiator(QWebEngineUrlRequestJob *job, const QStringList &origins);
+    // Access-Control-Allow-Origin for the initiator of an allowed request
+    static QMultiMap<QByteArray, QByteArray> corsHeaders(QWebEngineUrlRequestJob *job);
+
+private:
+    QHash<QString, HostHandler> m_hosts;
+};
+
+#endif // TAQYONSCHEME_H
@@ -0,0 +1,80 @@
+#include "transportconditions.h"
+#include <QWebEnginePage>
+#include <QWebEngineScript>
+#include <QWebEngineScriptCollection>
+#include <QJsonDocument>
+#include <QStringList>
+
+namespace {
+
+const char kScriptName[] = "taqyon-transport-conditions";
+
+} // namespace
+
+bool TransportConditions::isActive() const
+{
+    return latencyMs > 0 || jitterMs > 0 || reorderProbability > 0 || bandwidthKBps > 0;
+}
+
+QString TransportConditions::toString() const
+{
+    return QString("latency %1 ms, jitter %2 ms, reorder %3, bandwidth %4")
+        .arg(latencyMs).arg(jitterMs).arg(reorderProbability)
+        .arg(bandwidthKBps > 0 ? QString("%1 KB/s").arg(bandwidthKBps) : QStringLiteral("unlimited"));
+}
+
+QJsonObject TransportConditions::toJson() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("latencyMs"), latencyMs);
+    object.insert(QStringLiteral("jitterMs"), jitterMs);
+    object.insert(QStringLiteral("reorderProbability"), reorderProbability);
+    object.insert(QStringLiteral("bandwidthKBps"), bandwidthKBps);
+    return object;
+}
+
+bool TransportConditions::parse(const QString &spec, TransportConditions &conditions, QString &error)
+{
+    conditions = TransportConditions();
+    const QStringList entries = spec.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &entry : entries) {
+        const QString key = entry.section(QLatin1Char('='), 0, 0).trimmed();
+        bool ok = false;
+        const double value = entry.section(QLatin1Char('='), 1).trimmed().toDouble(&ok);
+        if (!ok || value < 0) {
+            error = QString("invalid value in \"%1\"").arg(entry);
+            return false;
+        }
+        if (key == QLatin1String("latency")) {
+            conditions.latencyMs = value;
+        } else if (key == QLatin1String("jitter")) {
+            conditions.jitterMs = value;
+        } else if (key == QLatin1String("reorder")) {
+            if (value > 1) {
+                error = QStringLiteral("reorder is a probability between 0 and 1");
+                return false;
+            }
+            conditions.reorderProbability = value;
+        } else if (key == QLatin1String("bandwidth")) {
+            conditions.bandwidthKBps = value;
+        } else {
+            error = QString("unknown setting \"%1\"").arg(key);
+            return false;
+        }
+    }
+    return true;
+}
+
+void injectTransportConditions(QWebEnginePage *page, const TransportConditions &conditions)
+{
+    const QByteArray json = QJsonDocument(conditions.toJson()).toJson(QJsonDocument::Compact);
+    QWebEngineScript script;
+    script.setName(QString::fromLatin1(kScriptName));
+    script.setInjectionPoint(QWebEngineScript::DocumentCreation);
+    script.setWorldId(QWebEngineScript::MainWorld);
+    script.setRunsOnSubFrames(false);
+    script.setSourceCode(QStringLiteral(
+        "window.__TAQYON_TRANSPORT__ = Object.assign(window.__TAQYON_TRANSPORT__ || {}, { conditions: %1 });")
+        .arg(QString::fromUtf8(json)));
+    page->scripts().insert(script);
+}
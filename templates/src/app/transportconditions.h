@@ -0,0 +1,37 @@
+#ifndef TRANSPORTCONDITIONS_H
+#define TRANSPORTCONDITIONS_H
+
+#include <QJsonObject>
+#include <QString>
+
+class QWebEnginePage;
+
+// Simulated network conditions for the web channel, to test frontends
+// against a slow or loaded machine. They are applied in the page by the
+// bridge module, which delays, reorders and throttles messages in both
+// directions; C++ only parses the command line and injects the settings as
+// window.__TAQYON_TRANSPORT__.conditions.
+//
+// Spec format: "latency=120,jitter=40,reorder=0.1,bandwidth=256"
+//   latency    one-way delay in ms
+//   jitter     random extra delay of up to +/- jitter ms
+//   reorder    probability that a method call or reply is held back so later
+//              calls or replies overtake it; signals and property updates
+//              always keep their order
+//   bandwidth  cap in kilobytes per second, per direction
+struct TransportConditions {
+    double latencyMs = 0;
+    double jitterMs = 0;
+    double reorderProbability = 0;
+    double bandwidthKBps = 0;
+
+    bool isActive() const;
+    QString toString() const;
+    QJsonObject toJson() const;
+
+    static bool parse(const QString &spec, TransportConditions &conditions, QString &error);
+};
+
+void injectTransportConditions(QWebEnginePage *page, const TransportConditions &conditions);
+
+#endif // TRANSPORTCONDITIONS_H
@@ -0,0 +1,195 @@
+#include "websocketbridge.h"
+#include <QDebug>
+#include <QFile>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+#include <QWebChannel>
+#include <QWebSocket>
+#include <QWebSocketCorsAuthenticator>
+
+namespace {
+
+const qint64 kMaxHeaderBytes = 16 * 1024;
+const int kRequestTimeoutMs = 5000;
+const char *kRoutedProperty = "webSocketBridgeRouted";
+
+bool isLoopbackHost(const QString &host)
+{
+    return host == QLatin1String("localhost") || QHostAddress(host).isLoopback();
+}
+
+} // namespace
+
+WebSocketTransport::WebSocketTransport(QWebSocket *socket, WebSocketTraffic *traffic, QObject *parent)
+    : QWebChannelAbstractTransport(parent)
+    , m_socket(socket)
+    , m_traffic(traffic)
+{
+    m_socket->setParent(this);
+    connect(m_socket, &QWebSocket::textMessageReceived, this, &WebSocketTransport::onTextMessage);
+    connect(m_socket, &QWebSocket::disconnected, this, &WebSocketTransport::disconnected);
+}
+
+void WebSocketTransport::sendMessage(const QJsonObject &message)
+{
+    const QByteArray json = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    m_socket->sendTextMessage(QString::fromUtf8(json));
+    m_traffic->messagesOut++;
+    m_traffic->bytesOut += json.size();
+}
+
+void WebSocketTransport::onTextMessage(const QString &text)
+{
+    const QByteArray json = text.toUtf8();
+    m_traffic->messagesIn++;
+    m_traffic->bytesIn += json.size();
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        qWarning() << "WebSocketBridge: ignoring a message that is not a JSON object:" << error.errorString();
+        return;
+    }
+    emit messageReceived(document.object(), this);
+}
+
+WebSocketBridge::WebSocketBridge(QWebChannel *channel, QObject *parent)
+    : QObject(parent)
+    , m_channel(channel)
+    , m_webSocketServer(QStringLiteral("taqyon-bridge"), QWebSocketServer::NonSecureMode)
+    , m_clients(0)
+    , m_rejected(0)
+{
+    connect(&m_tcpServer, &QTcpServer::newConnection, this, &WebSocketBridge::onTcpConnection);
+    connect(&m_webSocketServer, &QWebSocketServer::newConnection, this, &WebSocketBridge::onWebSocketConnection);
+    connect(&m_webSocketServer, &QWebSocketServer::originAuthenticationRequired,
+            this, &WebSocketBridge::onOriginAuthentication);
+}
+
+bool WebSocketBridge::listen(quint16 port)
+{
+    if (!m_tcpServer.listen(QHostAddress::LocalHost, port)) {
+        qWarning() << "WebSocketBridge: could not listen on 127.0.0.1:" << port << m_tcpServer.errorString();
+        return false;
+    }
+    qInfo().noquote() << QString("WebSocketBridge: serving the channel on ws://127.0.0.1:%1").arg(port);
+    return true;
+}
+
+QJsonObject WebSocketBridge::stats() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("port"), port());
+    object.insert(QStringLiteral("clients"), m_clients);
+    object.insert(QStringLiteral("rejected"), m_rejected);
+    object.insert(QStringLiteral("messagesIn"), m_traffic.messagesIn);
+    object.insert(QStringLiteral("messagesOut"), m_traffic.messagesOut);
+    object.insert(QStringLiteral("bytesIn"), m_traffic.bytesIn);
+    object.insert(QStringLiteral("bytesOut"), m_traffic.bytesOut);
+    return object;
+}
+
+void WebSocketBridge::onTcpConnection()
+{
+    while (QTcpSocket *socket = m_tcpServer.nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { routeRequest(socket); });
+        // Sockets that never send a complete request, or hang up first
+        QTimer::singleShot(kRequestTimeoutMs, socket, [socket]() {
+            if (!socket->property(kRoutedProperty).toBool()) {
+                socket->abort();
+                socket->deleteLater();
+            }
+        });
+    }
+}
+
+// Peeks at the request headers without consuming them, so a WebSocket
+// upgrade can be handed to QWebSocketServer with the handshake intact
+void WebSocketBridge::routeRequest(QTcpSocket *socket)
+{
+    const QByteArray head = socket->peek(kMaxHeaderBytes);
+    const int end = head.indexOf("\r\n\r\n");
+    if (end < 0) {
+        if (head.size() >= kMaxHeaderBytes) {
+            socket->setProperty(kRoutedProperty, true);
+            socket->abort();
+            socket->deleteLater();
+        }
+        return; // Wait for the rest of the headers
+    }
+    socket->setProperty(kRoutedProperty, true);
+    disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+
+    const QByteArray requestLine = head.left(head.indexOf("\r\n"));
+    if (head.left(end).toLower().contains("\r\nupgrade: websocket")) {
+        m_webSocketServer.handleConnection(socket);
+        return;
+    }
+    serveClientLibrary(socket, requestLine);
+}
+
+void WebSocketBridge::serveClientLibrary(QTcpSocket *socket, const QByteArray &requestLine)
+{
+    const QList<QByteArray> parts = requestLine.split(' ');
+    const QByteArray path = parts.size() >= 2 ? parts.at(1).split('?').first() : QByteArray();
+    QByteArray status = "404 Not Found";
+    QByteArray body;
+    if (parts.value(0) == "GET" && path == "/qwebchannel.js") {
+        QFile library(QStringLiteral(":/qtwebchannel/qwebchannel.js"));
+        if (library.open(QIODevice::ReadOnly)) {
+            status = "200 OK";
+            body = library.readAll();
+        } else {
+            qWarning() << "WebSocketBridge: qwebchannel.js is not in the resources";
+            status = "500 Internal Server Error";
+        }
+    }
+    connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    socket->readAll();
+    socket->write("HTTP/1.1 " + status + "\r\n"
+                  "Content-Type: application/javascript; charset=utf-8\r\n"
+                  "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                  "Cache-Control: no-cache\r\n"
+                  "Connection: close\r\n\r\n" + body);
+    socket->disconnectFromHost();
+}
+
+void WebSocketBridge::onOriginAuthentication(QWebSocketCorsAuthenticator *authenticator)
+{
+    const bool allowed = isAllowedOrigin(authenticator->origin());
+    if (!allowed) {
+        m_rejected++;
+        qWarning() << "WebSocketBridge: rejected a connection from origin" << authenticator->origin();
+    }
+    authenticator->setAllowed(allowed);
+}
+
+bool WebSocketBridge::isAllowedOrigin(const QString &origin) const
+{
+    if (m_allowedOrigins.contains(origin)) {
+        return true;
+    }
+    const QUrl url(origin);
+    return (url.scheme() == QLatin1String("http") || url.scheme() == QLatin1String("https"))
+           && isLoopbackHost(url.host());
+}
+
+void WebSocketBridge::onWebSocketConnection()
+{
+    while (QWebSocket *socket = m_webSocketServer.nextPendingConnection()) {
+        const QString origin = socket->origin();
+        WebSocketTransport *transport = new WebSocketTransport(socket, &m_traffic, this);
+        connect(transport, &WebSocketTransport::disconnected, this, [this, transport, origin]() {
+            m_channel->disconnectFrom(transport);
+            transport->deleteLater();
+            m_clients--;
+            qInfo() << "WebSocketBridge: client from" << origin << "disconnected";
+        });
+        m_channel->connectTo(transport);
+        m_clients++;
+        qInfo().noquote() << QString("WebSocketBridge: client connected from %1 (%2 connected)").arg(origin).arg(m_clients);
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef WEBSOCKETBRIDGE_H
+#define WEBSOCKETBRIDGE_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTcpServer>
+#include <QWebChannelAbstractTransport>
+#include <QWebSocketServer>
+
+class QTcpSocket;
+class QWebChannel;
+class QWebSocket;
+class QWebSocketCorsAuthenticator;
+
+struct WebSocketTraffic {
+    qint64 messagesIn = 0;
+    qint64 messagesOut = 0;
+    qint64 bytesIn = 0;
+    qint64 bytesOut = 0;
+};
+
+// One browser connection as a transport of the app's QWebChannel. Messages
+// are sent as compact JSON text frames, as qwebchannel.js expects.
+class WebSocketTransport : public QWebChannelAbstractTransport
+{
+    Q_OBJECT
+
+public:
+    // Takes ownership of the socket
+    WebSocketTransport(QWebSocket *socket, WebSocketTraffic *traffic, QObject *parent = nullptr);
+
+    void sendMessage(const QJsonObject &message) override;
+
+signals:
+    void disconnected();
+
+private:
+    void onTextMessage(const QString &text);
+
+    QWebSocket *m_socket;
+    WebSocketTraffic *m_traffic;
+};
+
+// Serves the app's QWebChannel on ws://127.0.0.1:<port> (--bridge-websocket),
+// so the frontend opened from the dev server in Chrome or Firefox talks to
+// the real backend and can be profiled with that browser's own tools.
+//
+// Each connection becomes another transport of the same channel: the same
+// objects, and property changes and signals reach the app's page and every
+// browser alike. The port also answers GET /qwebchannel.js with Qt's client
+// library, which a browser outside Qt has no other way to load.
+//
+// Only loopback is listened on, and only pages from loopback origins or the
+// allowed origins (the dev server) may connect, so other sites open in the
+// browser cannot reach the backend.
+class WebSocketBridge : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WebSocketBridge(QWebChannel *channel, QObject *parent = nullptr);
+
+    bool listen(quint16 port);
+    quint16 port() const { return m_tcpServer.serverPort(); }
+
+    // Origins ("http://192.168.1.5:5173") accepted besides loopback ones
+    void setAllowedOrigins(const QStringList &origins) { m_allowedOrigins = origins; }
+
+    QJsonObject stats() const;
+
+private:
+    void onTcpConnection();
+    void routeRequest(QTcpSocket *socket);
+    void serveClientLibrary(QTcpSocket *socket, const QByteArray &requestLine);
+    void onWebSocketConnection();
+    void onOriginAuthentication(QWebSocketCorsAuthenticator *authenticator);
+    bool isAllowedOrigin(const QString &origin) const;
+
+    QWebChannel *m_channel;
+    QTcpServer m_tcpServer;
+    QWebSocketServer m_webSocketServer;
+    QStringList m_allowedOrigins;
+    WebSocketTraffic m_traffic;
+    int m_clients;
+    int m_rejected;
+};
+
+#endif // WEBSOCKETBRIDGE_H
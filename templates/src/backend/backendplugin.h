@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QObject>
+#include <QtPlugin>
+
+// Interface of backend services shipped as plugins (shared libraries in the
+// plugins directory next to the executable). A plugin declares it with
+//
+//     Q_PLUGIN_METADATA(IID BackendPluginInterface_iid FILE "myplugin.json")
+//     Q_INTERFACES(BackendPluginInterface)
+//
+// The JSON file names the service: {"name": "reports", "description": "..."}.
+// The app lists plugins from this metadata without loading them, and loads
+// a plugin the first time its object is asked for.
+class BackendPluginInterface {
+public:
+    virtual ~BackendPluginInterface() = default;
+
+    // The object published under the plugin's name. Called once; the object
+    // is owned by `parent` and lives until the app exits.
+    virtual QObject *createBackendObject(QObject *parent) = 0;
+};
+
+#define BackendPluginInterface_iid "io.taqyon.BackendPluginInterface/1.0"
+Q_DECLARE_INTERFACE(BackendPluginInterface, BackendPluginInterface_iid)
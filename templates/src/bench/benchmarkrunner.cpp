@@ -0,0 +1,249 @@
+#include "benchmarkrunner.h"
+#include "../app/metrics.h"
+#include "../app/allocationtracker.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QDebug>
+#include <utility>
+
+namespace {
+
+QString formatCount(const QJsonObject &values, const QString &key)
+{
+    if (!values.contains(key)) {
+        return QStringLiteral("-");
+    }
+    return QString::number(values.value(key).toDouble(), 'f', 1);
+}
+
+} // namespace
+
+BenchmarkRunner::BenchmarkRunner()
+    : m_iterationScale(1.0)
+{
+}
+
+BenchmarkRunner::~BenchmarkRunner() = default;
+
+void BenchmarkRunner::add(const QString &name, const QString &description, Benchmark benchmark)
+{
+    m_benchmarks.append({name, description, std::move(benchmark)});
+}
+
+QStringList BenchmarkRunner::names() const
+{
+    QStringList result;
+    for (const Entry &entry : m_benchmarks) {
+        result << entry.name;
+    }
+    return result;
+}
+
+void BenchmarkRunner::setPerfCountersEnabled(bool enabled)
+{
+    if (!enabled) {
+        m_counters.reset();
+        return;
+    }
+    m_counters.reset(new PerfCounters);
+    if (m_counters->isAvailable()) {
+        qInfo().noquote() << "Benchmark: hardware counters:" << m_counters->availableCounters().join(QStringLiteral(", "));
+    } else {
+        qWarning().noquote() << "Benchmark: hardware counters unavailable," << m_counters->unavailableReason()
+                             << "- reporting wall-clock time only";
+    }
+}
+
+void BenchmarkRunner::measure(const QString &operation, int iterations, const std::function<void()> &op)
+{
+    iterations = qMax(1, qRound(iterations * m_iterationScale));
+    const int warmup = qMax(1, iterations / 10);
+    for (int i = 0; i < warmup; ++i) {
+        op();
+    }
+
+    // Counters and the clock bracket the whole batch; reading them around
+    // every call would cost more than the cheaper operations themselves
+    const bool counting = m_counters && m_counters->isAvailable();
+    const AllocationTracker::Counters allocationsBefore = AllocationTracker::currentThread();
+    QElapsedTimer timer;
+    if (counting) {
+        m_counters->start();
+    }
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        op();
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    PerfCounters::Reading reading;
+    if (counting) {
+        reading = m_counters->stop();
+    }
+    const AllocationTracker::Counters allocationsAfter = AllocationTracker::currentThread();
+
+    Result &result = resultFor(operation);
+    const double nsPerOp = double(elapsedNs) / iterations;
+    result.values.insert(QStringLiteral("iterations"), iterations);
+    result.values.insert(QStringLiteral("nsPerOp"), nsPerOp);
+    result.values.insert(QStringLiteral("opsPerSecond"), nsPerOp > 0 ? 1e9 / nsPerOp : 0);
+    const QJsonObject counters = reading.toJson(iterations);
+    for (auto it = counters.begin(); it != counters.end(); ++it) {
+        result.values.insert(it.key(), it.value());
+    }
+    if (AllocationTracker::isEnabled()) {
+        // Only the benchmark thread; work handed to other threads is not included
+        result.values.insert(QStringLiteral("allocationsPerOp"),
+                             double(allocationsAfter.allocations - allocationsBefore.allocations) / iterations);
+        result.values.insert(QStringLiteral("allocatedBytesPerOp"),
+                             double(allocationsAfter.bytes - allocationsBefore.bytes) / iterations);
+    }
+    Metrics::global().setGauge(QString("bench.%1.%2.nsPerOp").arg(m_current, operation), nsPerOp);
+}
+
+void BenchmarkRunner::record(const QString &operation, const QString &key, double value)
+{
+    resultFor(operation).values.insert(key, value);
+    Metrics::global().setGauge(QString("bench.%1.%2.%3").arg(m_current, operation, key), value);
+}
+
+void BenchmarkRunner::fail(const QString &message)
+{
+    qWarning().noquote() << "Benchmark" << m_current << "failed:" << message;
+    m_failures << QString("%1: %2").arg(m_current, message);
+}
+
+bool BenchmarkRunner::waitFor(const std::function<bool()> &condition, int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.elapsed() >= timeoutMs) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents | QEventLoop::WaitForMoreEvents, 10);
+    }
+    return true;
+}
+
+int BenchmarkRunner::run(const QString &selection)
+{
+    QStringList selected = selection.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (QString &name : selected) {
+        name = name.trimmed();
+    }
+    const bool all = selected.contains(QStringLiteral("all"));
+    for (const QString &name : selected) {
+        if (name != QLatin1String("all") && !names().contains(name)) {
+            qCritical().noquote() << "Unknown benchmark" << name << "- available:" << names().join(QStringLiteral(", "));
+            return 1;
+        }
+    }
+
+    for (const Entry &entry : m_benchmarks) {
+        if (!all && !selected.contains(entry.name)) {
+            continue;
+        }
+        m_current = entry.name;
+        qInfo().noquote() << "Benchmark:" << entry.name << "-" << entry.description;
+        entry.benchmark(*this);
+    }
+    m_current.clear();
+
+    logResults();
+    if (!m_reportPath.isEmpty() && !writeReport()) {
+        return 1;
+    }
+    return m_failures.isEmpty() ? 0 : 2;
+}
+
+BenchmarkRunner::Result &BenchmarkRunner::resultFor(const QString &operation)
+{
+    for (Result &result : m_results) {
+        if (result.benchmark == m_current && result.operation == operation) {
+            return result;
+        }
+    }
+    m_results.append({m_current, operation, QJsonObject()});
+    return m_results.last();
+}
+
+void BenchmarkRunner::logResults() const
+{
+    qInfo().noquote() << QString("%1 %2 %3 %4 %5 %6 %7")
+        .arg(QStringLiteral("operation"), -40)
+        .arg(QStringLiteral("ns/op"), 12)
+        .arg(QStringLiteral("cycles"), 12)
+        .arg(QStringLiteral("IPC"), 6)
+        .arg(QStringLiteral("cache-miss"), 11)
+        .arg(QStringLiteral("br-miss"), 9)
+        .arg(QStringLiteral("ctx-sw"), 8);
+    for (const Result &result : m_results) {
+        const QJsonObject &values = result.values;
+        const QString name = result.benchmark + QLatin1Char('/') + result.operation;
+        if (!values.contains(QStringLiteral("nsPerOp"))) {
+            for (auto it = values.begin(); it != values.end(); ++it) {
+                qInfo().noquote() << QString("%1 %2 = %3").arg(name, -40).arg(it.key()).arg(it.value().toDouble());
+            }
+            continue;
+        }
+        qInfo().noquote() << QString("%1 %2 %3 %4 %5 %6 %7")
+            .arg(name, -40)
+            .arg(QString::number(values.value(QStringLiteral("nsPerOp")).toDouble(), 'f', 1), 12)
+            .arg(formatCount(values, QStringLiteral("cyclesPerOp")), 12)
+            .arg(values.contains(QStringLiteral("ipc"))
+                     ? QString::number(values.value(QStringLiteral("ipc")).toDouble(), 'f', 2)
+                     : QStringLiteral("-"), 6)
+            .arg(formatCount(values, QStringLiteral("cacheMissesPerOp")), 11)
+            .arg(formatCount(values, QStringLiteral("branchMissesPerOp")), 9)
+            .arg(formatCount(values, QStringLiteral("contextSwitchesPerOp")), 8);
+    }
+}
+
+bool BenchmarkRunner::writeReport() const
+{
+    QJsonArray results;
+    for (const Result &result : m_results) {
+        QJsonObject object = result.values;
+        object.insert(QStringLiteral("benchmark"), result.benchmark);
+        object.insert(QStringLiteral("operation"), result.operation);
+        results.append(object);
+    }
+    QJsonObject report;
+    report.insert(QStringLiteral("finishedAt"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    report.insert(QStringLiteral("cpu"), QSysInfo::currentCpuArchitecture());
+    report.insert(QStringLiteral("kernel"), QSysInfo::kernelVersion());
+    report.insert(QStringLiteral("qt"), QString::fromLatin1(qVersion()));
+    for (auto it = m_reportFields.constBegin(); it != m_reportFields.constEnd(); ++it) {
+        report.insert(it.key(), it.value());
+    }
+    if (m_counters) {
+        report.insert(QStringLiteral("perfCounters"), QJsonArray::fromStringList(m_counters->availableCounters()));
+        if (!m_counters->isAvailable()) {
+            report.insert(QStringLiteral("perfCountersUnavailable"), m_counters->unavailableReason());
+        }
+    }
+    if (AllocationTracker::isEnabled()) {
+        report.insert(QStringLiteral("allocations"), AllocationTracker::snapshot());
+    }
+    report.insert(QStringLiteral("results"), results);
+    report.insert(QStringLiteral("failures"), QJsonArray::fromStringList(m_failures));
+
+    QSaveFile file(m_reportPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Benchmark: could not write report" << m_reportPath;
+        return false;
+    }
+    file.write(QJsonDocument(report).toJson());
+    if (!file.commit()) {
+        qWarning() << "Benchmark: could not write report" << m_reportPath;
+        return false;
+    }
+    qInfo() << "Benchmark report written to" << m_reportPath;
+    return true;
+}
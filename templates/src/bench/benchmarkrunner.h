@@ -0,0 +1,93 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <functional>
+#include <memory>
+#include "perfcounters.h"
+
+class QWebEngineProfile;
+class TaqyonSchemeHandler;
+
+// What a benchmark may use from the running app
+struct BenchmarkEnvironment {
+    QWebEngineProfile *profile = nullptr;
+    TaqyonSchemeHandler *schemeHandler = nullptr;
+    QUrl frontendUrl;
+    QString frontendRoot; // Directory of the built frontend, empty for dev servers
+    int windowCount = 10; // Most windows the window benchmarks open at once
+};
+
+// Runs the in-app benchmark suite (--benchmark). Benchmarks are registered
+// by name and call measure() for every operation they time; each result is
+// the mean over all iterations, with hardware counters per operation when
+// --perf-counters is given and the kernel allows it. Results are logged as a
+// table, published as "bench.*" gauges and optionally written as JSON.
+//
+// Benchmarks run on the GUI thread and may spin the event loop with waitFor()
+// when an operation completes asynchronously.
+class BenchmarkRunner
+{
+public:
+    using Benchmark = std::function<void(BenchmarkRunner &runner)>;
+
+    BenchmarkRunner();
+    ~BenchmarkRunner();
+
+    void add(const QString &name, const QString &description, Benchmark benchmark);
+    QStringList names() const;
+
+    void setPerfCountersEnabled(bool enabled);
+    void setIterationScale(double scale) { m_iterationScale = scale; }
+    void setReportPath(const QString &path) { m_reportPath = path; }
+    // Adds a top-level field to the report, e.g. the launch profile in use
+    void setReportField(const QString &key, const QJsonValue &value) { m_reportFields.insert(key, value); }
+
+    // Times `iterations` calls of `operation` after a short warmup. The
+    // iteration count is multiplied by the --benchmark-scale factor.
+    void measure(const QString &operation, int iterations, const std::function<void()> &op);
+    // Records a value that is not a timing, e.g. bytes of memory per window
+    void record(const QString &operation, const QString &key, double value);
+    void fail(const QString &message);
+
+    // Processes events until `condition` holds; false on timeout
+    static bool waitFor(const std::function<bool()> &condition, int timeoutMs);
+
+    // Runs the benchmarks in a comma-separated selection ("all" for every
+    // one), logs the results and writes the report. Returns the exit code.
+    int run(const QString &selection);
+
+private:
+    struct Entry {
+        QString name;
+        QString description;
+        Benchmark benchmark;
+    };
+
+    struct Result {
+        QString benchmark;
+        QString operation;
+        QJsonObject values;
+    };
+
+    Result &resultFor(const QString &operation);
+    void logResults() const;
+    bool writeReport() const;
+
+    QList<Entry> m_benchmarks;
+    std::unique_ptr<PerfCounters> m_counters;
+    double m_iterationScale;
+    QString m_reportPath;
+    QJsonObject m_reportFields;
+
+    QString m_current;
+    QStringList m_failures;
+    QList<Result> m_results;
+};
+
+#endif // BENCHMARKRUNNER_H
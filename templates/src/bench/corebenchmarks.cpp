@@ -0,0 +1,175 @@
+#include "corebenchmarks.h"
+#include "benchmarkrunner.h"
+#include "../app/allocationtracker.h"
+#include "../app/assetcache.h"
+#include "../backend/backendobject.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QWebChannel>
+#include <QWebChannelAbstractTransport>
+
+namespace {
+
+const int kMaxAssetFiles = 200;
+
+// Hands messages straight to the channel and keeps the last reply. Both
+// directions go through JSON text, as they do between the page and
+// QtWebEngine, so the numbers include serialization.
+class LoopbackTransport : public QWebChannelAbstractTransport
+{
+public:
+    void sendMessage(const QJsonObject &message) override
+    {
+        const QByteArray text = QJsonDocument(message).toJson(QJsonDocument::Compact);
+        const QJsonObject reply = QJsonDocument::fromJson(text).object();
+        if (reply.value(QStringLiteral("type")).toInt() == 10) {
+            lastResponse = reply;
+        }
+    }
+
+    void deliver(const QJsonObject &message)
+    {
+        const QByteArray text = QJsonDocument(message).toJson(QJsonDocument::Compact);
+        emit messageReceived(QJsonDocument::fromJson(text).object(), this);
+    }
+
+    QJsonObject lastResponse;
+};
+
+int methodIndex(const QJsonObject &objectInfo, const QString &name)
+{
+    const QJsonArray methods = objectInfo.value(QStringLiteral("methods")).toArray();
+    for (const QJsonValue &method : methods) {
+        const QJsonArray entry = method.toArray();
+        if (entry.at(0).toString() == name) {
+            return entry.at(1).toInt();
+        }
+    }
+    return -1;
+}
+
+void channelRoundTrip(BenchmarkRunner &runner)
+{
+    BackendObject backend;
+    QWebChannel channel;
+    channel.registerObject(QStringLiteral("backend"), &backend);
+    if (AllocationTracker::isEnabled()) {
+        AllocationTracker::trackChannel(&channel);
+    }
+    LoopbackTransport transport;
+    channel.connectTo(&transport);
+
+    int id = 0;
+    auto call = [&transport, &id](const QJsonObject &message) {
+        QJsonObject request = message;
+        request.insert(QStringLiteral("id"), ++id);
+        transport.deliver(request);
+        return transport.lastResponse.value(QStringLiteral("id")).toInt() == id;
+    };
+
+    QJsonObject init;
+    init.insert(QStringLiteral("type"), 3);
+    if (!call(init)) {
+        runner.fail(QStringLiteral("no reply to the init message"));
+        return;
+    }
+    const QJsonObject backendInfo = transport.lastResponse.value(QStringLiteral("data")).toObject()
+                                        .value(QStringLiteral("backend")).toObject();
+    const int incrementIndex = methodIndex(backendInfo, QStringLiteral("incrementCount"));
+    const int sendIndex = methodIndex(backendInfo, QStringLiteral("sendToBackend"));
+    if (incrementIndex < 0 || sendIndex < 0) {
+        runner.fail(QStringLiteral("backend methods not found in the init reply"));
+        return;
+    }
+
+    bool ok = true;
+    runner.measure(QStringLiteral("init"), 2000, [&]() {
+        ok = call(init) && ok;
+    });
+
+    QJsonObject invoke;
+    invoke.insert(QStringLiteral("type"), 6);
+    invoke.insert(QStringLiteral("object"), QStringLiteral("backend"));
+    invoke.insert(QStringLiteral("method"), incrementIndex);
+    invoke.insert(QStringLiteral("args"), QJsonArray());
+    runner.measure(QStringLiteral("invoke"), 50000, [&]() {
+        ok = call(invoke) && ok;
+    });
+
+    invoke.insert(QStringLiteral("method"), sendIndex);
+    invoke.insert(QStringLiteral("args"), QJsonArray{QString(4096, QLatin1Char('x'))});
+    runner.measure(QStringLiteral("invoke-4kb-arg"), 20000, [&]() {
+        ok = call(invoke) && ok;
+    });
+
+    if (!ok) {
+        runner.fail(QStringLiteral("a call got no synchronous reply"));
+    }
+}
+
+void assetServe(BenchmarkRunner &runner, const QString &root)
+{
+    if (root.isEmpty()) {
+        runner.fail(QStringLiteral("needs a built frontend (not a dev server)"));
+        return;
+    }
+    QStringList files;
+    QDirIterator it(root, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext() && files.size() < kMaxAssetFiles) {
+        files << QDir(root).relativeFilePath(it.next());
+    }
+    if (files.isEmpty()) {
+        runner.fail(QString("no files in %1").arg(root));
+        return;
+    }
+    qint64 totalBytes = 0;
+    for (const QString &file : files) {
+        totalBytes += QFileInfo(QDir(root).filePath(file)).size();
+    }
+    runner.record(QStringLiteral("files"), QStringLiteral("count"), files.size());
+    runner.record(QStringLiteral("files"), QStringLiteral("meanBytes"), double(totalBytes) / files.size());
+
+    // Every file is in memory
+    AssetCache warmCache(root, 256 * 1024 * 1024);
+    for (const QString &file : files) {
+        warmCache.preload(file);
+    }
+    int next = 0;
+    bool ok = true;
+    runner.measure(QStringLiteral("warm"), 20000, [&]() {
+        bool loaded = false;
+        warmCache.load(files.at(next++ % files.size()), &loaded);
+        ok = ok && loaded;
+    });
+
+    // Nothing fits, so every load reads the file (from the OS page cache)
+    AssetCache coldCache(root, 0);
+    runner.measure(QStringLiteral("cold"), 2000, [&]() {
+        bool loaded = false;
+        coldCache.load(files.at(next++ % files.size()), &loaded);
+        ok = ok && loaded;
+    });
+
+    if (!ok) {
+        runner.fail(QStringLiteral("some assets could not be read"));
+    }
+}
+
+} // namespace
+
+void registerCoreBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment)
+{
+    runner.add(QStringLiteral("channel-roundtrip"),
+               QStringLiteral("backend calls through QWebChannel, serialized both ways"),
+               channelRoundTrip);
+    const QString root = environment.frontendRoot;
+    runner.add(QStringLiteral("asset-serve"),
+               QStringLiteral("asset cache reads for every file of the built frontend"),
+               [root](BenchmarkRunner &runner) {
+        assetServe(runner, root);
+    });
+}
@@ -0,0 +1,12 @@
+#ifndef COREBENCHMARKS_H
+#define COREBENCHMARKS_H
+
+class BenchmarkRunner;
+struct BenchmarkEnvironment;
+
+// channel-roundtrip  backend method calls through QWebChannel over an
+//                    in-process transport that serializes like the real one
+// asset-serve        reads from the taqyon://app asset cache, warm and cold
+void registerCoreBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment);
+
+#endif // COREBENCHMARKS_H
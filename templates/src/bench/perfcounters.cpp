@@ -0,0 +1,178 @@
+#include "perfcounters.h"
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+struct CounterConfig {
+    quint32 type;
+    quint64 config;
+};
+
+const CounterConfig kCounterConfigs[PerfCounters::CounterCount] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+};
+
+int openCounter(const CounterConfig &counter, bool excludeKernel)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = counter.type;
+    attr.config = counter.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = excludeKernel ? 1 : 0;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // This thread, any CPU
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+} // namespace
+
+double PerfCounters::Reading::ipc() const
+{
+    if (!valid[Cycles] || !valid[Instructions] || values[Cycles] <= 0) {
+        return 0;
+    }
+    return values[Instructions] / values[Cycles];
+}
+
+QJsonObject PerfCounters::Reading::toJson(double operations) const
+{
+    QJsonObject object;
+    const double divisor = operations > 0 ? operations : 1;
+    for (int i = 0; i < CounterCount; ++i) {
+        if (valid[i]) {
+            object.insert(counterName(static_cast<Counter>(i)) + QStringLiteral("PerOp"), values[i] / divisor);
+        }
+    }
+    if (valid[Cycles] && valid[Instructions]) {
+        object.insert(QStringLiteral("ipc"), ipc());
+    }
+    return object;
+}
+
+PerfCounters::PerfCounters()
+{
+    for (int i = 0; i < CounterCount; ++i) {
+        m_fds[i] = -1;
+    }
+#ifdef Q_OS_LINUX
+    int firstError = 0;
+    for (int i = 0; i < CounterCount; ++i) {
+        // Context switches are counted in the kernel, so excluding it would
+        // always read 0; without perf_event_paranoid <= 1 the counter is left out
+        m_fds[i] = openCounter(kCounterConfigs[i], kCounterConfigs[i].type == PERF_TYPE_HARDWARE);
+        if (m_fds[i] < 0 && firstError == 0) {
+            firstError = errno;
+        }
+    }
+    if (!isAvailable()) {
+        if (firstError == EACCES || firstError == EPERM) {
+            m_unavailableReason = QStringLiteral("not permitted; lower /proc/sys/kernel/perf_event_paranoid to 2 or less");
+        } else if (firstError == ENOSYS) {
+            m_unavailableReason = QStringLiteral("perf_event_open is not available (seccomp or container policy)");
+        } else {
+            m_unavailableReason = QString("perf_event_open failed: %1").arg(QString::fromLocal8Bit(strerror(firstError)));
+        }
+    }
+#else
+    m_unavailableReason = QStringLiteral("hardware counters are only supported on Linux");
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#ifdef Q_OS_LINUX
+    for (int fd : m_fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::isAvailable() const
+{
+    for (int fd : m_fds) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QStringList PerfCounters::availableCounters() const
+{
+    QStringList names;
+    for (int i = 0; i < CounterCount; ++i) {
+        if (m_fds[i] >= 0) {
+            names << counterName(static_cast<Counter>(i));
+        }
+    }
+    return names;
+}
+
+void PerfCounters::start()
+{
+#ifdef Q_OS_LINUX
+    for (int fd : m_fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfCounters::Reading PerfCounters::stop()
+{
+    Reading reading;
+#ifdef Q_OS_LINUX
+    for (int fd : m_fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (int i = 0; i < CounterCount; ++i) {
+        if (m_fds[i] < 0) {
+            continue;
+        }
+        quint64 data[3] = {}; // value, time enabled, time running
+        if (read(m_fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+            continue;
+        }
+        reading.values[i] = static_cast<double>(data[0]) * data[1] / data[2];
+        reading.valid[i] = true;
+    }
+#endif
+    return reading;
+}
+
+QString PerfCounters::counterName(Counter counter)
+{
+    switch (counter) {
+    case Cycles: return QStringLiteral("cycles");
+    case Instructions: return QStringLiteral("instructions");
+    case CacheMisses: return QStringLiteral("cacheMisses");
+    case BranchMisses: return QStringLiteral("branchMisses");
+    case ContextSwitches: return QStringLiteral("contextSwitches");
+    case CounterCount: break;
+    }
+    return QString();
+}
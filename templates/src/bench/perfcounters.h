@@ -0,0 +1,58 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+// Hardware and software performance counters for the calling thread, read
+// through Linux perf_event_open(2). Each counter is opened on its own, so a
+// machine that lacks one (VMs often have no cache-miss event) still reports
+// the others; with perf_event_paranoid > 2, on other platforms or in
+// containers without the syscall, nothing is available and benchmarks
+// report wall-clock time only.
+//
+// Counts are scaled by enabled/running time when the kernel multiplexes
+// counters.
+class PerfCounters
+{
+public:
+    enum Counter {
+        Cycles,
+        Instructions,
+        CacheMisses,
+        BranchMisses,
+        ContextSwitches,
+        CounterCount
+    };
+
+    struct Reading {
+        double values[CounterCount] = {};
+        bool valid[CounterCount] = {};
+
+        double ipc() const;
+        // Divides every count by the number of operations measured
+        QJsonObject toJson(double operations) const;
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    bool isAvailable() const;
+    QStringList availableCounters() const;
+    QString unavailableReason() const { return m_unavailableReason; }
+
+    void start();
+    Reading stop();
+
+    static QString counterName(Counter counter);
+
+private:
+    int m_fds[CounterCount];
+    QString m_unavailableReason;
+};
+
+#endif // PERFCOUNTERS_H
@@ -0,0 +1,255 @@
+#include "renderbenchmarks.h"
+#include "benchmarkrunner.h"
+#include "../app/mywebview.h"
+#include "../app/processmemory.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QMainWindow>
+#include <QScreen>
+#include <QTimer>
+#include <QVariant>
+#include <QWebEnginePage>
+#include <QWebEngineProfile>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int kScenarioMs = 5000;
+const int kLoadTimeoutMs = 30000;
+const int kResultTimeoutMs = 5000;
+const int kResizeIntervalMs = 16;
+
+// Runs one scenario for a fixed time and records the interval between
+// animation frames in window.__taqyonFrameBench. A frame that misses its
+// vsync delays the next requestAnimationFrame callback, so long intervals
+// are dropped frames. The fixtures are added to the page's body and removed
+// again, so the scenarios run on top of whatever the frontend shows.
+const char kScenarioScript[] = R"JS(
+(function (scenario, durationMs) {
+    var state = window.__taqyonFrameBench = { done: false, intervals: [] };
+    var root = document.createElement('div');
+    var style = document.createElement('style');
+    style.textContent =
+        '@keyframes taqyon-bench-move { from { transform: translateX(0) rotate(0deg); } to { transform: translateX(240px) rotate(360deg); } }' +
+        '@keyframes taqyon-bench-grow { from { width: 40px; } to { width: 220px; } }' +
+        '.taqyon-bench-box { display: inline-block; height: 24px; width: 80px; margin: 2px; border-radius: 6px;' +
+        ' background: linear-gradient(90deg, #36c, #c63); box-shadow: 0 2px 6px rgba(0, 0, 0, 0.4); }' +
+        '.taqyon-bench-row { margin: 0; padding: 8px; border-bottom: 1px solid #ccc; }' +
+        '.taqyon-bench-hot { background: #ffd; }';
+    document.head.appendChild(style);
+    document.body.appendChild(root);
+    var step = function () {};
+    var html = '';
+    var i;
+
+    if (scenario === 'scroll') {
+        for (i = 0; i < 2000; ++i) {
+            html += '<p class="taqyon-bench-row">Row ' + i + ' <b>bold</b> <i>italic</i> and a line of text long enough to wrap on narrow windows</p>';
+        }
+        root.innerHTML = html;
+        var direction = 1;
+        step = function () {
+            var end = document.documentElement.scrollHeight - window.innerHeight;
+            if (window.scrollY >= end) {
+                direction = -1;
+            } else if (window.scrollY <= 0) {
+                direction = 1;
+            }
+            window.scrollBy(0, 40 * direction);
+        };
+    } else if (scenario === 'animation') {
+        // Compositor-only transforms plus width changes that need layout
+        for (i = 0; i < 300; ++i) {
+            var name = i % 2 ? 'taqyon-bench-move' : 'taqyon-bench-grow';
+            html += '<span class="taqyon-bench-box" style="animation: ' + name + ' 1.5s ' + (i % 30) * 0.05 + 's infinite alternate"></span>';
+        }
+        root.innerHTML = html;
+    } else if (scenario === 'resize') {
+        // Wrapped boxes and text, laid out again at every size
+        for (i = 0; i < 600; ++i) {
+            html += '<span class="taqyon-bench-box"></span>';
+        }
+        for (i = 0; i < 200; ++i) {
+            html += '<p class="taqyon-bench-row">Paragraph ' + i + ' with enough text to wrap differently at every window width</p>';
+        }
+        root.innerHTML = html;
+    } else if (scenario === 'dom-update') {
+        // A 500 x 10 table; every frame rewrites 2000 cells and moves a highlight
+        html = '<table>';
+        for (i = 0; i < 500; ++i) {
+            html += '<tr>' + '<td>0</td>'.repeat(10) + '</tr>';
+        }
+        root.innerHTML = html + '</table>';
+        var cells = root.getElementsByTagName('td');
+        var rows = root.getElementsByTagName('tr');
+        var tick = 0;
+        step = function () {
+            ++tick;
+            for (var c = 0; c < 2000; ++c) {
+                cells[(tick * 2000 + c) % cells.length].textContent = String(tick * 31 + c);
+            }
+            rows[(tick - 1) % rows.length].className = '';
+            rows[tick % rows.length].className = 'taqyon-bench-hot';
+        };
+    }
+
+    var start = 0;
+    var last = 0;
+    function frame(now) {
+        if (!start) {
+            start = now;
+        } else {
+            state.intervals.push(now - last);
+        }
+        last = now;
+        if (now - start >= durationMs) {
+            root.remove();
+            style.remove();
+            window.scrollTo(0, 0);
+            state.done = true;
+            return;
+        }
+        step();
+        requestAnimationFrame(frame);
+    }
+    requestAnimationFrame(frame);
+    return true;
+})
+)JS";
+
+const char kResultScript[] =
+    "window.__taqyonFrameBench && window.__taqyonFrameBench.done ? window.__taqyonFrameBench.intervals : null";
+
+// Runs a script and waits for its result
+QVariant evaluate(QWebEnginePage *page, const QString &script)
+{
+    QVariant value;
+    bool done = false;
+    page->runJavaScript(script, [&value, &done](const QVariant &result) {
+        value = result;
+        done = true;
+    });
+    BenchmarkRunner::waitFor([&done]() { return done; }, kResultTimeoutMs);
+    return value;
+}
+
+double totalCpuTimeMs()
+{
+    const QString self = QString::number(QCoreApplication::applicationPid());
+    double total = qMax(0.0, processCpuTimeMs(self));
+    const QStringList children = descendantProcesses(self);
+    for (const QString &pid : children) {
+        total += qMax(0.0, processCpuTimeMs(pid));
+    }
+    return total;
+}
+
+void runScenario(BenchmarkRunner &runner, QMainWindow *window, MyWebView *view, const QString &scenario,
+                 double refreshIntervalMs)
+{
+    // The resize scenario sweeps the window between two sizes, one step per frame
+    QTimer resizeTimer;
+    int resizeStep = 0;
+    const QSize baseSize = window->size();
+    QObject::connect(&resizeTimer, &QTimer::timeout, window, [window, baseSize, &resizeStep]() {
+        const double phase = std::sin(++resizeStep * 0.1);
+        window->resize(baseSize.width() - int(std::abs(phase) * 400), baseSize.height() - int(std::abs(phase) * 200));
+    });
+
+    const double cpuBefore = totalCpuTimeMs();
+    const QString start = QString::fromLatin1(kScenarioScript)
+                          + QString("('%1', %2)").arg(scenario).arg(kScenarioMs);
+    if (!evaluate(view->page(), start).toBool()) {
+        runner.fail(QString("%1: the scenario did not start").arg(scenario));
+        return;
+    }
+    if (scenario == QLatin1String("resize")) {
+        resizeTimer.start(kResizeIntervalMs);
+    }
+
+    QVariant result;
+    BenchmarkRunner::waitFor([]() { return false; }, kScenarioMs);
+    BenchmarkRunner::waitFor([&result, view]() {
+        result = evaluate(view->page(), QString::fromLatin1(kResultScript));
+        return !result.isNull();
+    }, kResultTimeoutMs);
+    resizeTimer.stop();
+    window->resize(baseSize);
+    const double cpuMs = totalCpuTimeMs() - cpuBefore;
+
+    const QVariantList values = result.toList();
+    if (values.isEmpty()) {
+        runner.fail(QString("%1: no animation frames; is the page visible?").arg(scenario));
+        return;
+    }
+    QList<double> intervals;
+    double elapsedMs = 0;
+    double dropped = 0;
+    for (const QVariant &value : values) {
+        const double interval = value.toDouble();
+        intervals.append(interval);
+        elapsedMs += interval;
+        // Frames whose vsync passed without a new frame
+        dropped += qMax(0.0, std::round(interval / refreshIntervalMs) - 1);
+    }
+    std::sort(intervals.begin(), intervals.end());
+    const double frames = intervals.size();
+    runner.record(scenario, QStringLiteral("fps"), frames * 1000.0 / elapsedMs);
+    runner.record(scenario, QStringLiteral("droppedFrames"), dropped);
+    runner.record(scenario, QStringLiteral("droppedPercent"), dropped * 100.0 / (frames + dropped));
+    runner.record(scenario, QStringLiteral("p95FrameMs"), intervals.at(int(frames * 0.95)));
+    runner.record(scenario, QStringLiteral("maxFrameMs"), intervals.last());
+    runner.record(scenario, QStringLiteral("cpuMsPerFrame"), cpuMs / frames);
+}
+
+void renderFps(BenchmarkRunner &runner, const BenchmarkEnvironment &environment)
+{
+    const QByteArray flags = qgetenv("QTWEBENGINE_CHROMIUM_FLAGS");
+    qInfo().noquote() << "render-fps: Chromium flags:" << (flags.isEmpty() ? QByteArray("(none)") : flags);
+    runner.record(QStringLiteral("setup"), QStringLiteral("softwareRendering"), flags.contains("--disable-gpu") ? 1 : 0);
+
+    QMainWindow window;
+    window.resize(1280, 800);
+    MyWebView *view = new MyWebView(&window);
+    view->setPage(new QWebEnginePage(environment.profile, view));
+    window.setCentralWidget(view);
+    window.show();
+
+    const QUrl url = environment.frontendUrl.isValid() ? environment.frontendUrl : QUrl(QStringLiteral("about:blank"));
+    bool finished = false;
+    bool ok = false;
+    QObject::connect(view, &QWebEngineView::loadFinished, [&finished, &ok](bool result) {
+        finished = true;
+        ok = result;
+    });
+    view->setUrl(url);
+    BenchmarkRunner::waitFor([&finished]() { return finished; }, kLoadTimeoutMs);
+    if (!ok) {
+        runner.fail(QString("%1 did not load").arg(url.toString()));
+        return;
+    }
+    // Let the frontend finish its first render
+    BenchmarkRunner::waitFor([]() { return false; }, 1000);
+
+    const double refreshRate = window.screen() ? window.screen()->refreshRate() : 0;
+    const double refreshIntervalMs = 1000.0 / (refreshRate > 0 ? refreshRate : 60);
+    runner.record(QStringLiteral("setup"), QStringLiteral("refreshHz"), 1000.0 / refreshIntervalMs);
+
+    const QStringList scenarios = {QStringLiteral("scroll"), QStringLiteral("resize"),
+                                   QStringLiteral("animation"), QStringLiteral("dom-update")};
+    for (const QString &scenario : scenarios) {
+        runScenario(runner, &window, view, scenario, refreshIntervalMs);
+    }
+}
+
+} // namespace
+
+void registerRenderBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment)
+{
+    runner.add(QStringLiteral("render-fps"),
+               QStringLiteral("frame rate of scroll, resize, animation and DOM update scenarios"),
+               [environment](BenchmarkRunner &runner) {
+        renderFps(runner, environment);
+    });
+}
@@ -0,0 +1,14 @@
+#ifndef RENDERBENCHMARKS_H
+#define RENDERBENCHMARKS_H
+
+class BenchmarkRunner;
+struct BenchmarkEnvironment;
+
+// "render-fps": drives scroll, resize, animation and large DOM update
+// scenarios in a MyWebView showing the frontend, and reports frames per
+// second, dropped frames and CPU time per frame. Run with
+// --software-rendering to measure Chromium's software compositing, and set
+// QTWEBENGINE_CHROMIUM_FLAGS to compare other flags.
+void registerRenderBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment);
+
+#endif // RENDERBENCHMARKS_H
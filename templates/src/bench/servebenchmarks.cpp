@@ -0,0 +1,374 @@
+#include "servebenchmarks.h"
+#include "benchmarkrunner.h"
+#include "../app/assetcache.h"
+#include "../app/processmemory.h"
+#include "../app/taqyonscheme.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLibraryInfo>
+#include <QProcess>
+#include <QResource>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QVariant>
+#include <QWebEnginePage>
+#include <QWebEngineProfile>
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Shaped like a Vite build without code splitting: many small modules and a
+// few large vendor chunks
+const int kSmallScripts = 400;
+const int kSmallScriptBytes = 2 * 1024;
+const int kLargeChunks = 3;
+const int kLargeChunkBytes = 800 * 1024;
+
+const int kColdLoads = 3;
+const int kWarmLoads = 5;
+const int kLoadTimeoutMs = 30000;
+
+const char kResourceRoot[] = "/taqyon-bench";
+const char kSchemeHost[] = "bench";
+
+// Durations of every subresource the page requested, in milliseconds
+const char kResourceTimingScript[] =
+    "performance.getEntriesByType('resource').map(function (entry) { return entry.duration; })";
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size();
+}
+
+// Writes the bundle under `root` and returns its files relative to it. The
+// scripts are classic deferred scripts rather than ES modules, because
+// Chromium refuses module scripts from file:// URLs.
+QStringList generateBundle(const QString &root)
+{
+    QStringList files;
+    if (!QDir(root).mkpath(QStringLiteral("assets"))) {
+        return files;
+    }
+
+    QByteArray html = "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n<title>serve-strategy</title>\n"
+                      // The default buffer of 250 entries would drop most of the requests
+                      "<script>performance.setResourceTimingBufferSize(4096);</script>\n"
+                      "<link rel=\"stylesheet\" href=\"assets/style.css\">\n";
+
+    QByteArray css;
+    for (int i = 0; css.size() < 64 * 1024; ++i) {
+        css += QString(".item-%1 { margin: %2px; padding: %3px; color: #%4; }\n")
+                   .arg(i).arg(i % 16).arg(i % 8).arg(i % 0xfff, 3, 16, QLatin1Char('0')).toUtf8();
+    }
+    if (!writeFile(QDir(root).filePath(QStringLiteral("assets/style.css")), css)) {
+        return QStringList();
+    }
+    files << QStringLiteral("assets/style.css");
+
+    for (int i = 0; i < kSmallScripts; ++i) {
+        QByteArray script = QString("window.benchModules = (window.benchModules || 0) + 1;\n"
+                                    "function module%1(values) {\n"
+                                    "  return values.map(function (value) { return value * %1 + 1; });\n"
+                                    "}\n").arg(i).toUtf8();
+        script += QString("var moduleData%1 = \"").arg(i).toUtf8();
+        script += QByteArray(qMax(0, kSmallScriptBytes - int(script.size()) - 3), 'a');
+        script += "\";\n";
+        const QString file = QString("assets/module-%1.js").arg(i, 3, 10, QLatin1Char('0'));
+        if (!writeFile(QDir(root).filePath(file), script)) {
+            return QStringList();
+        }
+        files << file;
+        html += "<script defer src=\"" + file.toUtf8() + "\"></script>\n";
+    }
+
+    for (int i = 0; i < kLargeChunks; ++i) {
+        QByteArray script = QString("window.benchChunk%1 = [").arg(i).toUtf8();
+        for (int item = 0; script.size() < kLargeChunkBytes; ++item) {
+            script += QString("\"chunk-%1-item-%2\",").arg(i).arg(item).toUtf8();
+        }
+        script += "\"\"];\n";
+        const QString file = QString("assets/vendor-%1.js").arg(i);
+        if (!writeFile(QDir(root).filePath(file), script)) {
+            return QStringList();
+        }
+        files << file;
+        html += "<script defer src=\"" + file.toUtf8() + "\"></script>\n";
+    }
+
+    html += "</head>\n<body>\n<div id=\"app\"></div>\n</body>\n</html>\n";
+    if (!writeFile(QDir(root).filePath(QStringLiteral("index.html")), html)) {
+        return QStringList();
+    }
+    files.prepend(QStringLiteral("index.html"));
+    return files;
+}
+
+// Evicts the files from the OS page cache, so the next read goes to disk.
+// Clean pages can be dropped without root.
+void dropFromPageCache(const QStringList &paths)
+{
+#ifdef Q_OS_LINUX
+    for (const QString &path : paths) {
+        const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+        if (fd >= 0) {
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+    }
+#else
+    Q_UNUSED(paths);
+#endif
+}
+
+QString findRcc()
+{
+    const QStringList candidates = {
+        QLibraryInfo::path(QLibraryInfo::LibraryExecutablesPath) + QStringLiteral("/rcc"),
+        QLibraryInfo::path(QLibraryInfo::BinariesPath) + QStringLiteral("/rcc"),
+    };
+    for (const QString &candidate : candidates) {
+        if (QFileInfo(candidate).isExecutable()) {
+            return candidate;
+        }
+    }
+    return QStandardPaths::findExecutable(QStringLiteral("rcc"));
+}
+
+// Compiles the bundle into a binary resource file, compressed the way rcc
+// compresses resources that are built into the app
+QString buildResourceFile(const QString &root, const QStringList &files, QString *error)
+{
+    const QString rcc = findRcc();
+    if (rcc.isEmpty()) {
+        *error = QStringLiteral("rcc not found next to Qt or on PATH");
+        return QString();
+    }
+    QByteArray qrc = "<RCC>\n<qresource prefix=\"/\">\n";
+    for (const QString &file : files) {
+        qrc += "<file>" + file.toUtf8() + "</file>\n";
+    }
+    qrc += "</qresource>\n</RCC>\n";
+    const QString qrcPath = QDir(root).filePath(QStringLiteral("bundle.qrc"));
+    const QString rccPath = QDir(root).filePath(QStringLiteral("../bundle.rcc"));
+    if (!writeFile(qrcPath, qrc)) {
+        *error = QStringLiteral("could not write ") + qrcPath;
+        return QString();
+    }
+    QProcess process;
+    process.setWorkingDirectory(root);
+    process.start(rcc, {QStringLiteral("--binary"), QStringLiteral("-o"), rccPath, qrcPath});
+    if (!process.waitForFinished(120000) || process.exitStatus() != QProcess::NormalExit
+        || process.exitCode() != 0) {
+        *error = QStringLiteral("rcc failed: ") + QString::fromLocal8Bit(process.readAllStandardError()).trimmed();
+        return QString();
+    }
+    return QFileInfo(rccPath).absoluteFilePath();
+}
+
+double childCpuTimeMs()
+{
+    double total = 0;
+    const QStringList children = descendantProcesses(QString::number(QCoreApplication::applicationPid()));
+    for (const QString &pid : children) {
+        total += qMax(0.0, processCpuTimeMs(pid));
+    }
+    return total;
+}
+
+struct LoadSample {
+    bool ok = false;
+    double loadMs = 0;
+    QList<double> requestMs;
+    double appCpuMs = 0;
+    double childCpuMs = 0;
+};
+
+// Loads the URL in a fresh page, so nothing is reused from a previous
+// document besides the renderer process and the OS page cache
+LoadSample loadOnce(QWebEngineProfile *profile, const QUrl &url)
+{
+    LoadSample sample;
+    QWebEnginePage page(profile);
+    const QString self = QString::number(QCoreApplication::applicationPid());
+    const double appBefore = processCpuTimeMs(self);
+    const double childBefore = childCpuTimeMs();
+
+    bool finished = false;
+    QElapsedTimer timer;
+    QObject::connect(&page, &QWebEnginePage::loadFinished, [&](bool ok) {
+        sample.loadMs = timer.nsecsElapsed() / 1e6;
+        sample.ok = ok;
+        finished = true;
+    });
+    timer.start();
+    page.load(url);
+    BenchmarkRunner::waitFor([&finished]() { return finished; }, kLoadTimeoutMs);
+    sample.appCpuMs = processCpuTimeMs(self) - appBefore;
+    sample.childCpuMs = childCpuTimeMs() - childBefore;
+    if (!sample.ok) {
+        return sample;
+    }
+
+    bool timed = false;
+    page.runJavaScript(QString::fromLatin1(kResourceTimingScript), [&](const QVariant &result) {
+        const QVariantList durations = result.toList();
+        for (const QVariant &duration : durations) {
+            sample.requestMs.append(duration.toDouble());
+        }
+        timed = true;
+    });
+    BenchmarkRunner::waitFor([&timed]() { return timed; }, kLoadTimeoutMs);
+    return sample;
+}
+
+void recordLoads(BenchmarkRunner &runner, const QString &operation, const QList<LoadSample> &samples)
+{
+    double loadMs = 0;
+    double minLoadMs = samples.first().loadMs;
+    double appCpuMs = 0;
+    double childCpuMs = 0;
+    QList<double> requests;
+    for (const LoadSample &sample : samples) {
+        loadMs += sample.loadMs;
+        minLoadMs = qMin(minLoadMs, sample.loadMs);
+        appCpuMs += sample.appCpuMs;
+        childCpuMs += sample.childCpuMs;
+        requests += sample.requestMs;
+    }
+    const int count = samples.size();
+    runner.record(operation, QStringLiteral("loadMs"), loadMs / count);
+    runner.record(operation, QStringLiteral("minLoadMs"), minLoadMs);
+    runner.record(operation, QStringLiteral("appCpuMs"), appCpuMs / count);
+    runner.record(operation, QStringLiteral("rendererCpuMs"), childCpuMs / count);
+    if (!requests.isEmpty()) {
+        std::sort(requests.begin(), requests.end());
+        double total = 0;
+        for (double request : requests) {
+            total += request;
+        }
+        runner.record(operation, QStringLiteral("requests"), double(requests.size()) / count);
+        runner.record(operation, QStringLiteral("requestMeanMs"), total / requests.size());
+        runner.record(operation, QStringLiteral("requestP95Ms"), requests.at(int(requests.size() * 0.95)));
+    }
+}
+
+struct Strategy {
+    QString name;
+    QUrl url;
+    std::function<void()> makeCold;
+};
+
+void serveStrategy(BenchmarkRunner &runner, const BenchmarkEnvironment &environment)
+{
+    QTemporaryDir temporaryDir;
+    const QString root = temporaryDir.filePath(QStringLiteral("bundle"));
+    const QStringList files = generateBundle(root);
+    if (!temporaryDir.isValid() || files.isEmpty()) {
+        runner.fail(QStringLiteral("could not write the bundle"));
+        return;
+    }
+    QStringList paths;
+    qint64 bytes = 0;
+    for (const QString &file : files) {
+        paths << QDir(root).filePath(file);
+        bytes += QFileInfo(paths.last()).size();
+    }
+    runner.record(QStringLiteral("bundle"), QStringLiteral("files"), files.size());
+    runner.record(QStringLiteral("bundle"), QStringLiteral("kilobytes"), bytes / 1024.0);
+
+    QList<Strategy> strategies;
+    strategies.append({QStringLiteral("file"), QUrl::fromLocalFile(QDir(root).filePath(QStringLiteral("index.html"))),
+                       [paths]() { dropFromPageCache(paths); }});
+
+    QString error;
+    const QString resourceFile = buildResourceFile(root, files, &error);
+    const QString resourceRoot = QString::fromLatin1(kResourceRoot);
+    if (resourceFile.isEmpty()) {
+        qWarning().noquote() << "serve-strategy: skipping qrc:" << error;
+    } else if (QResource::registerResource(resourceFile, resourceRoot)) {
+        strategies.append({QStringLiteral("qrc"), QUrl(QStringLiteral("qrc:") + resourceRoot + QStringLiteral("/index.html")),
+                           [resourceFile, resourceRoot]() {
+            // A registered resource file stays mapped, so map it again
+            QResource::unregisterResource(resourceFile, resourceRoot);
+            dropFromPageCache({resourceFile});
+            QResource::registerResource(resourceFile, resourceRoot);
+        }});
+    } else {
+        qWarning().noquote() << "serve-strategy: skipping qrc: could not register" << resourceFile;
+    }
+
+    // The in-memory asset cache is part of the taqyon:// strategy, so a cold
+    // load also starts with an empty one
+    auto assetCache = std::make_shared<std::unique_ptr<AssetCache>>();
+    const QString host = QString::fromLatin1(kSchemeHost);
+    if (environment.schemeHandler) {
+        environment.schemeHandler->addHost(host, [assetCache](QWebEngineUrlRequestJob *job) {
+            (*assetCache)->handleRequest(job);
+        });
+        strategies.append({QStringLiteral("taqyon"), QUrl(QStringLiteral("taqyon://") + host + QStringLiteral("/index.html")),
+                           [assetCache, paths, root]() {
+            assetCache->reset(new AssetCache(root));
+            dropFromPageCache(paths);
+        }});
+    }
+
+    for (const Strategy &strategy : strategies) {
+        QList<LoadSample> cold;
+        for (int i = 0; i < kColdLoads; ++i) {
+            strategy.makeCold();
+            cold.append(loadOnce(environment.profile, strategy.url));
+            if (!cold.last().ok) {
+                break;
+            }
+        }
+        if (!cold.last().ok) {
+            runner.fail(QString("%1 did not load").arg(strategy.url.toString()));
+            continue;
+        }
+        recordLoads(runner, strategy.name + QStringLiteral("/cold"), cold);
+
+        // The last cold load has filled every cache
+        QList<LoadSample> warm;
+        for (int i = 0; i < kWarmLoads; ++i) {
+            warm.append(loadOnce(environment.profile, strategy.url));
+            if (!warm.last().ok) {
+                break;
+            }
+        }
+        if (!warm.last().ok) {
+            runner.fail(QString("%1 did not load again").arg(strategy.url.toString()));
+            continue;
+        }
+        recordLoads(runner, strategy.name + QStringLiteral("/warm"), warm);
+    }
+
+    if (environment.schemeHandler) {
+        environment.schemeHandler->removeHost(host);
+    }
+    if (!resourceFile.isEmpty()) {
+        QResource::unregisterResource(resourceFile, resourceRoot);
+    }
+}
+
+} // namespace
+
+void registerServeBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment)
+{
+    runner.add(QStringLiteral("serve-strategy"),
+               QStringLiteral("page loads of a generated bundle from file://, qrc:/ and taqyon://"),
+               [environment](BenchmarkRunner &runner) {
+        serveStrategy(runner, environment);
+    });
+}
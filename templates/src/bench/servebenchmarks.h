@@ -0,0 +1,14 @@
+#ifndef SERVEBENCHMARKS_H
+#define SERVEBENCHMARKS_H
+
+class BenchmarkRunner;
+struct BenchmarkEnvironment;
+
+// "serve-strategy": loads one generated bundle (hundreds of small scripts
+// plus a few large chunks) from file://, from Qt resources (qrc:/) and from
+// the taqyon:// scheme, each with a cold and a warm OS page cache. Reports
+// the time to loadFinished, the page's per-request latency from Resource
+// Timing and the CPU time of the app and renderer processes per load.
+void registerServeBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment);
+
+#endif // SERVEBENCHMARKS_H
@@ -0,0 +1,183 @@
+#include "windowbenchmarks.h"
+#include "benchmarkrunner.h"
+#include "../app/allocationtracker.h"
+#include "../app/mywebview.h"
+#include "../app/processmemory.h"
+#include "../backend/backendobject.h"
+#include <QList>
+#include <QMainWindow>
+#include <QWebChannel>
+#include <QWebEnginePage>
+#include <QWebEngineProfile>
+#include <QVector>
+
+namespace {
+
+// Long enough for the renderer to finish its first layout and for
+// PartitionAlloc to settle after the load
+const int kSettleMs = 2000;
+const int kLoadTimeoutMs = 30000;
+const int kProcessExitTimeoutMs = 10000;
+
+enum class WindowMode {
+    SharedProfile,
+    ProfilePerWindow,
+    PrewarmedPool
+};
+
+struct BenchmarkWindow {
+    QMainWindow *window = nullptr;
+    MyWebView *view = nullptr;
+    QWebChannel *channel = nullptr;
+    QWebEngineProfile *ownProfile = nullptr;
+};
+
+void settle()
+{
+    BenchmarkRunner::waitFor([]() { return false; }, kSettleMs);
+}
+
+bool load(QWebEngineView *view, const QUrl &url)
+{
+    bool finished = false;
+    bool ok = false;
+    const QMetaObject::Connection connection = QObject::connect(view, &QWebEngineView::loadFinished,
+                                                                [&finished, &ok](bool result) {
+        finished = true;
+        ok = result;
+    });
+    view->setUrl(url);
+    BenchmarkRunner::waitFor([&finished]() { return finished; }, kLoadTimeoutMs);
+    QObject::disconnect(connection);
+    return ok;
+}
+
+// The same setup as the main window: a page with its own channel publishing
+// the shared backend
+BenchmarkWindow createWindow(QWebEngineProfile *sharedProfile, bool ownProfile, BackendObject *backend)
+{
+    BenchmarkWindow window;
+    window.window = new QMainWindow;
+    window.window->resize(1024, 768);
+    window.view = new MyWebView(window.window);
+    window.window->setCentralWidget(window.view);
+    QWebEngineProfile *profile = sharedProfile;
+    if (ownProfile) {
+        window.ownProfile = new QWebEngineProfile; // Off the record
+        profile = window.ownProfile;
+    }
+    window.view->setPage(new QWebEnginePage(profile, window.view));
+    window.channel = new QWebChannel(window.view);
+    window.channel->registerObject(QStringLiteral("backend"), backend);
+    window.view->page()->setWebChannel(window.channel);
+    return window;
+}
+
+void closeWindows(QList<BenchmarkWindow> &windows, int childProcesses)
+{
+    for (const BenchmarkWindow &window : windows) {
+        delete window.window;
+    }
+    // Profiles go after their pages
+    for (const BenchmarkWindow &window : windows) {
+        delete window.ownProfile;
+    }
+    windows.clear();
+    BenchmarkRunner::waitFor([childProcesses]() {
+        return sampleProcessTreeMemory().childProcesses <= childProcesses;
+    }, kProcessExitTimeoutMs);
+}
+
+void windowMemory(BenchmarkRunner &runner, const BenchmarkEnvironment &environment, WindowMode mode,
+                  const QString &name)
+{
+    const int count = qMax(1, environment.windowCount);
+    BackendObject backend;
+    QList<BenchmarkWindow> windows;
+
+    settle();
+    ProcessTreeMemory baseline = sampleProcessTreeMemory();
+    const int baselineProcesses = baseline.childProcesses;
+    if (baseline.totalPssKb() < 0) {
+        runner.fail(QStringLiteral("needs PSS from /proc/<pid>/smaps_rollup (Linux 4.14+)"));
+        return;
+    }
+
+    if (mode == WindowMode::PrewarmedPool) {
+        // Views that have started a renderer on a blank page, ready to navigate
+        for (int i = 0; i < count; ++i) {
+            windows.append(createWindow(environment.profile, false, &backend));
+            load(windows.last().view, QUrl(QStringLiteral("about:blank")));
+        }
+        settle();
+        const ProcessTreeMemory pool = sampleProcessTreeMemory();
+        runner.record(name + QStringLiteral("/pool"), QStringLiteral("idleKbPerView"),
+                      (pool.totalPssKb() - baseline.totalPssKb()) / count);
+        baseline = pool;
+    }
+
+    const AllocationTracker::Counters allocationsBefore = AllocationTracker::currentThread();
+    ProcessTreeMemory previous = baseline;
+    QVector<double> marginals;
+    for (int i = 0; i < count; ++i) {
+        if (mode != WindowMode::PrewarmedPool) {
+            windows.append(createWindow(environment.profile, mode == WindowMode::ProfilePerWindow, &backend));
+        }
+        BenchmarkWindow &window = windows[i];
+        window.window->show();
+        if (!load(window.view, environment.frontendUrl)) {
+            runner.fail(QString("window %1 did not load %2").arg(i + 1).arg(environment.frontendUrl.toString()));
+            break;
+        }
+        settle();
+
+        const ProcessTreeMemory current = sampleProcessTreeMemory();
+        const double marginal = current.totalPssKb() - previous.totalPssKb();
+        marginals.append(marginal);
+        const QString step = QString("%1/%2").arg(name).arg(i + 1, 2, 10, QLatin1Char('0'));
+        runner.record(step, QStringLiteral("totalPssKb"), current.totalPssKb());
+        runner.record(step, QStringLiteral("marginalPssKb"), marginal);
+        runner.record(step, QStringLiteral("appMarginalPssKb"), current.self.pssKb - previous.self.pssKb);
+        runner.record(step, QStringLiteral("childMarginalPssKb"), current.childPssKb - previous.childPssKb);
+        runner.record(step, QStringLiteral("childProcesses"), current.childProcesses);
+        previous = current;
+    }
+
+    if (!marginals.isEmpty()) {
+        runner.record(name, QStringLiteral("firstWindowKb"), marginals.first());
+        double later = 0;
+        for (int i = 1; i < marginals.size(); ++i) {
+            later += marginals.at(i);
+        }
+        if (marginals.size() > 1) {
+            runner.record(name, QStringLiteral("meanAdditionalWindowKb"), later / (marginals.size() - 1));
+        }
+        runner.record(name, QStringLiteral("totalKb"), previous.totalPssKb() - baseline.totalPssKb());
+        if (AllocationTracker::isEnabled()) {
+            // Backend-side state per window: pages, channels and publishers
+            const AllocationTracker::Counters allocationsAfter = AllocationTracker::currentThread();
+            const double netBytes = double(allocationsAfter.bytes - allocationsBefore.bytes)
+                                    - double(allocationsAfter.freedBytes - allocationsBefore.freedBytes);
+            runner.record(name, QStringLiteral("guiThreadNetKbPerWindow"), netBytes / 1024 / marginals.size());
+        }
+    }
+
+    closeWindows(windows, baselineProcesses);
+}
+
+} // namespace
+
+void registerWindowBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment)
+{
+    runner.add(QStringLiteral("window-memory"),
+               QString("PSS of 1..%1 windows showing the frontend, three ways").arg(environment.windowCount),
+               [environment](BenchmarkRunner &runner) {
+        if (!environment.frontendUrl.isValid()) {
+            runner.fail(QStringLiteral("no frontend to load"));
+            return;
+        }
+        windowMemory(runner, environment, WindowMode::SharedProfile, QStringLiteral("shared-profile"));
+        windowMemory(runner, environment, WindowMode::ProfilePerWindow, QStringLiteral("profile-per-window"));
+        windowMemory(runner, environment, WindowMode::PrewarmedPool, QStringLiteral("prewarmed-pool"));
+    });
+}
@@ -0,0 +1,13 @@
+#ifndef WINDOWBENCHMARKS_H
+#define WINDOWBENCHMARKS_H
+
+class BenchmarkRunner;
+struct BenchmarkEnvironment;
+
+// window-memory  marginal memory cost of each additional window showing the
+//                frontend, across the app and all QtWebEngine processes:
+//                with one shared profile, a profile per window, and views
+//                taken from a prewarmed pool
+void registerWindowBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment);
+
+#endif // WINDOWBENCHMARKS_H
@@ -0,0 +1,25 @@
+#include "exampleplugin.h"
+
+ExampleService::ExampleService(QObject *parent)
+    : QObject(parent), m_calls(0) {}
+
+int ExampleService::calls() const {
+    return m_calls;
+}
+
+QVariantMap ExampleService::saveState() const {
+    return {{"calls", m_calls}};
+}
+
+void ExampleService::restoreState(const QVariantMap &state) {
+    m_calls = state.value("calls").toInt();
+}
+
+QString ExampleService::greet(const QString &name) {
+    emit callsChanged(++m_calls);
+    return QString("Hello %1, from a plugin").arg(name);
+}
+
+QObject *ExamplePlugin::createBackendObject(QObject *parent) {
+    return new ExampleService(parent);
+}
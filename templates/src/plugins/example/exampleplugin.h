@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QObject>
+#include <QVariantMap>
+#include "../../backend/backendplugin.h"
+
+// The service object: published to the page as the result of
+// loadPlugin('example')
+class ExampleService : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(int calls READ calls NOTIFY callsChanged)
+public:
+    explicit ExampleService(QObject *parent = nullptr);
+
+    int calls() const;
+
+    // Carried over when the plugin is hot-reloaded; without these, stored
+    // writable properties are
+    Q_INVOKABLE QVariantMap saveState() const;
+    Q_INVOKABLE void restoreState(const QVariantMap &state);
+
+public slots:
+    QString greet(const QString &name);
+
+signals:
+    void callsChanged(int calls);
+
+private:
+    int m_calls;
+};
+
+class ExamplePlugin : public QObject, public BackendPluginInterface {
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID BackendPluginInterface_iid FILE "exampleplugin.json")
+    Q_INTERFACES(BackendPluginInterface)
+public:
+    QObject *createBackendObject(QObject *parent) override;
+};